@@ -20,18 +20,27 @@
 #include <cstdint>
 #include <limits>
 #include <map>
+#include <string>
+#include <vector>
 #include "C_error.hpp"
 
 namespace codeg
 {
 
 using BitSize = uint8_t;
+using BusIndex = std::size_t;
+
+constexpr uint64_t GetBusMask(codeg::BitSize bitSize)
+{
+    return (bitSize >= sizeof(uint64_t)*8) ? std::numeric_limits<uint64_t>::max() : ~(std::numeric_limits<uint64_t>::max()<<bitSize);
+}
 
 class Bus
 {
 public:
     explicit Bus(codeg::BitSize bitSize) :
             g_bus(0),
+            g_mask(codeg::GetBusMask(bitSize)),
             g_bitSize(bitSize)
     {
         if ( (bitSize == 0) || (bitSize > sizeof(uint64_t)*8) )
@@ -40,7 +49,8 @@ public:
         }
     }
     explicit Bus(codeg::BitSize bitSize, uint64_t value) :
-            g_bus(value & ~(std::numeric_limits<uint64_t>::max()<<bitSize)),
+            g_bus(value & codeg::GetBusMask(bitSize)),
+            g_mask(codeg::GetBusMask(bitSize)),
             g_bitSize(bitSize)
     {
         if ( (bitSize == 0) || (bitSize > sizeof(uint64_t)*8) )
@@ -48,11 +58,12 @@ public:
             throw codeg::Error("bitSize can't be 0 or > 64");
         }
     }
+    Bus(const codeg::Bus& r) = default;
     ~Bus() = default;
 
     codeg::Bus& operator =(const codeg::Bus& r)
     {
-        this->g_bus = r.get() & ~(std::numeric_limits<uint64_t>::max()<<this->g_bitSize);
+        this->g_bus = r.get() & this->g_mask;
         return *this;
     }
 
@@ -63,21 +74,30 @@ public:
 
     void set(uint64_t value)
     {
-        this->g_bus = value & ~(std::numeric_limits<uint64_t>::max()<<this->g_bitSize);
+        this->g_bus = value & this->g_mask;
     }
     [[nodiscard]] uint64_t get() const
     {
         return this->g_bus;
     }
+    //Raw storage written by the native code of the NativeBlockEngine, a written value must already be masked
+    [[nodiscard]] uint64_t* getData()
+    {
+        return &this->g_bus;
+    }
 
 private:
     uint64_t g_bus;
+    uint64_t g_mask;
     codeg::BitSize g_bitSize;
 };
 
+//Busses are kept in insertion order, the index of a bus can be resolved once and used instead of the name
 class BusMap
 {
 public:
+    using Container = std::vector<std::pair<std::string, codeg::Bus> >;
+
     BusMap() = default;
     ~BusMap() = default;
 
@@ -89,46 +109,62 @@ public:
     template<class... Types>
     bool add(const std::string& key, Types... args)
     {
-        return this->g_data.emplace( std::make_pair(key, args...) ).second;
+        if ( this->exist(key) )
+        {
+            return false;
+        }
+        this->g_names.emplace(key, this->g_data.size());
+        this->g_data.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(args...));
+        return true;
     }
 
     [[nodiscard]] bool exist(const std::string& key) const
     {
-        return this->g_data.find(key) != this->g_data.cend();
+        return this->g_names.find(key) != this->g_names.cend();
     }
 
-    [[nodiscard]] const codeg::Bus& get(const std::string& key) const
+    [[nodiscard]] codeg::BusIndex getIndex(const std::string& key) const
     {
-        auto it = this->g_data.find(key);
+        auto it = this->g_names.find(key);
 
-        if (it != this->g_data.cend())
+        if (it != this->g_names.cend())
         {
             return it->second;
         }
         throw codeg::Error("Unknown bus : "+key);
     }
+
+    [[nodiscard]] const codeg::Bus& get(const std::string& key) const
+    {
+        return this->g_data[this->getIndex(key)].second;
+    }
     [[nodiscard]] codeg::Bus& get(const std::string& key)
     {
-        auto it = this->g_data.find(key);
+        return this->g_data[this->getIndex(key)].second;
+    }
 
-        if (it != this->g_data.cend())
-        {
-            return it->second;
-        }
-        throw codeg::Error("Unknown bus : "+key);
+    //No range check, the index must come from getIndex() or from a fixed bus layout
+    [[nodiscard]] const codeg::Bus& get(codeg::BusIndex index) const
+    {
+        return this->g_data[index].second;
+    }
+    [[nodiscard]] codeg::Bus& get(codeg::BusIndex index)
+    {
+        return this->g_data[index].second;
     }
 
-    [[nodiscard]] std::map<std::string, codeg::Bus>::const_iterator begin() const
+    [[nodiscard]] Container::const_iterator begin() const
     {
         return this->g_data.cbegin();
     }
-    [[nodiscard]] std::map<std::string, codeg::Bus>::const_iterator end() const
+    [[nodiscard]] Container::const_iterator end() const
     {
         return this->g_data.cend();
     }
 
 private:
-    std::map<std::string, codeg::Bus> g_data;
+    Container g_data;
+    std::map<std::string, codeg::BusIndex> g_names;
 };
 
 }//end codeg
@@ -78,6 +78,78 @@ enum class CodegBinaryRev1Busses : uint8_t
     READABLE_EXT2 = 0xE0
 };
 
+//Names used by the .rcg disassembly
+constexpr const char* OpcodeToString(codeg::CodegBinaryRev1 opcode)
+{
+    switch (opcode)
+    {
+    case CodegBinaryRev1::OPCODE_BWRITE1_CLK:
+        return "BWRITE1_CLK";
+    case CodegBinaryRev1::OPCODE_BWRITE2_CLK:
+        return "BWRITE2_CLK";
+    case CodegBinaryRev1::OPCODE_BPCS_CLK:
+        return "BPCS_CLK";
+    case CodegBinaryRev1::OPCODE_OPLEFT_CLK:
+        return "OPLEFT_CLK";
+    case CodegBinaryRev1::OPCODE_OPRIGHT_CLK:
+        return "OPRIGHT_CLK";
+    case CodegBinaryRev1::OPCODE_OPCHOOSE_CLK:
+        return "OPCHOOSE_CLK";
+    case CodegBinaryRev1::OPCODE_PERIPHERAL_CLK:
+        return "PERIPHERAL_CLK";
+    case CodegBinaryRev1::OPCODE_BJMPSRC1_CLK:
+        return "BJMPSRC1_CLK";
+    case CodegBinaryRev1::OPCODE_BJMPSRC2_CLK:
+        return "BJMPSRC2_CLK";
+    case CodegBinaryRev1::OPCODE_BJMPSRC3_CLK:
+        return "BJMPSRC3_CLK";
+    case CodegBinaryRev1::OPCODE_JMPSRC_CLK:
+        return "JMPSRC_CLK";
+    case CodegBinaryRev1::OPCODE_BRAMADD1_CLK:
+        return "BRAMADD1_CLK";
+    case CodegBinaryRev1::OPCODE_BRAMADD2_CLK:
+        return "BRAMADD2_CLK";
+    case CodegBinaryRev1::OPCODE_SPI_CLK:
+        return "SPI_CLK";
+    case CodegBinaryRev1::OPCODE_BCFG_SPI_CLK:
+        return "BCFG_SPI_CLK";
+    case CodegBinaryRev1::OPCODE_STICK:
+        return "STICK";
+    case CodegBinaryRev1::OPCODE_IF:
+        return "IF";
+    case CodegBinaryRev1::OPCODE_IFNOT:
+        return "IFNOT";
+    case CodegBinaryRev1::OPCODE_RAMW:
+        return "RAMW";
+    case CodegBinaryRev1::OPCODE_LTICK:
+        return "LTICK";
+    }
+    return "UNKNOWN";
+}
+constexpr const char* BusToString(codeg::CodegBinaryRev1Busses bus)
+{
+    switch (bus)
+    {
+    case CodegBinaryRev1Busses::READABLE_SOURCE:
+        return "SOURCE";
+    case CodegBinaryRev1Busses::READABLE_BREAD1:
+        return "BREAD1";
+    case CodegBinaryRev1Busses::READABLE_BREAD2:
+        return "BREAD2";
+    case CodegBinaryRev1Busses::READABLE_RESULT:
+        return "RESULT";
+    case CodegBinaryRev1Busses::READABLE_RAM:
+        return "RAM";
+    case CodegBinaryRev1Busses::READABLE_SPI:
+        return "SPI";
+    case CodegBinaryRev1Busses::READABLE_EXT1:
+        return "EXT1";
+    case CodegBinaryRev1Busses::READABLE_EXT2:
+        return "EXT2";
+    }
+    return "UNKNOWN";
+}
+
 }//end codeg
 
 #endif // C_CODEG_HPP_INCLUDED
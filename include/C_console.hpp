@@ -20,8 +20,9 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
-#include <ctime>
-#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
 
 #define ConsoleNone *codeg::varConsole
 
@@ -45,6 +46,11 @@ enum ConsoleOutputType
     OUTPUT_INFO
 };
 
+/*
+ * The console can be used from multiple threads, every thread build its line separately
+ * and the complete line is written with std::endl.
+ * A console can also write its lines with a prefix into another console, so every simulated board can have its own.
+ */
 class Console
 {
 public:
@@ -52,6 +58,8 @@ public:
     using Traits = std::char_traits<CharT>;
 
     Console() = default;
+    //The output console must outlive this one
+    Console(codeg::Console& output, std::string prefix);
     ~Console() = default;
 
     bool logOpen(const std::filesystem::path& path);
@@ -61,11 +69,7 @@ public:
     {
         if (func == &std::endl<CharT,Traits> )
         {
-            std::cout << "\x1b[0m\n";
-            if (this->g_log)
-            {
-                this->g_log << '\n';
-            }
+            this->writeLine();
         }
         return *this;
     }
@@ -73,51 +77,33 @@ public:
     template<class T>
     codeg::Console& operator <<(const T& val)
     {
+        Line& line = getThreadLine();
+
         if constexpr ( std::is_same<T, codeg::ConsoleOutputType>::value )
         {
-            std::time_t t = std::time(nullptr);
-            auto localTime = std::put_time(std::localtime(&t), "%d.%m.%Y - %H:%M:%S");
+            const std::string localTime = getLocalTime();
 
             switch ( static_cast<codeg::ConsoleOutputType>(val) )
             {
             case OUTPUT_FATAL:
-                std::cout << "\x1b[31m";
-                std::cout << "[fatal](" << localTime << ") ";
-                if (this->g_log)
-                {
-                    this->g_log << "[fatal](" << localTime << ") ";
-                }
+                line._console << "\x1b[31m" << "[fatal](" << localTime << ") ";
+                line._log << "[fatal](" << localTime << ") ";
                 break;
             case OUTPUT_ERROR:
-                std::cout << "\x1b[31m";
-                std::cout << "[error](" << localTime << ") ";
-                if (this->g_log)
-                {
-                    this->g_log << "[error](" << localTime << ") ";
-                }
+                line._console << "\x1b[31m" << "[error](" << localTime << ") ";
+                line._log << "[error](" << localTime << ") ";
                 break;
             case OUTPUT_WARNING:
-                std::cout << "\x1b[36m";
-                std::cout << "[warning](" << localTime << ") ";
-                if (this->g_log)
-                {
-                    this->g_log << "[warning](" << localTime << ") ";
-                }
+                line._console << "\x1b[36m" << "[warning](" << localTime << ") ";
+                line._log << "[warning](" << localTime << ") ";
                 break;
             case OUTPUT_SYNTAX:
-                std::cout << "\x1b[33m";
-                std::cout << "[syntax error](" << localTime << ") ";
-                if (this->g_log)
-                {
-                    this->g_log << "[syntax error](" << localTime<< ") ";
-                }
+                line._console << "\x1b[33m" << "[syntax error](" << localTime << ") ";
+                line._log << "[syntax error](" << localTime << ") ";
                 break;
             case OUTPUT_INFO:
-                std::cout << "[info](" << localTime << ") ";
-                if (this->g_log)
-                {
-                    this->g_log << "[info](" << localTime << ") ";
-                }
+                line._console << "[info](" << localTime << ") ";
+                line._log << "[info](" << localTime << ") ";
                 break;
             default:
                 break;
@@ -125,18 +111,31 @@ public:
         }
         else
         {
-            std::cout << val;
-            if (this->g_log)
-            {
-                this->g_log << val;
-            }
+            line._console << val;
+            line._log << val;
         }
 
         return *this;
     }
 
 private:
+    struct Line
+    {
+        std::ostringstream _console;
+        std::ostringstream _log;
+    };
+
+    [[nodiscard]] static Line& getThreadLine();
+    [[nodiscard]] static std::string getLocalTime();
+
+    void writeLine();
+    void write(const std::string& consoleLine, const std::string& logLine);
+
     std::ofstream g_log;
+    std::mutex g_mutex;
+
+    codeg::Console* g_output{nullptr};
+    std::string g_prefix;
 };
 
 extern codeg::Console* varConsole;
@@ -0,0 +1,83 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef C_INPUTLOG_HPP_INCLUDED
+#define C_INPUTLOG_HPP_INCLUDED
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "C_error.hpp"
+
+#define CG_INPUTLOG_MAGIC "CGINLOG\0"
+#define CG_INPUTLOG_MAGIC_SIZE 8
+#define CG_INPUTLOG_VERSION 1
+
+namespace codeg
+{
+
+enum class InputEventType : uint8_t
+{
+    EVENT_COMMAND,    //A console command that change the machine, _data is the command line
+    EVENT_UART_INPUT, //_target is the peripheral slot, _data the new input buffer
+    EVENT_SNAPSHOT,   //_data is a complete snapshot restored at this cycle
+    EVENT_END         //Only in the file, the cycle is the end of the recorded run
+};
+
+//An event is applied when the machine has executed _cycle instructions
+struct InputEvent
+{
+    uint64_t _cycle{0};
+    codeg::InputEventType _type{codeg::InputEventType::EVENT_COMMAND};
+    uint64_t _target{0};
+    std::string _data;
+};
+
+/*
+ * Log of every external input of a run, so it can be reproduced exactly from the same program.
+ * File format : magic (8 bytes), version (uint8), then for every event : type (uint8),
+ * cycle delta from the previous event, target, data size (unsigned LEB128) and data bytes.
+ * The last event is always EVENT_END.
+ */
+class InputLog
+{
+public:
+    InputLog() = default;
+    ~InputLog() = default;
+
+    //The cycle of an event can't be before the previous one
+    void add(codeg::InputEvent event);
+    void clear();
+
+    [[nodiscard]] const std::vector<codeg::InputEvent>& getEvents() const;
+
+    void setEndCycle(uint64_t cycle);
+    [[nodiscard]] uint64_t getEndCycle() const;
+
+    bool saveToFile(const std::filesystem::path& path) const;
+    //Throw a codeg::Error if the file can't be read or is not valid
+    void loadFromFile(const std::filesystem::path& path);
+
+private:
+    std::vector<codeg::InputEvent> g_events;
+    uint64_t g_endCycle{0};
+};
+
+}//end codeg
+
+#endif // C_INPUTLOG_HPP_INCLUDED
@@ -18,35 +18,66 @@
 #define C_SIGNAL_HPP_INCLUDED
 
 #include <map>
-#include <functional>
 #include <string>
+#include <vector>
 
 namespace codeg
 {
 
+using SignalIndex = std::size_t;
+
+//A signal is only used as a clock, a pulse set it high, call every listener once (rising edge) and set it low
 class Signal
 {
 public:
-    using FunctionType = std::function<void(bool)>;
+    using ListenerFunction = void (*)(void* object);
 
     Signal() = default;
     ~Signal() = default;
 
-    void call(bool val);
+    void pulse()
+    {
+        this->g_value = true;
+        for (const auto& listener : this->g_listeners)
+        {
+            listener._function(listener._object);
+        }
+        this->g_value = false;
+    }
 
-    void attach(Signal::FunctionType func);
+    //The listener method is bound at compile time, no type erased call is needed
+    template<class T, void (T::*TMethod)()>
+    void attach(T* object)
+    {
+        this->g_listeners.push_back({[](void* obj){ (static_cast<T*>(obj)->*TMethod)(); }, object});
+    }
+    void detach(const void* object);
     void detach();
 
-    [[nodiscard]] bool getValue() const;
+    [[nodiscard]] std::size_t getListenerSize() const;
+
+    [[nodiscard]] bool getValue() const
+    {
+        return this->g_value;
+    }
 
 private:
-    Signal::FunctionType g_function{};
+    struct Listener
+    {
+        ListenerFunction _function;
+        void* _object;
+    };
+
+    std::vector<Listener> g_listeners;
     bool g_value{false};
 };
 
+//Signals are kept in insertion order, the index of a signal can be resolved once and used instead of the name
 class SignalMap
 {
 public:
+    using Container = std::vector<std::pair<std::string, codeg::Signal> >;
+
     SignalMap() = default;
     ~SignalMap() = default;
 
@@ -55,20 +86,44 @@ public:
     template<class... Types>
     bool add(const std::string& key, Types... args)
     {
-        return this->g_data.emplace( std::make_pair(key, args...) ).second;
-    }
-    inline bool add(const std::string& key)
-    {
-        return this->g_data.emplace(std::piecewise_construct, std::make_tuple(key), std::make_tuple()).second;
+        if ( this->exist(key) )
+        {
+            return false;
+        }
+        this->g_names.emplace(key, this->g_data.size());
+        this->g_data.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(args...));
+        return true;
     }
 
     [[nodiscard]] bool exist(const std::string& key) const;
 
+    [[nodiscard]] codeg::SignalIndex getIndex(const std::string& key) const;
+
     [[nodiscard]] const codeg::Signal& get(const std::string& key) const;
     [[nodiscard]] codeg::Signal& get(const std::string& key);
 
+    //No range check, the index must come from getIndex() or from a fixed signal layout
+    [[nodiscard]] const codeg::Signal& get(codeg::SignalIndex index) const
+    {
+        return this->g_data[index].second;
+    }
+    [[nodiscard]] codeg::Signal& get(codeg::SignalIndex index)
+    {
+        return this->g_data[index].second;
+    }
+
+    [[nodiscard]] Container::const_iterator begin() const
+    {
+        return this->g_data.cbegin();
+    }
+    [[nodiscard]] Container::const_iterator end() const
+    {
+        return this->g_data.cend();
+    }
+
 private:
-    std::map<std::string, codeg::Signal> g_data;
+    Container g_data;
+    std::map<std::string, codeg::SignalIndex> g_names;
 };
 
 }//end codeg
@@ -0,0 +1,169 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef C_SNAPSHOT_HPP_INCLUDED
+#define C_SNAPSHOT_HPP_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "C_error.hpp"
+
+#define CG_SNAPSHOT_MAGIC "CGSNAP\0\0"
+#define CG_SNAPSHOT_MAGIC_SIZE 8
+#define CG_SNAPSHOT_VERSION 2
+#define CG_SNAPSHOT_ALIGNMENT 8
+
+namespace codeg
+{
+
+class MemoryModule;
+class MemoryModuleStore;
+class ROMContent;
+
+constexpr uint32_t MakeSnapshotTag(char a, char b, char c, char d)
+{
+    return static_cast<uint32_t>(static_cast<uint8_t>(a)) | (static_cast<uint32_t>(static_cast<uint8_t>(b))<<8) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(c))<<16) | (static_cast<uint32_t>(static_cast<uint8_t>(d))<<24);
+}
+
+enum SnapshotTag : uint32_t
+{
+    SNAPSHOT_TAG_MOTHERBOARD = codeg::MakeSnapshotTag('B','O','R','D'),
+    SNAPSHOT_TAG_MEMORY = codeg::MakeSnapshotTag('M','E','M','M'),
+    SNAPSHOT_TAG_PERIPHERAL = codeg::MakeSnapshotTag('P','E','R','I'),
+    SNAPSHOT_TAG_PROCESSOR = codeg::MakeSnapshotTag('P','R','O','C'),
+    SNAPSHOT_TAG_ALU = codeg::MakeSnapshotTag('A','L','U','_'),
+    SNAPSHOT_TAG_PROCESSOR_MEMORY = codeg::MakeSnapshotTag('M','E','M','P'),
+    SNAPSHOT_TAG_END = codeg::MakeSnapshotTag('E','N','D','_')
+};
+
+/*
+ * Snapshot format (native byte order, checked with the header) :
+ *  header : magic (8 bytes), version (uint32), byte order mark (uint32)
+ *  sections : tag (uint32), padding (uint32), payload size (uint64), payload padded to 8 bytes
+ * Large blocks (memory images) are aligned on 8 bytes, so a mapped file can be used directly by the reader.
+ */
+class SnapshotWriter
+{
+public:
+    SnapshotWriter();
+    ~SnapshotWriter() = default;
+
+    template<class T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable types can be written");
+        this->writeBytes(&value, sizeof(T));
+    }
+    void writeBytes(const void* data, std::size_t size);
+    void writeString(const std::string& str);
+    //Pad with 0 until the next aligned position
+    void align();
+
+    //Sections can't be nested
+    void beginSection(codeg::SnapshotTag tag);
+    void endSection();
+
+    //Memory modules are kept in the store instead of being written (in-memory checkpoints),
+    //the modules that didn't change since the previous store are shared with it
+    void setMemoryStore(codeg::MemoryModuleStore* store, const codeg::MemoryModuleStore* previous=nullptr);
+    [[nodiscard]] bool hasMemoryStore() const;
+    void saveMemoryModule(const std::shared_ptr<codeg::MemoryModule>& memoryModule);
+
+    [[nodiscard]] const std::vector<uint8_t>& getData() const;
+    //Move the data out, the writer must not be used anymore
+    [[nodiscard]] std::vector<uint8_t> takeData();
+    bool saveToFile(const std::filesystem::path& path) const;
+
+private:
+    std::vector<uint8_t> g_data;
+    std::size_t g_sectionStart{0};
+    bool g_sectionOpen{false};
+
+    codeg::MemoryModuleStore* g_memoryStore{nullptr};
+    const codeg::MemoryModuleStore* g_previousMemoryStore{nullptr};
+};
+
+//Every read error throw a codeg::Error
+class SnapshotReader
+{
+public:
+    //The data must stay valid while reading
+    SnapshotReader(const uint8_t* data, std::size_t size);
+    ~SnapshotReader() = default;
+
+    template<class T>
+    void read(T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable types can be read");
+        std::memcpy(&value, this->readBytes(sizeof(T)), sizeof(T));
+    }
+    template<class T>
+    [[nodiscard]] T read()
+    {
+        T value;
+        this->read(value);
+        return value;
+    }
+    //Return a pointer inside the snapshot data (no copy)
+    [[nodiscard]] const uint8_t* readBytes(std::size_t size);
+    [[nodiscard]] std::string readString();
+    void align();
+
+    void openSection(codeg::SnapshotTag tag);
+    //The whole section must have been read
+    void closeSection();
+
+    //Memory modules are restored from the store, in the order they were saved
+    void setMemoryStore(const codeg::MemoryModuleStore* store);
+    [[nodiscard]] bool hasMemoryStore() const;
+    void loadMemoryModule(std::shared_ptr<codeg::MemoryModule>& memoryModule);
+
+private:
+    const uint8_t* g_data;
+    std::size_t g_size;
+    std::size_t g_position{0};
+    std::size_t g_sectionEnd{0};
+    bool g_sectionOpen{false};
+
+    const codeg::MemoryModuleStore* g_memoryStore{nullptr};
+    std::size_t g_memoryIndex{0};
+};
+
+//Map a whole snapshot file in memory so the memory images are copied directly from the file,
+//the file must not be modified while the content is alive
+std::shared_ptr<const codeg::ROMContent> MapSnapshotFile(const std::filesystem::path& path);
+
+//Copy the state of an object into another one with saveState()/loadState()
+template<class T>
+void CopySnapshotState(const T& source, T& destination)
+{
+    codeg::SnapshotWriter writer;
+    source.saveState(writer);
+
+    codeg::SnapshotReader reader(writer.getData().data(), writer.getData().size());
+    destination.loadState(reader);
+}
+
+}//end codeg
+
+#endif // C_SNAPSHOT_HPP_INCLUDED
@@ -17,6 +17,7 @@
 #ifndef C_STRING_H_INCLUDED
 #define C_STRING_H_INCLUDED
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -29,6 +30,11 @@ std::size_t Split(const std::string& str, std::vector<std::string>& buff, char d
 
 std::string ValueToHex(uint32_t val, unsigned int hexSize=8, bool removeExtraZero=false, bool removePrefix=false);
 
+//Decimal or hexadecimal with the "0x" prefix (a leading 0 is not octal), return the number of read chars or 0 on error/overflow
+std::size_t ReadValue(const char* str, uint64_t& value);
+//Same as ReadValue but the whole string must be the value
+bool StringToValue(const std::string& str, uint64_t& value);
+
 }//end codeg
 
 #endif // C_STRING_H_INCLUDED
@@ -0,0 +1,119 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef C_BOARDEXECUTOR_HPP_INCLUDED
+#define C_BOARDEXECUTOR_HPP_INCLUDED
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "engine/C_engine.hpp"
+
+#define CG_BOARDEXECUTOR_DEFAULT_QUANTUM 100000
+
+namespace codeg
+{
+
+struct ExecutorJob
+{
+    codeg::ExecutionEngine* _engine{nullptr};
+    std::size_t _maxInstructions{0};
+    //The breakpoint set (if any) must not be shared with another job
+    codeg::StopConditions _conditions;
+
+    codeg::RunResult _result; //Filled by the executor
+};
+
+struct alignas(64) ExecutorWorkerStatistics //One cache line per worker
+{
+    uint64_t _instructionCount{0};
+    uint64_t _quantumCount{0};
+    uint64_t _finishedJobCount{0};
+    uint64_t _stealCount{0};
+};
+
+/*
+ * Run many independent boards across all the cores.
+ * Every job is executed by quantum of instructions, a worker take its next job from the front of its own queue
+ * and put it back at the end if it's not finished, an idle worker steal a job from the back of another queue
+ * or wait until a job is put back.
+ * Every job (engine, motherboard, breakpoints) must be independent, a job is only executed by one worker at a time.
+ */
+class BoardExecutor
+{
+public:
+    //threadCount 0 use every hardware thread
+    explicit BoardExecutor(std::size_t threadCount=0, std::size_t quantum=CG_BOARDEXECUTOR_DEFAULT_QUANTUM);
+    ~BoardExecutor() = default;
+
+    std::size_t addJob(codeg::ExecutionEngine& engine, std::size_t maxInstructions,
+                       const codeg::StopConditions& conditions=codeg::StopConditions{});
+    void clearJobs();
+
+    [[nodiscard]] std::size_t getJobCount() const;
+    [[nodiscard]] const codeg::ExecutorJob& getJob(std::size_t index) const;
+
+    //Pin the worker n on the CPU n (modulo the CPU count), only supported on Linux and Windows
+    void setAffinity(bool enable);
+    [[nodiscard]] bool isAffinity() const;
+
+    [[nodiscard]] std::size_t getThreadCount() const;
+    [[nodiscard]] std::size_t getQuantum() const;
+
+    //Execute every job until it's finished, blocking, the first exception thrown by a job is rethrown here
+    void run();
+
+    //Statistics of every worker for the last run
+    [[nodiscard]] const std::vector<codeg::ExecutorWorkerStatistics>& getStatistics() const;
+
+private:
+    struct WorkerQueue
+    {
+        std::deque<std::size_t> _jobs;
+        std::mutex _mutex;
+    };
+
+    void work(std::size_t workerIndex);
+    bool popJob(std::size_t workerIndex, std::size_t& jobIndex);
+    void pushJob(std::size_t workerIndex, std::size_t jobIndex);
+    void finishJob();
+
+    std::vector<codeg::ExecutorJob> g_jobs;
+    std::vector<std::unique_ptr<WorkerQueue> > g_queues;
+    std::vector<codeg::ExecutorWorkerStatistics> g_statistics;
+
+    std::size_t g_threadCount;
+    std::size_t g_quantum;
+    bool g_affinity{false};
+
+    //Idle workers wait until a job is queued or every job is finished
+    std::size_t g_queuedJobs{0};
+    std::size_t g_remainingJobs{0};
+    std::mutex g_idleMutex;
+    std::condition_variable g_idleCondition;
+
+    std::exception_ptr g_exception;
+    std::mutex g_exceptionMutex;
+};
+
+}//end codeg
+
+#endif // C_BOARDEXECUTOR_HPP_INCLUDED
@@ -0,0 +1,161 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef C_BREAKPOINTS_HPP_INCLUDED
+#define C_BREAKPOINTS_HPP_INCLUDED
+
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <vector>
+#include "engine/C_condition.hpp"
+
+#define CG_BREAKPOINT_ADDRESS_COUNT 0x1000000 //24bits BJMPSRC space
+#define CG_BREAKPOINT_NO_CONDITION std::numeric_limits<std::size_t>::max()
+
+namespace codeg
+{
+
+enum class WatchpointTarget : uint8_t
+{
+    TARGET_PROCESSOR_SLOT,
+    TARGET_MOTHERBOARD_SLOT
+};
+
+enum WatchpointAccess : uint8_t
+{
+    WATCH_READ = 0x01,
+    WATCH_WRITE = 0x02
+};
+
+struct Watchpoint
+{
+    codeg::WatchpointTarget _target{codeg::WatchpointTarget::TARGET_PROCESSOR_SLOT};
+    std::size_t _slot{0};
+    codeg::MemoryAddress _startAddress{0};
+    codeg::MemoryAddress _endAddress{0}; //Included
+    uint8_t _access{codeg::WatchpointAccess::WATCH_READ | codeg::WatchpointAccess::WATCH_WRITE};
+};
+
+struct WatchpointHit
+{
+    std::size_t _index{0}; //Index of the watchpoint
+    codeg::MemoryAddress _address{0};
+    uint8_t _access{0};
+};
+
+/*
+ * Program counter breakpoints are stored in a bitmap over the 24bits BJMPSRC space (allocated with the first breakpoint),
+ * so the test done before every instruction is a single bit read.
+ * The bitmap also contains the program counter of the conditions triggered by one,
+ * the other conditions are selected after an instruction with a mask of opcodes.
+ * Watchpoints are checked after the instructions that access the processor RAM or a peripheral.
+ */
+class BreakpointSet
+{
+public:
+    BreakpointSet() = default;
+    ~BreakpointSet() = default;
+
+    bool addBreakpoint(codeg::MemoryAddress address);
+    bool removeBreakpoint(codeg::MemoryAddress address);
+    void clearBreakpoints();
+
+    [[nodiscard]] bool hasBreakpoint(codeg::MemoryAddress address) const;
+
+    [[nodiscard]] std::size_t getBreakpointCount() const;
+    [[nodiscard]] std::vector<codeg::MemoryAddress> getBreakpoints() const;
+
+    //Return the index of the condition, throw a codeg::Error if the expression is invalid
+    std::size_t addCondition(const std::string& expression);
+    bool removeCondition(std::size_t index);
+    void clearConditions();
+
+    [[nodiscard]] const std::vector<codeg::Condition>& getConditions() const;
+
+    //True if there is a breakpoint or a condition to check before the instruction at this address
+    [[nodiscard]] bool hasProgramCounterTrigger(codeg::MemoryAddress address) const
+    {
+        return (address < CG_BREAKPOINT_ADDRESS_COUNT) && !this->g_bitmap.empty() &&
+               ((this->g_bitmap[address>>6] >> (address&63)) & 1);
+    }
+    //Test every address from startAddress to endAddress (excluded)
+    [[nodiscard]] bool hasProgramCounterTriggerInRange(codeg::MemoryAddress startAddress, codeg::MemoryAddress endAddress) const;
+    //Return true if the execution must stop before the instruction at pc, must be called only when there is a trigger
+    bool checkProgramCounter(codeg::MemoryAddress pc, const codeg::GP8B_5_1& processor);
+
+    //True if there is a condition to check after the executed instruction
+    [[nodiscard]] bool hasInstructionTrigger(uint8_t instruction) const
+    {
+        return (this->g_opcodeTriggers >> (instruction&CG_CODEGBINARYREV1_OPCODE_MASK)) & 1;
+    }
+    [[nodiscard]] bool hasInstructionTriggers() const
+    {
+        return this->g_opcodeTriggers != 0;
+    }
+    //True if a condition read BDATASRC, engines that keep the program counter local must write it back before a check
+    [[nodiscard]] bool isDataSourceRead() const
+    {
+        return this->g_dataSourceRead;
+    }
+    //Return true if the execution must stop after the last executed instruction, pc is the next program counter
+    bool checkInstruction(codeg::MemoryAddress pc, const codeg::GP8B_5_1& processor);
+    //Evaluate once the RAM only conditions added since the last call, they are only checked after a RAMW
+    //and would never stop the execution if they are already true. Return true if one of them is true.
+    bool checkNewConditions(codeg::MemoryAddress pc, const codeg::GP8B_5_1& processor);
+
+    //Index of the condition that stopped the execution or CG_BREAKPOINT_NO_CONDITION for a simple breakpoint
+    [[nodiscard]] std::size_t getLastCondition() const;
+
+    std::size_t addWatchpoint(const codeg::Watchpoint& watchpoint);
+    bool removeWatchpoint(std::size_t index);
+    void clearWatchpoints();
+
+    [[nodiscard]] bool hasWatchpoints() const
+    {
+        return !this->g_watchpoints.empty();
+    }
+    [[nodiscard]] const std::vector<codeg::Watchpoint>& getWatchpoints() const;
+
+    //Return true if a watchpoint match the access, the hit is kept until the next one
+    bool checkAccess(codeg::WatchpointTarget target, std::size_t slot, codeg::MemoryAddress address, uint8_t access);
+    [[nodiscard]] const codeg::WatchpointHit& getLastHit() const;
+
+    [[nodiscard]] bool isEmpty() const
+    {
+        return this->g_breakpoints.empty() && this->g_conditions.empty() && this->g_watchpoints.empty();
+    }
+
+private:
+    void updateProgramCounterTrigger(codeg::MemoryAddress address);
+    void updateTriggers();
+
+    std::vector<uint64_t> g_bitmap;
+    std::set<codeg::MemoryAddress> g_breakpoints;
+
+    std::vector<codeg::Condition> g_conditions;
+    uint32_t g_opcodeTriggers{0};
+    bool g_dataSourceRead{false};
+    std::size_t g_lastCondition{CG_BREAKPOINT_NO_CONDITION};
+    std::size_t g_firstNewCondition{0};
+
+    std::vector<codeg::Watchpoint> g_watchpoints;
+    codeg::WatchpointHit g_lastHit;
+};
+
+}//end codeg
+
+#endif // C_BREAKPOINTS_HPP_INCLUDED
@@ -0,0 +1,173 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef C_CALLGRAPH_HPP_INCLUDED
+#define C_CALLGRAPH_HPP_INCLUDED
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "memoryModule/memoryModules.hpp"
+#include "C_codeg.hpp"
+
+#define CG_CALLGRAPH_MAX_DEPTH 256
+#define CG_CALLGRAPH_MAX_RAM_WRITES 16
+#define CG_CALLGRAPH_DEFAULT_TOP 20
+#define CG_CALLGRAPH_ROOT_NAME "root"
+
+namespace codeg
+{
+
+//One node per call path, the node 0 is the root (the code executed outside of any call)
+struct CallGraphNode
+{
+    codeg::MemoryAddress _function{0}; //Entry address
+    std::size_t _parent{0};
+    uint64_t _calls{0};
+    uint64_t _instructions{0}; //Exclusive
+};
+
+struct CallGraphFunction
+{
+    codeg::MemoryAddress _function{0};
+    uint64_t _calls{0};
+    uint64_t _inclusive{0};
+    uint64_t _exclusive{0};
+};
+
+/*
+ * Call graph profiler, engines call record() after every executed instruction when it is set
+ * in the StopConditions (the busy-wait fast-forward is disabled so every instruction is counted).
+ * codeG has no call instruction, the calls and returns are recognised in the jump stream :
+ *  - a call is a JMPSRC_CLK after the return address (the address after the JMPSRC_CLK) was written
+ *    in consecutive RAM addresses (at least 2 bytes, little or big endian) with RAMW since the last jump
+ *  - a return is a JMPSRC_CLK with a BJMPSRC byte loaded from READABLE_RAM that jump to a return address
+ *    of the call stack (the frames above it are dropped), else it can still be a call (function pointer)
+ * Every other jump stay in the current function.
+ */
+class CallGraphProfiler
+{
+public:
+    CallGraphProfiler();
+    ~CallGraphProfiler() = default;
+
+    //nextAddress is the program counter after the instruction
+    void record(codeg::MemoryAddress address, uint8_t instruction, uint8_t argument, uint16_t ramAddress, codeg::MemoryAddress nextAddress)
+    {
+        ++this->g_nodes[this->g_current]._instructions;
+
+        const auto bus = static_cast<codeg::CodegBinaryRev1Busses>(instruction&CG_CODEGBINARYREV1_BUSSES_MASK);
+        switch ( static_cast<codeg::CodegBinaryRev1>(instruction&CG_CODEGBINARYREV1_OPCODE_MASK) )
+        {
+        case codeg::CodegBinaryRev1::OPCODE_RAMW:
+            this->recordRamWrite(ramAddress, argument);
+            break;
+        case codeg::CodegBinaryRev1::OPCODE_BJMPSRC1_CLK:
+            this->setJumpByteFromRam(0, bus == codeg::CodegBinaryRev1Busses::READABLE_RAM);
+            break;
+        case codeg::CodegBinaryRev1::OPCODE_BJMPSRC2_CLK:
+            this->setJumpByteFromRam(1, bus == codeg::CodegBinaryRev1Busses::READABLE_RAM);
+            break;
+        case codeg::CodegBinaryRev1::OPCODE_BJMPSRC3_CLK:
+            this->setJumpByteFromRam(2, bus == codeg::CodegBinaryRev1Busses::READABLE_RAM);
+            break;
+        case codeg::CodegBinaryRev1::OPCODE_JMPSRC_CLK:
+            this->onJump(address, nextAddress);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void clear();
+
+    [[nodiscard]] uint64_t getInstructionCount() const;
+    [[nodiscard]] uint64_t getCallCount() const;
+    [[nodiscard]] uint64_t getReturnCount() const;
+    //Jumps loaded from the RAM that are not a return or a call
+    [[nodiscard]] uint64_t getUnmatchedReturnCount() const;
+    [[nodiscard]] std::size_t getDepth() const;
+    [[nodiscard]] std::size_t getMaxDepth() const;
+
+    [[nodiscard]] const std::vector<codeg::CallGraphNode>& getNodes() const;
+    //Inclusive instructions of every node (the node and all its children)
+    [[nodiscard]] std::vector<uint64_t> getInclusiveInstructions() const;
+    //Every called function sorted by inclusive instructions, a recursive call is only counted once in the inclusive count
+    [[nodiscard]] std::vector<codeg::CallGraphFunction> getFunctions() const;
+
+    //Functions (inclusive/exclusive) and caller -> callee edges
+    void writeReport(std::ostream& stream, std::size_t top=CG_CALLGRAPH_DEFAULT_TOP) const;
+    //Collapsed stacks ("root;0x000010;0x000042 123" per line) for flame graph tools, return false if the file can't be written
+    bool saveCollapsedStacks(const std::filesystem::path& path) const;
+
+private:
+    struct Frame
+    {
+        std::size_t _caller; //Node
+        codeg::MemoryAddress _returnAddress;
+    };
+    struct RamWrite
+    {
+        uint16_t _address;
+        uint8_t _value;
+    };
+
+    void recordRamWrite(uint16_t address, uint8_t value)
+    {
+        if (this->g_ramWrites.size() >= CG_CALLGRAPH_MAX_RAM_WRITES)
+        {
+            this->g_ramWrites.erase(this->g_ramWrites.begin());
+        }
+        this->g_ramWrites.push_back({address, value});
+    }
+    void setJumpByteFromRam(uint8_t byteIndex, bool fromRam)
+    {
+        if (fromRam)
+        {
+            this->g_jumpFromRam |= static_cast<uint8_t>(1u<<byteIndex);
+        }
+        else
+        {
+            this->g_jumpFromRam &= static_cast<uint8_t>(~(1u<<byteIndex));
+        }
+    }
+
+    void onJump(codeg::MemoryAddress address, codeg::MemoryAddress target);
+    [[nodiscard]] bool isReturnAddressStored(codeg::MemoryAddress returnAddress) const;
+    [[nodiscard]] const RamWrite* findRamWrite(int32_t address) const;
+    [[nodiscard]] std::size_t getChild(std::size_t parent, codeg::MemoryAddress function);
+
+    std::vector<codeg::CallGraphNode> g_nodes;
+    std::map<std::pair<std::size_t, codeg::MemoryAddress>, std::size_t> g_children;
+
+    std::vector<Frame> g_stack;
+    std::size_t g_current{0};
+    std::size_t g_maxDepth{0};
+
+    std::vector<RamWrite> g_ramWrites;
+    uint8_t g_jumpFromRam{0}; //One bit per BJMPSRC byte
+
+    uint64_t g_returns{0};
+    uint64_t g_unmatchedReturns{0};
+};
+
+}//end codeg
+
+#endif // C_CALLGRAPH_HPP_INCLUDED
@@ -0,0 +1,128 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef C_CONDITION_HPP_INCLUDED
+#define C_CONDITION_HPP_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "processor/C_GP8B_5_1.hpp"
+
+#define CG_CONDITION_STACK_SIZE 16
+#define CG_CONDITION_MAX_NESTING 64
+
+namespace codeg
+{
+
+enum class ConditionOpcode : uint8_t
+{
+    COND_PUSH_CONSTANT,
+    COND_PUSH_BUS,
+    COND_PUSH_PC,
+    COND_PUSH_RAMADDRESS,
+    COND_PUSH_ALU,
+    COND_PUSH_INSTRUCTION,
+    COND_PUSH_OPCODE,
+    COND_PUSH_ARGUMENT,
+
+    COND_LOAD_RAM,
+
+    COND_NOT,
+    COND_COMPLEMENT,
+    COND_NEGATE,
+
+    COND_AND,
+    COND_OR,
+    COND_BIT_AND,
+    COND_BIT_OR,
+    COND_BIT_XOR,
+    COND_EQUAL,
+    COND_NOT_EQUAL,
+    COND_LESS,
+    COND_LESS_EQUAL,
+    COND_GREATER,
+    COND_GREATER_EQUAL,
+    COND_ADD,
+    COND_SUBTRACT
+};
+
+struct ConditionInstruction
+{
+    codeg::ConditionOpcode _opcode{codeg::ConditionOpcode::COND_PUSH_CONSTANT};
+    uint64_t _value{0}; //Constant or bus index
+};
+
+//When the condition have to be evaluated, deduced from what the expression depends on
+enum class ConditionTrigger : uint8_t
+{
+    TRIGGER_PROGRAM_COUNTER, //Before the instruction at a program counter
+    TRIGGER_OPCODE, //After an instruction with a specific opcode
+    TRIGGER_EVERY_INSTRUCTION //After every instruction
+};
+
+/*
+ * A breakpoint condition like "PC == 0x40 && BREAD2 & 0x02 && RAM[0x0001] > 3".
+ * The expression is compiled once into a postfix bytecode using the fixed SPS1 bus layout,
+ * busses, RAM (processor slot 0) and ALU are read directly from the processor when evaluated.
+ *
+ * Operands :
+ *  numbers (decimal or hexadecimal with 0x, a leading 0 is not octal), PC, RAMADDRESS, ALU (result), INSTRUCTION, OPCODE, ARGUMENT (of the last executed instruction),
+ *  RAM[expression] (0 out of the 16 bits RAM address range), the SPS1 busses (BJMPSRC, BWRITE1, ..., BPCS)
+ *  and the opcodes constants (BWRITE1_CLK, ..., OPCHOOSE_CLK, IF, IFNOT, RAMW, LTICK).
+ * Operators (C precedence) : || && | ^ & == != < <= > >= + - ! ~
+ *
+ * The trigger is deduced from the top level "&&" of the expression :
+ *  "PC == constant" -> only checked before the instruction at this address,
+ *  "OPCODE == constant" -> only checked after an instruction with this opcode,
+ *  only RAM[constant] and constants -> only checked after a RAMW instruction (and once when added, see BreakpointSet),
+ *  otherwise the condition is checked after every instruction.
+ * Parentheses, RAM[] and unary operators can't be nested more than CG_CONDITION_MAX_NESTING times.
+ */
+class Condition
+{
+public:
+    //Throw a codeg::Error if the expression is invalid
+    explicit Condition(const std::string& expression);
+    ~Condition() = default;
+
+    [[nodiscard]] bool evaluate(const codeg::GP8B_5_1& processor, codeg::MemoryAddress pc) const;
+
+    [[nodiscard]] codeg::ConditionTrigger getTrigger() const;
+    //Program counter or opcode, depending of the trigger
+    [[nodiscard]] uint32_t getTriggerValue() const;
+    //True if the expression only read RAM[constant], it can already be true before any RAMW instruction
+    [[nodiscard]] bool isRamOnly() const;
+    //True if the expression read BDATASRC, the bus must be updated with the program counter before the evaluation
+    [[nodiscard]] bool isDataSourceRead() const;
+
+    [[nodiscard]] const std::string& getExpression() const;
+    [[nodiscard]] const std::vector<codeg::ConditionInstruction>& getCode() const;
+
+private:
+    std::string g_expression;
+    std::vector<codeg::ConditionInstruction> g_code;
+
+    codeg::ConditionTrigger g_trigger{codeg::ConditionTrigger::TRIGGER_EVERY_INSTRUCTION};
+    uint32_t g_triggerValue{0};
+    bool g_ramOnly{false};
+    bool g_dataSourceRead{false};
+};
+
+}//end codeg
+
+#endif // C_CONDITION_HPP_INCLUDED
@@ -0,0 +1,121 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef C_DATAPROFILER_HPP_INCLUDED
+#define C_DATAPROFILER_HPP_INCLUDED
+
+#include <cstdint>
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include "motherboard/motherboards.hpp"
+#include "engine/C_breakpoints.hpp"
+#include "C_codeg.hpp"
+
+#define CG_DATAPROFILER_PAGE_SIZE 4096
+#define CG_DATAPROFILER_DEFAULT_TOP 10
+#define CG_DATAPROFILER_HEATMAP_COLUMNS 64
+#define CG_DATAPROFILER_HEATMAP_ROWS 32
+
+namespace codeg
+{
+
+struct DataAccessCounters
+{
+    uint64_t _reads{0};
+    uint64_t _writes{0};
+};
+
+/*
+ * Data access profiler, engines call record() after every executed instruction when it is set
+ * in the StopConditions (the busy-wait fast-forward is disabled so every access is counted).
+ * Counters are kept per address for the processor RAM (BRAMADD1/2 then READABLE_RAM/RAMW, always
+ * the processor slot 0 like the watchpoints) and for every motherboard memory slot accessed
+ * by a peripheral (ex: the 24 bits address latch of the memory controller).
+ */
+class DataAccessProfiler
+{
+public:
+    DataAccessProfiler() = default;
+    ~DataAccessProfiler() = default;
+
+    //ramAddress is the processor RAM address before the instruction, accesses are the one reported to the motherboard
+    void record(uint8_t instruction, uint16_t ramAddress, const std::vector<codeg::MemoryAccess>& accesses)
+    {
+        if ( static_cast<codeg::CodegBinaryRev1Busses>(instruction&CG_CODEGBINARYREV1_BUSSES_MASK) == codeg::CodegBinaryRev1Busses::READABLE_RAM )
+        {
+            ++this->getCounters(codeg::WatchpointTarget::TARGET_PROCESSOR_SLOT, 0, ramAddress)._reads;
+        }
+        if ( static_cast<codeg::CodegBinaryRev1>(instruction&CG_CODEGBINARYREV1_OPCODE_MASK) == codeg::CodegBinaryRev1::OPCODE_RAMW )
+        {
+            ++this->getCounters(codeg::WatchpointTarget::TARGET_PROCESSOR_SLOT, 0, ramAddress)._writes;
+        }
+        for (const codeg::MemoryAccess& access : accesses)
+        {
+            codeg::DataAccessCounters& counters = this->getCounters(codeg::WatchpointTarget::TARGET_MOTHERBOARD_SLOT, access._slot, access._address);
+            ++(access._write ? counters._writes : counters._reads);
+        }
+    }
+
+    void clear();
+
+    [[nodiscard]] uint64_t getReadCount() const;
+    [[nodiscard]] uint64_t getWriteCount() const;
+
+    //Return nullptr if the address was never accessed
+    [[nodiscard]] const codeg::DataAccessCounters* getCounters(codeg::WatchpointTarget target, std::size_t slot, codeg::MemoryAddress address) const;
+
+    //For every accessed slot: the totals, the hottest addresses and the largest never accessed ranges
+    void writeReport(std::ostream& stream, const codeg::MemoryModuleSlotCapable& processor, const codeg::MemoryModuleSlotCapable& motherboard,
+                     std::size_t top=CG_DATAPROFILER_DEFAULT_TOP) const;
+    //ASCII heatmap of [startAddress, endAddress], a cell is a group of bytes and its character the log scaled access count
+    //(' ' never accessed), access is a combination of codeg::WatchpointAccess
+    void writeHeatmap(std::ostream& stream, codeg::WatchpointTarget target, std::size_t slot,
+                      codeg::MemoryAddress startAddress, codeg::MemoryAddress endAddress, uint8_t access) const;
+    //One line per accessed address, return false if the file can't be written
+    bool saveCsv(const std::filesystem::path& path) const;
+
+    //Last accessed address + 1 of a slot, 0 if never accessed
+    [[nodiscard]] codeg::MemorySize getAccessedSize(codeg::WatchpointTarget target, std::size_t slot) const;
+
+private:
+    using Page = std::array<codeg::DataAccessCounters, CG_DATAPROFILER_PAGE_SIZE>;
+    using Slot = std::vector<std::unique_ptr<Page> >;
+
+    [[nodiscard]] const Slot* getSlot(codeg::WatchpointTarget target, std::size_t slot) const;
+
+    //Grow by page as the memory is accessed
+    codeg::DataAccessCounters& getCounters(codeg::WatchpointTarget target, std::size_t slot, codeg::MemoryAddress address)
+    {
+        std::vector<Slot>& slots = this->g_slots[static_cast<std::size_t>(target)];
+        const std::size_t pageIndex = address / CG_DATAPROFILER_PAGE_SIZE;
+        if ( (slot < slots.size()) && (pageIndex < slots[slot].size()) && slots[slot][pageIndex] )
+        {
+            return (*slots[slot][pageIndex])[address % CG_DATAPROFILER_PAGE_SIZE];
+        }
+        return this->growCounters(target, slot, address);
+    }
+    codeg::DataAccessCounters& growCounters(codeg::WatchpointTarget target, std::size_t slot, codeg::MemoryAddress address);
+
+    std::array<std::vector<Slot>, 2> g_slots;
+};
+
+}//end codeg
+
+#endif // C_DATAPROFILER_HPP_INCLUDED
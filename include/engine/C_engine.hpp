@@ -0,0 +1,165 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef C_ENGINE_HPP_INCLUDED
+#define C_ENGINE_HPP_INCLUDED
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "motherboard/C_GCM_5_1.hpp"
+#include "engine/C_breakpoints.hpp"
+#include "engine/C_profiler.hpp"
+#include "engine/C_dataProfiler.hpp"
+#include "engine/C_callGraph.hpp"
+
+namespace codeg
+{
+
+enum class StopReason : uint8_t
+{
+    STOP_BUDGET_EXHAUSTED,
+    STOP_BREAKPOINT,
+    STOP_WATCHPOINT,
+    STOP_PC_REACHED,
+    STOP_UNSYNC_TIMEOUT,
+    STOP_PERIPHERAL_EVENT
+};
+
+[[nodiscard]] const char* StopReasonToString(codeg::StopReason reason);
+
+struct StopConditions
+{
+    //Stop before executing the instruction at this address
+    bool _stopAtProgramCounter{false};
+    codeg::MemoryAddress _programCounter{0};
+
+    //Stop after an instruction that changed the state of a peripheral (ex: uart transmit)
+    bool _stopOnPeripheralEvent{false};
+
+    //Breakpoints are ignored for the first instruction of a run (so a run can continue from a breakpoint),
+    //watchpoints and conditions not triggered by a program counter stop after the instruction
+    codeg::BreakpointSet* _breakpoints{nullptr};
+
+    //Count every executed instruction (the busy-wait fast-forward is disabled)
+    codeg::ExecutionProfiler* _profiler{nullptr};
+    //Count every processor RAM and motherboard memory access (the busy-wait fast-forward is disabled)
+    codeg::DataAccessProfiler* _dataProfiler{nullptr};
+    //Follow the calls and returns of every executed instruction (the busy-wait fast-forward is disabled)
+    codeg::CallGraphProfiler* _callGraph{nullptr};
+
+    [[nodiscard]] bool hasBreakpoints() const
+    {
+        return (this->_breakpoints != nullptr) && !this->_breakpoints->isEmpty();
+    }
+    [[nodiscard]] bool hasWatchpoints() const
+    {
+        return (this->_breakpoints != nullptr) && this->_breakpoints->hasWatchpoints();
+    }
+    [[nodiscard]] bool hasInstructionTriggers() const
+    {
+        return (this->_breakpoints != nullptr) && this->_breakpoints->hasInstructionTriggers();
+    }
+    [[nodiscard]] bool isProfiling() const
+    {
+        return (this->_profiler != nullptr) || (this->_dataProfiler != nullptr) || (this->_callGraph != nullptr);
+    }
+    [[nodiscard]] bool isEmpty() const
+    {
+        return !this->_stopAtProgramCounter && !this->_stopOnPeripheralEvent && !this->hasBreakpoints() && !this->isProfiling();
+    }
+};
+
+struct RunResult
+{
+    std::size_t _instructionCount{0};
+    codeg::StopReason _reason{codeg::StopReason::STOP_BUDGET_EXHAUSTED};
+
+    //Part of the instructions (and processor clock phases) skipped by the loop detector without being executed
+    std::size_t _skippedInstructionCount{0};
+    uint64_t _skippedPhaseCount{0};
+};
+
+class ExecutionEngine
+{
+public:
+    explicit ExecutionEngine(codeg::GCM_5_1_SPS1& motherboard) :
+            _g_motherboard(motherboard)
+    {}
+    virtual ~ExecutionEngine() = default;
+
+    //Execute complete instructions until the budget is exhausted or a stop condition is met
+    virtual codeg::RunResult run(std::size_t maxInstructions, const codeg::StopConditions& conditions) = 0;
+
+    //Execute complete instructions and return the number really executed (less if the processor can't sync)
+    std::size_t run(std::size_t instructionCount)
+    {
+        return this->run(instructionCount, codeg::StopConditions{})._instructionCount;
+    }
+
+    [[nodiscard]] virtual std::string getType() const = 0;
+
+protected:
+    //Sum of the change count of every peripheral plugged in the motherboard
+    [[nodiscard]] uint64_t getPeripheralChangeCount() const;
+
+    //Check the watchpoints after an instruction, ramAddress is the processor RAM address before the instruction
+    bool checkWatchpoints(codeg::BreakpointSet& breakpoints, uint8_t instruction, uint16_t ramAddress);
+    //Give the memory accesses of the last instruction to the data profiler, they are cleared if not watched
+    void recordDataAccesses(codeg::DataAccessProfiler& profiler, bool watching, uint8_t instruction, uint16_t ramAddress);
+
+    //Generic checked loop for engines that execute one instruction with step()
+    template<class TStep>
+    codeg::RunResult runStepByStep(std::size_t maxInstructions, const codeg::StopConditions& conditions, TStep step);
+
+    codeg::GCM_5_1_SPS1& _g_motherboard;
+};
+
+//Reference engine, clock the processor state machine until sync
+class ClockEngine : public codeg::ExecutionEngine
+{
+public:
+    explicit ClockEngine(codeg::GCM_5_1_SPS1& motherboard) :
+            codeg::ExecutionEngine(motherboard)
+    {}
+    ~ClockEngine() override = default;
+
+    using codeg::ExecutionEngine::run;
+    codeg::RunResult run(std::size_t maxInstructions, const codeg::StopConditions& conditions) override;
+
+    [[nodiscard]] std::string getType() const override;
+};
+
+//Use the motherboard predecoded instruction cache
+class CachedEngine : public codeg::ExecutionEngine
+{
+public:
+    explicit CachedEngine(codeg::GCM_5_1_SPS1& motherboard) :
+            codeg::ExecutionEngine(motherboard)
+    {}
+    ~CachedEngine() override = default;
+
+    using codeg::ExecutionEngine::run;
+    codeg::RunResult run(std::size_t maxInstructions, const codeg::StopConditions& conditions) override;
+
+    [[nodiscard]] std::string getType() const override;
+};
+
+std::unique_ptr<codeg::ExecutionEngine> CreateExecutionEngine(const std::string& type, codeg::GCM_5_1_SPS1& motherboard);
+
+}//end codeg
+
+#endif // C_ENGINE_HPP_INCLUDED
@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef C_LOOPDETECTOR_HPP_INCLUDED
+#define C_LOOPDETECTOR_HPP_INCLUDED
+
+#include <array>
+#include <cstdint>
+#include "motherboard/C_GCM_5_1.hpp"
+
+#define CG_LOOPDETECTOR_CHECK_INTERVAL 16
+
+namespace codeg
+{
+
+//Everything that the next instructions depend on, memories and peripherals are represented by their change count
+struct MachineState
+{
+    codeg::MemoryAddress _programCounter{0};
+    std::size_t _memorySource{0};
+    std::array<uint64_t, codeg::BUS_SPS1_COUNT> _busses{};
+    uint64_t _alu{0};
+    uint64_t _memoryModificationCount{0};
+    uint64_t _peripheralChangeCount{0};
+    uint16_t _ramAddress{0};
+    uint8_t _instruction{0};
+    uint8_t _arguments{0};
+
+    [[nodiscard]] bool operator==(const codeg::MachineState& r) const;
+};
+
+/*
+ * Detect busy-wait loops (ex: polling the UART status) in order to skip them.
+ * One backward jump every CG_LOOPDETECTOR_CHECK_INTERVAL is sampled (the jumps are counted together whatever their
+ * address), its machine state is compared with the one of the previous sampled jump. The program counter is part
+ * of the state so only a sample taken at the same address can match.
+ * If nothing changed (no memory write, no peripheral change) the loop will run the same way until an external event,
+ * and external events (ex: UART input) can only happen between two engine runs.
+ * So every complete loop iteration that fit in the remaining budget can be skipped and charged at once
+ * (instructions and processor clock phases).
+ */
+class LoopDetector
+{
+public:
+    explicit LoopDetector(codeg::GCM_5_1_SPS1& motherboard);
+    ~LoopDetector() = default;
+
+    //Must be called at the start of every run
+    void reset();
+
+    //Called after a backward jump with the number of instructions executed in the current run and the
+    //remaining budget, return the number of instructions that can be skipped
+    std::size_t onBackwardJump(codeg::MemoryAddress pc, std::size_t count, std::size_t remaining);
+
+    [[nodiscard]] uint64_t getSkippedInstructionCount() const;
+    [[nodiscard]] uint64_t getSkippedPhaseCount() const;
+
+    [[nodiscard]] bool captureState(codeg::MemoryAddress pc, codeg::MachineState& state) const;
+
+private:
+    codeg::GCM_5_1_SPS1& g_motherboard;
+
+    codeg::MachineState g_state;
+    std::size_t g_count{0};
+    uint64_t g_phaseCount{0};
+    bool g_valid{false};
+
+    uint32_t g_jumpCount{0}; //Every backward jump of the run, not per address
+    uint64_t g_skippedInstructionCount{0};
+    uint64_t g_skippedPhaseCount{0};
+};
+
+}//end codeg
+
+#endif // C_LOOPDETECTOR_HPP_INCLUDED
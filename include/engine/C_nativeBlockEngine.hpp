@@ -0,0 +1,102 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef C_NATIVEBLOCKENGINE_HPP_INCLUDED
+#define C_NATIVEBLOCKENGINE_HPP_INCLUDED
+
+#include "engine/C_predecodedBlockEngine.hpp"
+
+//The native code is only generated for x86-64, the "native" engine is a PredecodedBlockEngine on other targets
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__unix__) || defined(__APPLE__) || defined(_WIN32))
+    #define CG_NATIVEBLOCKENGINE_SUPPORTED
+#endif
+
+#define CG_NATIVEBLOCKENGINE_CODE_SIZE (4*1024*1024) //Bytes of executable memory per engine
+
+#ifdef CG_NATIVEBLOCKENGINE_SUPPORTED
+
+namespace codeg
+{
+
+//Executable memory, only writable while a block is compiled (W^X)
+class NativeCodeBuffer
+{
+public:
+    explicit NativeCodeBuffer(std::size_t size);
+    ~NativeCodeBuffer();
+
+    NativeCodeBuffer(const NativeCodeBuffer& r) = delete;
+    NativeCodeBuffer& operator=(const NativeCodeBuffer& r) = delete;
+
+    //Copy the code at the end of the buffer, return nullptr if there is not enough space
+    [[nodiscard]] const uint8_t* append(const std::vector<uint8_t>& code);
+    void clear();
+
+    [[nodiscard]] std::size_t getSize() const;
+    [[nodiscard]] std::size_t getUsedSize() const;
+
+private:
+    uint8_t* g_data{nullptr};
+    std::size_t g_size{0};
+    std::size_t g_usedSize{0};
+};
+
+/*
+ * x86-64 tier above the PredecodedBlockEngine, the operations of a translated block are compiled in native code :
+ *  the constant bus loads of the fused operations are stores to the busses and registers of the processor,
+ *  the other instructions are direct calls to the threaded engine handlers (no decoding, no indirect dispatch).
+ * The motherboard, the processor, the ALU and the processor RAM stay the only state, the native code write it directly.
+ *
+ * The last operation of a block that end with a jump, an if/ifnot or a peripheral clock is not compiled,
+ * it exit to the runtime that execute it and find the next block (a peripheral can also write the source memory).
+ * The compiled code is dropped with the blocks when the source memory is written or changed.
+ * When the executable buffer is full, the new blocks are only interpreted until the next clearBlocks().
+ */
+class NativeBlockEngine : public codeg::PredecodedBlockEngine
+{
+public:
+    explicit NativeBlockEngine(codeg::GCM_5_1_SPS1& motherboard);
+    ~NativeBlockEngine() override = default;
+
+    [[nodiscard]] std::string getType() const override;
+
+    void clearBlocks() override;
+
+    [[nodiscard]] std::size_t getCompiledBlockCount() const;
+    [[nodiscard]] const codeg::NativeCodeBuffer& getCodeBuffer() const;
+
+protected:
+    void compileBlock(Block& block) override;
+
+private:
+    codeg::NativeCodeBuffer g_code;
+    std::size_t g_compiledBlockCount{0};
+
+    uint64_t* g_busBJMPSRC;
+    uint64_t* g_busBWRITE1;
+    uint64_t* g_busBWRITE2;
+    uint64_t* g_busNUMBER;
+    uint64_t* g_busBPCS;
+    uint16_t* g_ramAddress;
+    uint64_t* g_phaseCount;
+};
+
+}//end codeg
+
+#endif //CG_NATIVEBLOCKENGINE_SUPPORTED
+
+#endif // C_NATIVEBLOCKENGINE_HPP_INCLUDED
@@ -0,0 +1,144 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef C_PREDECODEDBLOCKENGINE_HPP_INCLUDED
+#define C_PREDECODEDBLOCKENGINE_HPP_INCLUDED
+
+#include "engine/C_threadedEngine.hpp"
+#include <unordered_map>
+#include <vector>
+
+#define CG_PREDECODEDBLOCKENGINE_HOT_THRESHOLD 16
+#define CG_PREDECODEDBLOCKENGINE_MAX_BLOCK_SIZE 128
+#define CG_PREDECODEDBLOCKENGINE_MAX_FUSED_SIZE 8
+
+namespace codeg
+{
+
+/*
+ * Portable interpreter tier above the threaded engine, no native code is generated.
+ * Hot basic blocks are predecoded into a linear list of handlers executed without any decoding or lookup.
+ * A block end after an instruction that can change the program flow or the source memory (jump, if/ifnot, peripheral clock),
+ * those instructions exit to the runtime that find the next block.
+ *
+ * Constant bus loads (BWRITE1/2, BPCS, BJMPSRC1/2/3, BRAMADD1/2 with an immediate argument) are fused
+ * with the instruction that follow them into one operation (ex: BJMPSRC3/2/1 + JMPSRC).
+ * A fused operation is only executed when the remaining budget allows all of its instructions,
+ * so the state is always exact between two run() calls.
+ *
+ * A derived engine can compile the first operations of a translated block in native code (see compileBlock()),
+ * the compiled code is executed when the budget allows all of its instructions, the other operations are still interpreted.
+ */
+class PredecodedBlockEngine : public codeg::ThreadedEngine
+{
+public:
+    struct Operation;
+    using OperationHandler = codeg::MemoryAddress (*)(codeg::PredecodedBlockEngine& engine, const Operation& operation, codeg::MemoryAddress pc);
+
+    //Every constant loads of a fused operation as masks/values
+    struct FusedPrefix
+    {
+        uint32_t _jumpMask{0};
+        uint32_t _jumpValue{0};
+        uint16_t _ramAddressMask{0};
+        uint16_t _ramAddressValue{0};
+        uint8_t _write1Mask{0};
+        uint8_t _write1Value{0};
+        uint8_t _write2Mask{0};
+        uint8_t _write2Value{0};
+        uint8_t _pcsMask{0};
+        uint8_t _pcsValue{0};
+
+        uint8_t _number{0}; //Last argument, the NUMBER bus value before the last instruction
+        codeg::MemorySize _size{0}; //Size in bytes
+        uint64_t _phases{0}; //Clock phases of the constant loads
+    };
+
+    struct Operation
+    {
+        OperationHandler _handler;
+        codeg::DecodedInstruction _decoded; //Last (or only) instruction
+        FusedPrefix _prefix;
+        uint8_t _instructionCount{1};
+    };
+    //Native code of the first operations of a block, return the program counter after them
+    using CompiledCode = codeg::MemoryAddress (*)();
+
+    struct Block
+    {
+        std::vector<Operation> _operations;
+        codeg::MemoryAddress _startAddress{0};
+        codeg::MemoryAddress _endAddress{0}; //Address after the last instruction
+        std::size_t _instructionCount{0};
+
+        CompiledCode _compiled{nullptr};
+        std::size_t _compiledOperationCount{0};
+        std::size_t _compiledInstructionCount{0};
+    };
+
+    explicit PredecodedBlockEngine(codeg::GCM_5_1_SPS1& motherboard);
+    ~PredecodedBlockEngine() override = default;
+
+    //Breakpoints are checked on the block address range, other stop conditions need an instruction granularity
+    //and the run is then done by the threaded engine
+    using codeg::ExecutionEngine::run;
+    codeg::RunResult run(std::size_t maxInstructions, const codeg::StopConditions& conditions) override;
+
+    [[nodiscard]] std::string getType() const override;
+
+    virtual void clearBlocks();
+    [[nodiscard]] std::size_t getBlockCount() const;
+
+    [[nodiscard]] static bool isBlockTerminal(codeg::CodegBinaryRev1 opcode);
+    [[nodiscard]] static bool isFusable(const codeg::DecodedInstruction& decoded);
+
+protected:
+    //Called once for every new translated block, the block is kept at the same address until clearBlocks()
+    virtual void compileBlock([[maybe_unused]] Block& block) {}
+
+private:
+    [[nodiscard]] codeg::PredecodedBlockEngine::Block translate(const codeg::MemoryModule& memory, codeg::MemoryAddress address) const;
+
+    static void appendToPrefix(FusedPrefix& prefix, const codeg::DecodedInstruction& decoded);
+
+    template<uint8_t TInstruction>
+    static codeg::MemoryAddress singleHandler(codeg::PredecodedBlockEngine& engine, const Operation& operation, codeg::MemoryAddress pc);
+    template<uint8_t TInstruction>
+    static codeg::MemoryAddress fusedHandler(codeg::PredecodedBlockEngine& engine, const Operation& operation, codeg::MemoryAddress pc);
+
+    template<std::size_t... TIndex>
+    static constexpr std::array<OperationHandler, 256> makeSingleHandlerTable(std::index_sequence<TIndex...> indexes);
+    template<std::size_t... TIndex>
+    static constexpr std::array<OperationHandler, 256> makeFusedHandlerTable(std::index_sequence<TIndex...> indexes);
+    [[nodiscard]] static const std::array<OperationHandler, 256>& getSingleHandlers();
+    [[nodiscard]] static const std::array<OperationHandler, 256>& getFusedHandlers();
+
+    codeg::Bus& g_busBJMPSRC;
+    codeg::Bus& g_busBWRITE1;
+    codeg::Bus& g_busBWRITE2;
+    codeg::Bus& g_busNUMBER;
+    codeg::Bus& g_busBPCS;
+
+    std::unordered_map<codeg::MemoryAddress, Block> g_blocks;
+    std::unordered_map<codeg::MemoryAddress, uint32_t> g_hotness;
+
+    std::shared_ptr<const codeg::MemoryModule> g_memory;
+    uint64_t g_modificationCount{0};
+};
+
+}//end codeg
+
+#endif // C_PREDECODEDBLOCKENGINE_HPP_INCLUDED
@@ -0,0 +1,129 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef C_PROFILER_HPP_INCLUDED
+#define C_PROFILER_HPP_INCLUDED
+
+#include <cstdint>
+#include <array>
+#include <filesystem>
+#include <ostream>
+#include <vector>
+#include "motherboard/motherboards.hpp"
+#include "C_codeg.hpp"
+
+#define CG_PROFILER_PAGE_SIZE 4096
+#define CG_PROFILER_DEFAULT_TOP 20
+
+namespace codeg
+{
+
+struct ProfilerAddressCounters
+{
+    uint64_t _executions{0};
+    uint64_t _taken{0}; //Only for IF/IFNOT, the condition was true and the next byte skipped
+};
+
+/*
+ * Guest execution profiler, engines call record() after every executed instruction when it is set
+ * in the StopConditions (the busy-wait fast-forward is disabled so every instruction is counted).
+ * Counters are kept per source address (for every memory source slot), per instruction byte
+ * (so per opcode and per readable bus) and per ALU operation.
+ * The ALU operation is followed with OPCHOOSE_CLK, it is considered as 0 before the first one.
+ */
+class ExecutionProfiler
+{
+public:
+    ExecutionProfiler() = default;
+    ~ExecutionProfiler() = default;
+
+    void record(std::size_t sourceIndex, codeg::MemoryAddress address, uint8_t instruction, uint8_t argument)
+    {
+        codeg::ProfilerAddressCounters& counters = this->getCounters(sourceIndex, address);
+        ++counters._executions;
+        ++this->g_instructions[instruction];
+
+        switch ( static_cast<codeg::CodegBinaryRev1>(instruction&CG_CODEGBINARYREV1_OPCODE_MASK) )
+        {
+        case codeg::CodegBinaryRev1::OPCODE_IF:
+            counters._taken += (argument != 0) ? 1 : 0;
+            break;
+        case codeg::CodegBinaryRev1::OPCODE_IFNOT:
+            counters._taken += (argument == 0) ? 1 : 0;
+            break;
+        case codeg::CodegBinaryRev1::OPCODE_OPCHOOSE_CLK:
+            this->g_aluOperation = argument;
+            ++this->g_aluSelections[argument];
+            break;
+        default:
+            break;
+        }
+
+        if ( static_cast<codeg::CodegBinaryRev1Busses>(instruction&CG_CODEGBINARYREV1_BUSSES_MASK) == codeg::CodegBinaryRev1Busses::READABLE_RESULT )
+        {
+            ++this->g_aluResults[this->g_aluOperation];
+        }
+    }
+
+    void clear();
+
+    [[nodiscard]] uint64_t getInstructionCount() const;
+    [[nodiscard]] uint64_t getInstructionCount(uint8_t instruction) const;
+    [[nodiscard]] uint64_t getOpcodeCount(codeg::CodegBinaryRev1 opcode) const;
+    [[nodiscard]] uint64_t getBusCount(codeg::CodegBinaryRev1Busses bus) const;
+    //Number of ALU results read with this operation selected
+    [[nodiscard]] uint64_t getAluResultCount(uint8_t operation) const;
+    //Number of OPCHOOSE_CLK selecting this operation
+    [[nodiscard]] uint64_t getAluSelectionCount(uint8_t operation) const;
+
+    //Return nullptr if the address was never executed
+    [[nodiscard]] const codeg::ProfilerAddressCounters* getCounters(std::size_t sourceIndex, codeg::MemoryAddress address) const;
+
+    //Sorted hot spots (top count addresses) and every counter, annotated with the disassembly of the source memory
+    void writeReport(std::ostream& stream, const codeg::Motherboard& motherboard, std::size_t top=CG_PROFILER_DEFAULT_TOP) const;
+    //One line per executed address sorted by executions, return false if the file can't be written
+    bool saveCsv(const std::filesystem::path& path, const codeg::Motherboard& motherboard) const;
+
+private:
+    struct HotSpot
+    {
+        std::size_t _sourceIndex;
+        codeg::MemoryAddress _address;
+        codeg::ProfilerAddressCounters _counters;
+    };
+    [[nodiscard]] std::vector<HotSpot> getSortedHotSpots() const;
+
+    //Grow by page as the program is executed
+    codeg::ProfilerAddressCounters& getCounters(std::size_t sourceIndex, codeg::MemoryAddress address)
+    {
+        if ( (sourceIndex < this->g_addresses.size()) && (address < this->g_addresses[sourceIndex].size()) )
+        {
+            return this->g_addresses[sourceIndex][address];
+        }
+        return this->growCounters(sourceIndex, address);
+    }
+    codeg::ProfilerAddressCounters& growCounters(std::size_t sourceIndex, codeg::MemoryAddress address);
+
+    std::vector<std::vector<codeg::ProfilerAddressCounters> > g_addresses;
+    std::array<uint64_t, 256> g_instructions{};
+    std::array<uint64_t, 256> g_aluResults{};
+    std::array<uint64_t, 256> g_aluSelections{};
+    uint8_t g_aluOperation{0};
+};
+
+}//end codeg
+
+#endif // C_PROFILER_HPP_INCLUDED
@@ -0,0 +1,553 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef C_THREADEDENGINE_HPP_INCLUDED
+#define C_THREADEDENGINE_HPP_INCLUDED
+
+#include "engine/C_engine.hpp"
+#include "engine/C_loopDetector.hpp"
+#include "processor/C_instructionCache.hpp"
+#include "C_error.hpp"
+#include <array>
+#include <type_traits>
+#include <utility>
+
+namespace codeg
+{
+
+/*
+ * Every possible instruction byte (opcode + readable bus) have its own handler generated at compile time,
+ * the handler is directly called from a table without going through the processor state machine.
+ * The program counter is kept locally and written back to the motherboard only when needed.
+ *
+ * TAlu and TMemory are the ALU and processor RAM types, when they are concrete (and final) types
+ * the compiler can inline the whole ALU and RAM path, they are checked at the start of every run.
+ */
+template<class TAlu, class TMemory>
+class BasicThreadedEngine : public codeg::ExecutionEngine
+{
+public:
+    using Handler = codeg::MemoryAddress (*)(BasicThreadedEngine& engine, const codeg::DecodedInstruction& decoded, codeg::MemoryAddress pc);
+
+    explicit BasicThreadedEngine(codeg::GCM_5_1_SPS1& motherboard);
+    ~BasicThreadedEngine() override = default;
+
+    using codeg::ExecutionEngine::run;
+    codeg::RunResult run(std::size_t maxInstructions, const codeg::StopConditions& conditions) override;
+
+    [[nodiscard]] std::string getType() const override;
+
+    //Skip busy-wait loops, enabled by default
+    void setFastForward(bool enable)
+    {
+        this->_g_fastForward = enable;
+    }
+    [[nodiscard]] bool isFastForward() const
+    {
+        return this->_g_fastForward;
+    }
+    [[nodiscard]] const codeg::LoopDetector& getLoopDetector() const
+    {
+        return this->_g_loopDetector;
+    }
+
+protected:
+    [[nodiscard]] static const std::array<Handler, 256>& getHandlers();
+
+    //Finish the current instruction if the processor is not synchronized and prepare the run,
+    //count is set to the number of instruction executed, return false if the processor can't sync
+    bool prepareRun(std::size_t& count);
+
+    //Instruction by instruction loop, TChecked enable the stop conditions,
+    //breakpoints are ignored for the instruction executed when count is equal to resumeCount
+    template<bool TChecked>
+    codeg::StopReason runInstructions(std::size_t& count, std::size_t maxInstructions, const codeg::StopConditions& conditions,
+                                      std::size_t resumeCount);
+
+    [[nodiscard]] static bool isPeripheralAccess(const codeg::DecodedInstruction& decoded)
+    {
+        return (decoded._opcode == codeg::CodegBinaryRev1::OPCODE_PERIPHERAL_CLK) ||
+               (decoded._bus == codeg::CodegBinaryRev1Busses::READABLE_EXT1) ||
+               (decoded._bus == codeg::CodegBinaryRev1Busses::READABLE_EXT2);
+    }
+
+    //The program counter is kept local during a run, it is written back before checking
+    //conditions that read BDATASRC so the bus is updated from the source memory
+    bool checkProgramCounter(codeg::BreakpointSet& breakpoints, codeg::MemoryAddress pc)
+    {
+        if ( breakpoints.isDataSourceRead() )
+        {
+            this->_g_motherboard.setProgramCounter(pc);
+        }
+        return breakpoints.checkProgramCounter(pc, this->_g_processor);
+    }
+    bool checkInstruction(codeg::BreakpointSet& breakpoints, codeg::MemoryAddress nextPc)
+    {
+        if ( breakpoints.isDataSourceRead() )
+        {
+            this->_g_motherboard.setProgramCounter(nextPc);
+        }
+        return breakpoints.checkInstruction(nextPc, this->_g_processor);
+    }
+
+    template<uint8_t TInstruction>
+    static codeg::MemoryAddress handler(BasicThreadedEngine& engine, const codeg::DecodedInstruction& decoded, codeg::MemoryAddress pc);
+
+    codeg::GP8B_5_1& _g_processor;
+    codeg::InstructionCache _g_cache;
+
+    codeg::LoopDetector _g_loopDetector;
+    bool _g_fastForward{true};
+
+private:
+
+    template<codeg::CodegBinaryRev1Busses TBus>
+    uint8_t readArgument(const codeg::DecodedInstruction& decoded);
+
+    template<std::size_t... TIndex>
+    static constexpr std::array<Handler, 256> makeHandlerTable(std::index_sequence<TIndex...> indexes);
+
+    codeg::MemoryAddress pulseOnMotherboard(codeg::Signal& signal, codeg::MemoryAddress pc);
+
+    codeg::Bus& g_busBJMPSRC;
+    codeg::Bus& g_busBWRITE1;
+    codeg::Bus& g_busBWRITE2;
+    codeg::Bus& g_busBREAD1;
+    codeg::Bus& g_busBREAD2;
+    codeg::Bus& g_busNUMBER;
+    codeg::Bus& g_busBPCS;
+
+    codeg::Signal& g_signalPERIPHERAL_CLK;
+    codeg::Signal& g_signalSELECTING_RBEXT1;
+    codeg::Signal& g_signalSELECTING_RBEXT2;
+
+    //Only valid during run()
+    TAlu* g_alu{nullptr};
+    TMemory* g_ram{nullptr};
+    const codeg::MemoryModuleSlot* g_ramSlot{nullptr}; //Raw span access when the RAM type is not known
+};
+
+template<class TAlu, class TMemory>
+BasicThreadedEngine<TAlu, TMemory>::BasicThreadedEngine(codeg::GCM_5_1_SPS1& motherboard) :
+        codeg::ExecutionEngine(motherboard),
+        _g_processor(motherboard._processor),
+        _g_loopDetector(motherboard),
+
+        g_busBJMPSRC(motherboard._processor._busses.get(codeg::BUS_SPS1_BJMPSRC)),
+        g_busBWRITE1(motherboard._processor._busses.get(codeg::BUS_SPS1_BWRITE1)),
+        g_busBWRITE2(motherboard._processor._busses.get(codeg::BUS_SPS1_BWRITE2)),
+        g_busBREAD1(motherboard._processor._busses.get(codeg::BUS_SPS1_BREAD1)),
+        g_busBREAD2(motherboard._processor._busses.get(codeg::BUS_SPS1_BREAD2)),
+        g_busNUMBER(motherboard._processor._busses.get(codeg::BUS_SPS1_NUMBER)),
+        g_busBPCS(motherboard._processor._busses.get(codeg::BUS_SPS1_BPCS)),
+
+        g_signalPERIPHERAL_CLK(motherboard._processor._signals.get(codeg::SIGNAL_SPS1_PERIPHERAL_CLK)),
+        g_signalSELECTING_RBEXT1(motherboard._processor._signals.get(codeg::SIGNAL_SPS1_SELECTING_RBEXT1)),
+        g_signalSELECTING_RBEXT2(motherboard._processor._signals.get(codeg::SIGNAL_SPS1_SELECTING_RBEXT2))
+{
+}
+
+template<class TAlu, class TMemory>
+template<uint8_t TInstruction>
+codeg::MemoryAddress BasicThreadedEngine<TAlu, TMemory>::handler(BasicThreadedEngine& engine, const codeg::DecodedInstruction& decoded, codeg::MemoryAddress pc)
+{
+    constexpr auto opcode = static_cast<codeg::CodegBinaryRev1>(TInstruction&CG_CODEGBINARYREV1_OPCODE_MASK);
+    constexpr auto bus = static_cast<codeg::CodegBinaryRev1Busses>(TInstruction&CG_CODEGBINARYREV1_BUSSES_MASK);
+
+    //ADDSRC_CLK done by the processor after reading the instruction
+    ++pc;
+
+    const uint8_t argument = engine.template readArgument<bus>(decoded);
+    engine.g_busNUMBER.set(argument);
+    engine._g_processor.setLastInstruction(TInstruction, argument);
+    engine._g_processor.addPhases(codeg::GP8B_5_1::getInstructionPhases(TInstruction, argument));
+
+    if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_BWRITE1_CLK)
+    {
+        engine.g_busBWRITE1.set(argument);
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_BWRITE2_CLK)
+    {
+        engine.g_busBWRITE2.set(argument);
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_BPCS_CLK)
+    {
+        engine.g_busBPCS.set(argument);
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_OPLEFT_CLK)
+    {
+        engine.g_alu->setOperationLeft(argument);
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_OPRIGHT_CLK)
+    {
+        engine.g_alu->setOperationRight(argument);
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_OPCHOOSE_CLK)
+    {
+        engine.g_alu->setOperation(argument);
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_PERIPHERAL_CLK)
+    {
+        pc = engine.pulseOnMotherboard(engine.g_signalPERIPHERAL_CLK, pc);
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_BJMPSRC1_CLK)
+    {
+        engine.g_busBJMPSRC.set( (engine.g_busBJMPSRC.get() & ~0x000000FFu) | static_cast<uint32_t>(argument) );
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_BJMPSRC2_CLK)
+    {
+        engine.g_busBJMPSRC.set( (engine.g_busBJMPSRC.get() & ~0x0000FF00u) | (static_cast<uint32_t>(argument)<<8) );
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_BJMPSRC3_CLK)
+    {
+        engine.g_busBJMPSRC.set( (engine.g_busBJMPSRC.get() & ~0x00FF0000u) | (static_cast<uint32_t>(argument)<<16) );
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_JMPSRC_CLK)
+    {//The jump instruction inhibit a clock to the next address
+        return engine.g_busBJMPSRC.get();
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_BRAMADD1_CLK)
+    {
+        engine._g_processor.setRamAddress( (engine._g_processor.getRamAddress() & 0xFF00) | static_cast<uint16_t>(argument) );
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_BRAMADD2_CLK)
+    {
+        engine._g_processor.setRamAddress( (engine._g_processor.getRamAddress() & 0x00FF) | (static_cast<uint16_t>(argument)<<8) );
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_IF)
+    {
+        pc += argument ? 1 : 0;
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_IFNOT)
+    {
+        pc += argument ? 0 : 1;
+    }
+    else if constexpr (opcode == codeg::CodegBinaryRev1::OPCODE_RAMW)
+    {
+        if constexpr (std::is_same_v<TMemory, codeg::MemoryModule>)
+        {
+            if (engine.g_ramSlot != nullptr)
+            {
+                engine.g_ramSlot->write(engine._g_processor.getRamAddress(), argument);
+            }
+        }
+        else if (engine.g_ram != nullptr)
+        {
+            engine.g_ram->set(engine._g_processor.getRamAddress(), argument);
+        }
+    }
+
+    if constexpr (bus == codeg::CodegBinaryRev1Busses::READABLE_SOURCE)
+    {//Skip the argument
+        ++pc;
+    }
+    return pc;
+}
+
+template<class TAlu, class TMemory>
+template<codeg::CodegBinaryRev1Busses TBus>
+uint8_t BasicThreadedEngine<TAlu, TMemory>::readArgument(const codeg::DecodedInstruction& decoded)
+{
+    if constexpr (TBus == codeg::CodegBinaryRev1Busses::READABLE_SOURCE)
+    {
+        return decoded._immediate;
+    }
+    else if constexpr (TBus == codeg::CodegBinaryRev1Busses::READABLE_BREAD1)
+    {
+        return this->g_busBREAD1.get();
+    }
+    else if constexpr (TBus == codeg::CodegBinaryRev1Busses::READABLE_BREAD2)
+    {
+        return this->g_busBREAD2.get();
+    }
+    else if constexpr (TBus == codeg::CodegBinaryRev1Busses::READABLE_RESULT)
+    {
+        return this->g_alu->getResult();
+    }
+    else if constexpr (TBus == codeg::CodegBinaryRev1Busses::READABLE_RAM)
+    {
+        if constexpr (std::is_same_v<TMemory, codeg::MemoryModule>)
+        {
+            return (this->g_ramSlot != nullptr) ? this->g_ramSlot->read(this->_g_processor.getRamAddress()) : 0;
+        }
+        else
+        {
+            uint8_t data = 0;
+            if ( (this->g_ram == nullptr) || !this->g_ram->get(this->_g_processor.getRamAddress(), data) )
+            {
+                return 0;
+            }
+            return data;
+        }
+    }
+    else if constexpr (TBus == codeg::CodegBinaryRev1Busses::READABLE_EXT1)
+    {
+        this->g_signalSELECTING_RBEXT1.pulse();
+        return this->g_busNUMBER.get();
+    }
+    else if constexpr (TBus == codeg::CodegBinaryRev1Busses::READABLE_EXT2)
+    {
+        this->g_signalSELECTING_RBEXT2.pulse();
+        return this->g_busNUMBER.get();
+    }
+    else
+    {
+        return 0; ///TODO: implement an spi emulation
+    }
+}
+
+template<class TAlu, class TMemory>
+template<std::size_t... TIndex>
+constexpr std::array<typename BasicThreadedEngine<TAlu, TMemory>::Handler, 256> BasicThreadedEngine<TAlu, TMemory>::makeHandlerTable([[maybe_unused]] std::index_sequence<TIndex...> indexes)
+{
+    return {{&BasicThreadedEngine::template handler<static_cast<uint8_t>(TIndex)>...}};
+}
+
+template<class TAlu, class TMemory>
+codeg::MemoryAddress BasicThreadedEngine<TAlu, TMemory>::pulseOnMotherboard(codeg::Signal& signal, codeg::MemoryAddress pc)
+{
+    //Peripherals can see and change the program counter (ex: memory source switch)
+    this->_g_motherboard.setProgramCounter(pc);
+    signal.pulse();
+    return this->_g_motherboard.getProgramCounter();
+}
+
+template<class TAlu, class TMemory>
+const std::array<typename BasicThreadedEngine<TAlu, TMemory>::Handler, 256>& BasicThreadedEngine<TAlu, TMemory>::getHandlers()
+{
+    static constexpr std::array<Handler, 256> handlers = makeHandlerTable(std::make_index_sequence<256>{});
+    return handlers;
+}
+
+template<class TAlu, class TMemory>
+bool BasicThreadedEngine<TAlu, TMemory>::prepareRun(std::size_t& count)
+{
+    count = 0;
+    if ( !this->_g_processor.isSync() )
+    {//Finish the current instruction with the state machine
+        if ( !this->_g_processor.clockUntilSync(20) )
+        {
+            return false;
+        }
+        ++count;
+    }
+
+    this->_g_loopDetector.reset();
+
+    codeg::MemoryModule* ram = nullptr;
+    const codeg::MemoryModuleSlot* ramSlot = this->_g_processor.getMemorySlot(0);
+    if (ramSlot != nullptr)
+    {
+        ram = ramSlot->_mem.get();
+    }
+    this->g_ramSlot = ramSlot;
+
+    //The concrete types must match when the engine is statically composed
+    if constexpr (std::is_same_v<TAlu, codeg::Alu>)
+    {
+        this->g_alu = this->_g_processor._alu.get();
+    }
+    else
+    {
+        this->g_alu = dynamic_cast<TAlu*>(this->_g_processor._alu.get());
+        if (this->g_alu == nullptr)
+        {
+            throw codeg::Error("static engine: the processor ALU is not of the expected type");
+        }
+    }
+    if constexpr (std::is_same_v<TMemory, codeg::MemoryModule>)
+    {
+        this->g_ram = ram;
+    }
+    else
+    {
+        this->g_ram = dynamic_cast<TMemory*>(ram);
+        if ( (ram != nullptr) && (this->g_ram == nullptr) )
+        {
+            throw codeg::Error("static engine: the processor RAM is not of the expected type");
+        }
+    }
+
+    return true;
+}
+
+template<class TAlu, class TMemory>
+template<bool TChecked>
+codeg::StopReason BasicThreadedEngine<TAlu, TMemory>::runInstructions(std::size_t& count, std::size_t maxInstructions,
+                                                                      [[maybe_unused]] const codeg::StopConditions& conditions,
+                                                                      [[maybe_unused]] std::size_t resumeCount)
+{
+    const std::array<Handler, 256>& handlers = getHandlers();
+
+    codeg::StopReason reason = codeg::StopReason::STOP_BUDGET_EXHAUSTED;
+    codeg::MemoryAddress pc = this->_g_motherboard.getProgramCounter();
+
+    [[maybe_unused]] uint64_t peripheralChangeCount = 0;
+    [[maybe_unused]] bool watching = false;
+    bool fastForward = this->_g_fastForward;
+    if constexpr (TChecked)
+    {
+        //Skipped instructions can't be profiled
+        fastForward = fastForward && !conditions.isProfiling();
+
+        if (conditions._stopOnPeripheralEvent)
+        {
+            peripheralChangeCount = this->getPeripheralChangeCount();
+        }
+        watching = conditions.hasWatchpoints();
+        this->_g_motherboard.setMemoryAccessTracking(watching || (conditions._dataProfiler != nullptr));
+    }
+
+    while (true)
+    {
+        if constexpr (TChecked)
+        {
+            if ( conditions._stopAtProgramCounter && (pc == conditions._programCounter) )
+            {
+                reason = codeg::StopReason::STOP_PC_REACHED;
+                break;
+            }
+            if ( (count != resumeCount) && (conditions._breakpoints != nullptr) &&
+                 conditions._breakpoints->hasProgramCounterTrigger(pc) && this->checkProgramCounter(*conditions._breakpoints, pc) )
+            {
+                reason = codeg::StopReason::STOP_BREAKPOINT;
+                break;
+            }
+        }
+        if (count >= maxInstructions)
+        {
+            break;
+        }
+
+        const codeg::MemoryModuleSlot* sourceSlot = this->_g_motherboard.getMemorySourceSlot();
+        if ( (sourceSlot == nullptr) || !sourceSlot->_mem )
+        {
+            reason = codeg::StopReason::STOP_UNSYNC_TIMEOUT;
+            break;
+        }
+
+        const codeg::DecodedInstruction& decoded = this->_g_cache.get(sourceSlot->_mem, pc);
+        [[maybe_unused]] const uint16_t ramAddress = this->_g_processor.getRamAddress();
+        [[maybe_unused]] const std::size_t sourceIndex = this->_g_motherboard.getMemorySourceIndex();
+        const codeg::MemoryAddress nextPc = handlers[decoded._instruction](*this, decoded, pc);
+        ++count;
+
+        if constexpr (TChecked)
+        {
+            if (conditions._profiler != nullptr)
+            {
+                conditions._profiler->record(sourceIndex, pc, decoded._instruction, this->_g_processor.getArguments());
+            }
+            if (conditions._dataProfiler != nullptr)
+            {
+                this->recordDataAccesses(*conditions._dataProfiler, watching, decoded._instruction, ramAddress);
+            }
+            if (conditions._callGraph != nullptr)
+            {
+                conditions._callGraph->record(pc, decoded._instruction, this->_g_processor.getArguments(), ramAddress, nextPc);
+            }
+
+            if ( watching && this->checkWatchpoints(*conditions._breakpoints, decoded._instruction, ramAddress) )
+            {
+                pc = nextPc;
+                reason = codeg::StopReason::STOP_WATCHPOINT;
+                break;
+            }
+            if ( (conditions._breakpoints != nullptr) && conditions._breakpoints->hasInstructionTrigger(decoded._instruction) &&
+                 this->checkInstruction(*conditions._breakpoints, nextPc) )
+            {
+                pc = nextPc;
+                reason = codeg::StopReason::STOP_BREAKPOINT;
+                break;
+            }
+            if ( conditions._stopOnPeripheralEvent && isPeripheralAccess(decoded) )
+            {
+                const uint64_t lastChangeCount = peripheralChangeCount;
+                peripheralChangeCount = this->getPeripheralChangeCount();
+                if (peripheralChangeCount != lastChangeCount)
+                {
+                    pc = nextPc;
+                    reason = codeg::StopReason::STOP_PERIPHERAL_EVENT;
+                    break;
+                }
+            }
+        }
+
+        if ( (nextPc <= pc) && fastForward )
+        {
+            count += this->_g_loopDetector.onBackwardJump(nextPc, count, maxInstructions-count);
+        }
+        pc = nextPc;
+    }
+
+    if constexpr (TChecked)
+    {
+        this->_g_motherboard.setMemoryAccessTracking(false);
+    }
+    this->_g_motherboard.setProgramCounter(pc);
+    return reason;
+}
+
+template<class TAlu, class TMemory>
+codeg::RunResult BasicThreadedEngine<TAlu, TMemory>::run(std::size_t maxInstructions, const codeg::StopConditions& conditions)
+{
+    codeg::RunResult result;
+
+    if (maxInstructions == 0)
+    {
+        return result;
+    }
+    if ( !this->prepareRun(result._instructionCount) )
+    {
+        result._reason = codeg::StopReason::STOP_UNSYNC_TIMEOUT;
+        return result;
+    }
+
+    const std::size_t resumeCount = result._instructionCount;
+    const uint64_t skippedInstructionCount = this->_g_loopDetector.getSkippedInstructionCount();
+    const uint64_t skippedPhaseCount = this->_g_loopDetector.getSkippedPhaseCount();
+    if ( conditions.isEmpty() )
+    {
+        result._reason = this->template runInstructions<false>(result._instructionCount, maxInstructions, conditions, resumeCount);
+    }
+    else
+    {
+        result._reason = this->template runInstructions<true>(result._instructionCount, maxInstructions, conditions, resumeCount);
+    }
+    result._skippedInstructionCount = static_cast<std::size_t>(this->_g_loopDetector.getSkippedInstructionCount() - skippedInstructionCount);
+    result._skippedPhaseCount = this->_g_loopDetector.getSkippedPhaseCount() - skippedPhaseCount;
+    return result;
+}
+
+template<class TAlu, class TMemory>
+std::string BasicThreadedEngine<TAlu, TMemory>::getType() const
+{
+    if constexpr (std::is_same_v<TAlu, codeg::Alu> && std::is_same_v<TMemory, codeg::MemoryModule>)
+    {
+        return "threaded";
+    }
+    else
+    {
+        return "static";
+    }
+}
+
+using ThreadedEngine = codeg::BasicThreadedEngine<codeg::Alu, codeg::MemoryModule>;
+extern template class codeg::BasicThreadedEngine<codeg::Alu, codeg::MemoryModule>;
+
+}//end codeg
+
+#endif // C_THREADEDENGINE_HPP_INCLUDED
@@ -0,0 +1,111 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef C_TIMETRAVEL_HPP_INCLUDED
+#define C_TIMETRAVEL_HPP_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "engine/C_engine.hpp"
+#include "memoryModule/memoryModules.hpp"
+
+#define CG_TIMETRAVEL_DEFAULT_MEMORY_BUDGET (128*1024*1024)
+#define CG_TIMETRAVEL_DEFAULT_LATENCY std::chrono::microseconds{2000}
+#define CG_TIMETRAVEL_MIN_INTERVAL 1000
+#define CG_TIMETRAVEL_MAX_INTERVAL 10000000
+#define CG_TIMETRAVEL_MIN_CHECKPOINTS 4
+
+namespace codeg
+{
+
+struct TimeTravelCheckpoint
+{
+    uint64_t _cycle{0};
+    std::vector<uint8_t> _state; //Snapshot of the machine without the memory content
+    codeg::MemoryModuleStore _memory; //Forks of the memory modules, shared with the previous checkpoint when unchanged
+    std::size_t _memoryUsage{0}; //Bytes not shared with the previous checkpoint
+};
+
+/*
+ * Reverse execution by checkpoints and deterministic re-execution.
+ * Every instruction executed by run() is counted (the cycle), a checkpoint of the whole machine is taken
+ * periodically (only the memory modules modified since the previous checkpoint are copied) and going back to a cycle restore the previous checkpoint and execute again until the wanted cycle.
+ * The checkpoint interval follow the measured engine speed so re-executing one interval take about the latency target,
+ * when the memory budget is exceeded some checkpoints are dropped so the remaining ones are evenly spaced.
+ * Everything that change the machine outside of run() (reset, plug, restore, ...) must call reset().
+ */
+class TimeTravel
+{
+public:
+    TimeTravel(codeg::Motherboard& motherboard, codeg::ExecutionEngine& engine,
+               std::size_t memoryBudget=CG_TIMETRAVEL_DEFAULT_MEMORY_BUDGET);
+    ~TimeTravel() = default;
+
+    //Execute forward and take the checkpoints, the history after the current cycle is forgotten
+    codeg::RunResult run(std::size_t maxInstructions, const codeg::StopConditions& conditions);
+
+    //Go to the state after the cycle (forward or backward), return false if the cycle can't be reached
+    bool gotoCycle(uint64_t cycle);
+    bool stepBack(uint64_t count=1);
+    //Go back to the last breakpoint/watchpoint hit before the current cycle, STOP_BUDGET_EXHAUSTED
+    //means that the beginning of the history was reached without a hit
+    codeg::RunResult reverseContinue(const codeg::StopConditions& conditions);
+
+    //Forget the history and start a new one at cycle 0 from the current state
+    void reset();
+
+    [[nodiscard]] uint64_t getCycle() const;
+    //First reachable cycle
+    [[nodiscard]] uint64_t getFirstCycle() const;
+
+    void setMemoryBudget(std::size_t memoryBudget);
+    [[nodiscard]] std::size_t getMemoryBudget() const;
+    [[nodiscard]] std::size_t getMemoryUsage() const;
+
+    void setLatencyTarget(std::chrono::microseconds latency);
+    [[nodiscard]] std::chrono::microseconds getLatencyTarget() const;
+
+    [[nodiscard]] std::size_t getCheckpointCount() const;
+    [[nodiscard]] uint64_t getInterval() const;
+
+private:
+    void takeCheckpoint();
+    //Index of the last checkpoint at or before the cycle
+    [[nodiscard]] std::size_t findCheckpoint(uint64_t cycle) const;
+    void restoreCheckpoint(const codeg::TimeTravelCheckpoint& checkpoint);
+    //Execute without condition until the cycle, return false if the processor can't sync
+    bool executeUntil(uint64_t cycle);
+    void trimCheckpoints();
+    void updateInterval(std::size_t instructionCount, std::chrono::steady_clock::duration duration);
+
+    codeg::Motherboard& g_motherboard;
+    codeg::ExecutionEngine& g_engine;
+
+    std::vector<codeg::TimeTravelCheckpoint> g_checkpoints;
+    std::size_t g_memoryUsage{0};
+    std::size_t g_memoryBudget;
+
+    uint64_t g_cycle{0};
+    uint64_t g_interval{CG_TIMETRAVEL_MIN_INTERVAL};
+    std::chrono::microseconds g_latencyTarget{CG_TIMETRAVEL_DEFAULT_LATENCY};
+    double g_speed{0.0}; //Instructions per second, 0 if not measured
+};
+
+}//end codeg
+
+#endif // C_TIMETRAVEL_HPP_INCLUDED
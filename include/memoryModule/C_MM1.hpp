@@ -29,13 +29,46 @@ public:
     explicit MM1(codeg::MemorySize memorySize);
     ~MM1() override = default;
 
-    bool set(codeg::MemoryAddress address, uint8_t data) override;
-    bool set(codeg::MemoryAddress address, uint8_t* data, codeg::MemorySize dataSize) override;
-    bool get(codeg::MemoryAddress address, uint8_t& data) const override;
-    bool get(codeg::MemoryAddress startAddress, codeg::MemorySize addressCount, uint8_t* data, codeg::MemorySize dataSize) const override;
+    //Single byte access is defined here so a statically composed board can inline it
+    bool set(codeg::MemoryAddress address, uint8_t data) final
+    {
+        if (address < this->g_data.size())
+        {
+            this->g_data[address] = data;
+            ++this->_g_modificationCount;
+            return true;
+        }
+        return false;
+    }
+    bool set(codeg::MemoryAddress address, uint8_t* data, codeg::MemorySize dataSize) final;
+    bool get(codeg::MemoryAddress address, uint8_t& data) const final
+    {
+        if (address < this->g_data.size())
+        {
+            data = this->g_data[address];
+            return true;
+        }
+        return false;
+    }
+    bool get(codeg::MemoryAddress startAddress, codeg::MemorySize addressCount, uint8_t* data, codeg::MemorySize dataSize) const final;
 
     [[nodiscard]] std::string getType() const override;
 
+    [[nodiscard]] const uint8_t* getReadSpan() const override
+    {
+        return this->g_data.data();
+    }
+    [[nodiscard]] uint8_t* getWriteSpan() override
+    {
+        return this->g_data.data();
+    }
+
+    //Copy the whole content
+    [[nodiscard]] std::shared_ptr<codeg::MemoryModule> fork() const override;
+
+    void saveState(codeg::SnapshotWriter& writer) const override;
+    void loadState(codeg::SnapshotReader& reader) override;
+
 private:
     std::vector<uint8_t> g_data;
 };
@@ -0,0 +1,108 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef C_ROM1_HPP_INCLUDED
+#define C_ROM1_HPP_INCLUDED
+
+#include "memoryModule/memoryModules.hpp"
+#include <filesystem>
+#include <memory>
+
+#define CG_ROM1_MAX_SIZE (1 << 24)
+
+namespace codeg
+{
+
+//Read-only content of a ROM, a file mapped in memory or an owned buffer
+class ROMContent
+{
+public:
+    virtual ~ROMContent() = default;
+
+    [[nodiscard]] virtual const uint8_t* getData() const = 0;
+    [[nodiscard]] virtual codeg::MemorySize getSize() const = 0;
+};
+
+//Map a whole file in memory (read in a buffer if the system can't map it), an empty file give an empty content,
+//throw a codeg::Error if the file can't be read or is bigger than maxSize
+std::shared_ptr<const codeg::ROMContent> MapFileContent(const std::filesystem::path& path, codeg::MemorySize maxSize);
+
+/*
+ * MM1 compatible read-only memory module, used for the program with --rom.
+ * The content is a read-only mapping of the program file, shared by every module
+ * (and every thread) using the same file. Writes are refused, a program that write
+ * into its source slot need a writable module (MM1).
+ * The file must not be truncated while it is mapped, reading a page past the new end
+ * of the file is a bus error (SIGBUS) on POSIX systems.
+ */
+class ROM1 : public codeg::MemoryModule
+{
+public:
+    //Empty ROM filled with 0
+    explicit ROM1(codeg::MemorySize memorySize);
+    //Map the file (up to the 24 bits address space, an empty file give an empty ROM),
+    //throw a codeg::Error if it can't be mapped
+    explicit ROM1(const std::filesystem::path& path);
+    ROM1(const codeg::ROM1& r) = default;
+    ~ROM1() override = default;
+
+    bool set([[maybe_unused]] codeg::MemoryAddress address, [[maybe_unused]] uint8_t data) final
+    {
+        return false;
+    }
+    bool set(codeg::MemoryAddress address, uint8_t* data, codeg::MemorySize dataSize) final;
+    bool get(codeg::MemoryAddress address, uint8_t& data) const final
+    {
+        if (address < this->_g_memorySize)
+        {
+            data = this->g_data[address];
+            return true;
+        }
+        return false;
+    }
+    bool get(codeg::MemoryAddress startAddress, codeg::MemorySize addressCount, uint8_t* data, codeg::MemorySize dataSize) const final;
+
+    [[nodiscard]] std::string getType() const override;
+    [[nodiscard]] bool isSlotCompatible(const std::string& slotType) const override;
+
+    [[nodiscard]] bool isReadOnly() const override
+    {
+        return true;
+    }
+
+    //Only readable, the span change when a different content is restored
+    [[nodiscard]] const uint8_t* getReadSpan() const override
+    {
+        return this->g_data;
+    }
+
+    //Share the content with the new module
+    [[nodiscard]] std::shared_ptr<codeg::MemoryModule> fork() const override;
+
+    //Same layout as MM1, the mapping is kept when the restored content is the same
+    void saveState(codeg::SnapshotWriter& writer) const override;
+    void loadState(codeg::SnapshotReader& reader) override;
+
+    [[nodiscard]] bool isMapped() const;
+
+private:
+    std::shared_ptr<const codeg::ROMContent> g_content;
+    const uint8_t* g_data;
+};
+
+}//end codeg
+
+#endif // C_ROM1_HPP_INCLUDED
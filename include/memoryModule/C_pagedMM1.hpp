@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef C_PAGEDMM1_HPP_INCLUDED
+#define C_PAGEDMM1_HPP_INCLUDED
+
+#include "memoryModule/memoryModules.hpp"
+#include <array>
+#include <memory>
+#include <vector>
+
+#define CG_PAGEDMM1_PAGE_SIZE 256
+#define CG_SPARSEMM1_PAGE_SIZE 4096
+
+namespace codeg
+{
+
+/*
+ * MM1 compatible memory module with copy-on-write pages of TPageSize bytes.
+ * A page is only allocated on the first write into it, never written pages read as 0.
+ * A fork share every page with its parent, a page is only copied when one of them write into it.
+ * Pages are never modified when shared, so forks can be used from different threads but a module
+ * must not be forked while it is written by another thread.
+ * Snapshots only contain the allocated pages.
+ *
+ * PagedMM1 (256 bytes pages) is made for small memories that are often forked,
+ * SparseMM1 (4 KiB pages) for large address spaces (up to the 24 bits external address),
+ * a 16 MiB memory only cost its page table (64 KiB) until it is used.
+ */
+template<std::size_t TPageSize>
+class BasicPagedMM1 : public codeg::MemoryModule
+{
+public:
+    explicit BasicPagedMM1(codeg::MemorySize memorySize);
+    BasicPagedMM1(const codeg::BasicPagedMM1<TPageSize>& r) = default;
+    ~BasicPagedMM1() override = default;
+
+    bool set(codeg::MemoryAddress address, uint8_t data) final
+    {
+        if (address < this->_g_memorySize)
+        {
+            this->getWritablePage(address)[address % TPageSize] = data;
+            ++this->_g_modificationCount;
+            return true;
+        }
+        return false;
+    }
+    bool set(codeg::MemoryAddress address, uint8_t* data, codeg::MemorySize dataSize) final;
+    bool get(codeg::MemoryAddress address, uint8_t& data) const final
+    {
+        if (address < this->_g_memorySize)
+        {
+            const std::shared_ptr<Page>& page = this->g_pages[address / TPageSize];
+            data = page ? (*page)[address % TPageSize] : 0;
+            return true;
+        }
+        return false;
+    }
+    bool get(codeg::MemoryAddress startAddress, codeg::MemorySize addressCount, uint8_t* data, codeg::MemorySize dataSize) const final;
+
+    [[nodiscard]] std::string getType() const override;
+    [[nodiscard]] bool isSlotCompatible(const std::string& slotType) const override;
+
+    //Share every page with the new module
+    [[nodiscard]] std::shared_ptr<codeg::MemoryModule> fork() const override;
+
+    //Layout : memory size (uint64), page size (uint64), allocated page count (uint64),
+    //then every allocated page with its index (uint64) and its content
+    void saveState(codeg::SnapshotWriter& writer) const override;
+    void loadState(codeg::SnapshotReader& reader) override;
+
+    [[nodiscard]] std::size_t getAllocatedPageCount() const;
+    //Number of pages owned only by this module (allocated and not shared)
+    [[nodiscard]] std::size_t getOwnedPageCount() const;
+
+private:
+    using Page = std::array<uint8_t, TPageSize>;
+
+    //Copy the page if it is shared (or allocate it), the module must not be forked at the same time
+    Page& getWritablePage(codeg::MemoryAddress address)
+    {
+        std::shared_ptr<Page>& page = this->g_pages[address / TPageSize];
+        if (!page)
+        {
+            page = std::make_shared<Page>();
+            page->fill(0);
+        }
+        else if (page.use_count() > 1)
+        {
+            page = std::make_shared<Page>(*page);
+        }
+        return *page;
+    }
+
+    std::vector<std::shared_ptr<Page> > g_pages;
+};
+
+template<>
+std::string BasicPagedMM1<CG_PAGEDMM1_PAGE_SIZE>::getType() const;
+template<>
+std::string BasicPagedMM1<CG_SPARSEMM1_PAGE_SIZE>::getType() const;
+
+using PagedMM1 = codeg::BasicPagedMM1<CG_PAGEDMM1_PAGE_SIZE>;
+using SparseMM1 = codeg::BasicPagedMM1<CG_SPARSEMM1_PAGE_SIZE>;
+extern template class codeg::BasicPagedMM1<CG_PAGEDMM1_PAGE_SIZE>;
+extern template class codeg::BasicPagedMM1<CG_SPARSEMM1_PAGE_SIZE>;
+
+}//end codeg
+
+#endif // C_PAGEDMM1_HPP_INCLUDED
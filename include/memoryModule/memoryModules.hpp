@@ -25,6 +25,9 @@
 namespace codeg
 {
 
+class SnapshotWriter;
+class SnapshotReader;
+
 using AddressBusSize = uint8_t;
 using MemorySize = std::size_t;
 using MemoryAddress = std::size_t;
@@ -66,9 +69,50 @@ public:
     virtual bool get(codeg::MemoryAddress startAddress, codeg::MemorySize addressCount, uint8_t* data, codeg::MemorySize dataSize) const = 0;
 
     [[nodiscard]] virtual std::string getType() const = 0;
+    //A module can be plugged in a slot of another type if it behave the same way
+    [[nodiscard]] virtual bool isSlotCompatible(const std::string& slotType) const
+    {
+        return this->getType() == slotType;
+    }
+
+    //Create an independent copy with the same content, cheap if the module can share its content (copy-on-write)
+    [[nodiscard]] virtual std::shared_ptr<codeg::MemoryModule> fork() const = 0;
+
+    //Save/restore the memory content, the state must start with the memory size (uint64_t)
+    //and the restored module must have the same size
+    virtual void saveState(codeg::SnapshotWriter& writer) const = 0;
+    virtual void loadState(codeg::SnapshotReader& reader) = 0;
+
+    //Writes are always refused, the content can only change with loadState()
+    [[nodiscard]] virtual bool isReadOnly() const
+    {
+        return false;
+    }
+
+    //Incremented on every write, used to invalidate data derived from the memory content
+    [[nodiscard]] uint64_t getModificationCount() const
+    {
+        return this->_g_modificationCount;
+    }
+
+    //Contiguous content of getMemorySize() bytes used directly by the fast paths (nullptr if the module can't provide it),
+    //stable until the module is restored with loadState(), a direct write must be followed by markModified()
+    [[nodiscard]] virtual const uint8_t* getReadSpan() const
+    {
+        return nullptr;
+    }
+    [[nodiscard]] virtual uint8_t* getWriteSpan()
+    {
+        return nullptr;
+    }
+    void markModified()
+    {
+        ++this->_g_modificationCount;
+    }
 
 protected:
     codeg::MemorySize _g_memorySize;
+    uint64_t _g_modificationCount{0};
 };
 
 struct MemoryModuleSlot
@@ -79,6 +123,64 @@ struct MemoryModuleSlot
     codeg::AddressBusSize _slotBusSizeCapacity;
     bool _isSourceCapable;
     bool _isPluggable;
+
+    //Spans of the plugged module, kept up to date by MemoryModuleSlotCapable
+    const uint8_t* _readSpan{nullptr};
+    uint8_t* _writeSpan{nullptr};
+    codeg::MemorySize _spanSize{0};
+
+    //Read a byte like MemoryModule::get(), an out of range or missing memory give 0
+    [[nodiscard]] uint8_t read(codeg::MemoryAddress address) const
+    {
+        if (address < this->_spanSize && this->_readSpan != nullptr)
+        {
+            return this->_readSpan[address];
+        }
+        uint8_t data = 0;
+        if (this->_mem)
+        {
+            this->_mem->get(address, data);
+        }
+        return data;
+    }
+    //Write a byte like MemoryModule::set()
+    bool write(codeg::MemoryAddress address, uint8_t data) const
+    {
+        if (address < this->_spanSize && this->_writeSpan != nullptr)
+        {
+            this->_writeSpan[address] = data;
+            this->_mem->markModified();
+            return true;
+        }
+        return this->_mem ? this->_mem->set(address, data) : false;
+    }
+};
+
+/*
+ * Memory modules kept as forks instead of being serialized (in-memory snapshots, see SnapshotWriter::setMemoryStore()).
+ * A module that didn't change since the previous store is shared with it, so unchanged modules cost nothing.
+ */
+class MemoryModuleStore
+{
+public:
+    MemoryModuleStore() = default;
+    ~MemoryModuleStore() = default;
+
+    void save(const std::shared_ptr<codeg::MemoryModule>& memoryModule, const codeg::MemoryModuleStore* previous);
+    //Restore the module saved at this index, it's replaced by a fork only if it changed since it was saved
+    void load(std::size_t index, std::shared_ptr<codeg::MemoryModule>& memoryModule) const;
+
+    //Bytes of the writable modules that aren't shared with the previous store
+    [[nodiscard]] std::size_t getUnsharedSize(const codeg::MemoryModuleStore* previous) const;
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<codeg::MemoryModule> _source; //Plugged module when it was saved
+        uint64_t _modificationCount;
+        std::shared_ptr<const codeg::MemoryModule> _image;
+    };
+    std::vector<Entry> g_entries;
 };
 
 class MemoryModuleSlotCapable
@@ -91,11 +193,12 @@ public:
     {
         if (index < this->_g_memorySlots.size())
         {
-            if (this->_g_memorySlots[index]._isPluggable && (this->_g_memorySlots[index]._slotType == memoryModule->getType()))
+            if (this->_g_memorySlots[index]._isPluggable && memoryModule->isSlotCompatible(this->_g_memorySlots[index]._slotType))
             {
                 if (this->_g_memorySlots[index]._mem == nullptr)
                 {
                     this->_g_memorySlots[index]._mem = memoryModule;
+                    UpdateMemorySpans(this->_g_memorySlots[index]);
                     return true;
                 }
             }
@@ -110,6 +213,7 @@ public:
             {
                 std::shared_ptr<codeg::MemoryModule> tmpMemory = this->_g_memorySlots[index]._mem;
                 this->_g_memorySlots[index]._mem.reset();
+                UpdateMemorySpans(this->_g_memorySlots[index]);
                 return tmpMemory;
             }
         }
@@ -171,7 +275,31 @@ public:
         return this->_g_memorySource;
     }
 
+    //Save/restore the memory source and every plugged module, a missing or different module is
+    //replaced by a new one created with GetNewMemoryModule() (the slot layout must be the same)
+    void saveMemorySlots(codeg::SnapshotWriter& writer) const;
+    void loadMemorySlots(codeg::SnapshotReader& reader);
+
+    //Plug a fork of every module of another object with the same slot layout
+    void forkMemorySlots(const codeg::MemoryModuleSlotCapable& parent);
+
+    //Must be called after a plugged module was restored directly with MemoryModule::loadState()
+    void updateMemorySpans()
+    {
+        for (auto& slot : this->_g_memorySlots)
+        {
+            UpdateMemorySpans(slot);
+        }
+    }
+
 protected:
+    static void UpdateMemorySpans(codeg::MemoryModuleSlot& slot)
+    {
+        slot._readSpan = slot._mem ? slot._mem->getReadSpan() : nullptr;
+        slot._writeSpan = slot._mem ? slot._mem->getWriteSpan() : nullptr;
+        slot._spanSize = slot._mem ? slot._mem->getMemorySize() : 0;
+    }
+
     std::vector<codeg::MemoryModuleSlot> _g_memorySlots;
     std::size_t _g_memorySource{0};
 };
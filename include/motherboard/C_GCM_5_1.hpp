@@ -30,6 +30,8 @@
 
 #define CG_PERIPHERAL_MEMORY_SOURCESWITCH_MASK 0x01
 
+#define CG_GCM_5_1_DEFAULT_CLOCK_FREQUENCY 1000000.0 //Hz
+
 namespace codeg
 {
 
@@ -44,15 +46,33 @@ public:
 
     uint8_t updateDataSource() override;
 
-    [[nodiscard]] std::string getType() override;
+    //Execute one complete instruction using the predecoded instruction cache (same result as clockUntilSync)
+    bool step();
+
+    [[nodiscard]] std::string getType() const override;
+
+    //Board clock frequency (processor clock phases per second), a configuration that is not part of the state
+    void setClockFrequency(double frequency);
+    [[nodiscard]] double getClockFrequency() const;
+    //Time taken by the real board to execute every processor clock phase, in seconds
+    [[nodiscard]] double getSimulatedTime() const;
+
+    void saveState(codeg::SnapshotWriter& writer) const override;
+    void loadState(codeg::SnapshotReader& reader) override;
+
+    void fork(const codeg::Motherboard& parent) override;
 
-    void signal_ADDSRC_CLK(bool val);
-    void signal_JMPSRC_CLK(bool val);
-    void signal_PERIPHERAL_CLK(bool val);
-    void signal_SELECTING_RBEXT1(bool val);
-    void signal_SELECTING_RBEXT2(bool val);
+    void signal_ADDSRC_CLK();
+    void signal_JMPSRC_CLK();
+    void signal_PERIPHERAL_CLK();
+    void signal_SELECTING_RBEXT1();
+    void signal_SELECTING_RBEXT2();
 
     codeg::GP8B_5_1 _processor;
+
+private:
+    codeg::InstructionCache g_instructionCache;
+    double g_clockFrequency{CG_GCM_5_1_DEFAULT_CLOCK_FREQUENCY};
 };
 
 class MemoryController : public codeg::Peripheral
@@ -65,6 +85,11 @@ public:
 
     [[nodiscard]] codeg::PeripheralType getType() const override;
 
+    [[nodiscard]] bool isChangeTracked() const override;
+
+    void saveState(codeg::SnapshotWriter& writer) const override;
+    void loadState(codeg::SnapshotReader& reader) override;
+
 private:
     bool g_writeFlag{false};
     bool g_addressClock0Flag{false};
@@ -82,6 +107,8 @@ public:
     void update(codeg::Motherboard& motherboard, codeg::BusMap& busses, codeg::SignalMap& signals) override;
 
     [[nodiscard]] codeg::PeripheralType getType() const override;
+
+    [[nodiscard]] bool isChangeTracked() const override;
 };
 
 }//end codeg
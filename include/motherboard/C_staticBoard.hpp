@@ -0,0 +1,73 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef C_STATICBOARD_HPP_INCLUDED
+#define C_STATICBOARD_HPP_INCLUDED
+
+#include <memory>
+#include "motherboard/C_GCM_5_1.hpp"
+#include "engine/C_threadedEngine.hpp"
+#include "processor/C_ALUminium_1_1.hpp"
+#include "memoryModule/C_MM1.hpp"
+
+namespace codeg
+{
+
+/*
+ * GCM_5_1_SPS1 composed at compile time with a known ALU and processor RAM type.
+ * The board keep the dynamic interface (slots, peripherals, registry) but run() use an engine
+ * specialised on TAlu/TMemory so the whole fetch/execute/ALU path can be inlined.
+ */
+template<class TAlu, class TMemory>
+class StaticBoard : public codeg::GCM_5_1_SPS1
+{
+public:
+    StaticBoard() :
+            codeg::GCM_5_1_SPS1(),
+            g_engine(*this)
+    {
+        this->_processor._alu = std::make_shared<TAlu>();
+    }
+    ~StaticBoard() override = default;
+
+    StaticBoard(const StaticBoard&) = delete;
+    StaticBoard& operator=(const StaticBoard&) = delete;
+
+    //Execute complete instructions with the static engine, the processor RAM must be a TMemory
+    codeg::RunResult run(std::size_t maxInstructions, const codeg::StopConditions& conditions)
+    {
+        return this->g_engine.run(maxInstructions, conditions);
+    }
+    std::size_t run(std::size_t instructionCount)
+    {
+        return this->g_engine.run(instructionCount);
+    }
+
+    [[nodiscard]] codeg::ExecutionEngine& getEngine()
+    {
+        return this->g_engine;
+    }
+
+private:
+    codeg::BasicThreadedEngine<TAlu, TMemory> g_engine;
+};
+
+using StaticEngineSPS1 = codeg::BasicThreadedEngine<codeg::Aluminium_1_1, codeg::MM1>;
+using StaticBoardSPS1 = codeg::StaticBoard<codeg::Aluminium_1_1, codeg::MM1>;
+
+}//end codeg
+
+#endif // C_STATICBOARD_HPP_INCLUDED
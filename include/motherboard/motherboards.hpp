@@ -18,12 +18,23 @@
 #define C_MOTHERBOARD_HPP_INCLUDED
 
 #include <cstdint>
+#include <filesystem>
+#include <vector>
 #include "memoryModule/memoryModules.hpp"
 #include "peripheral/C_peripheral.hpp"
 
 namespace codeg
 {
 
+class Console;
+
+struct MemoryAccess
+{
+    std::size_t _slot;
+    codeg::MemoryAddress _address;
+    bool _write;
+};
+
 class Motherboard : public codeg::MemoryModuleSlotCapable, public codeg::PeripheralSlotCapable
 {
 protected:
@@ -47,10 +58,59 @@ public:
 
     virtual uint8_t updateDataSource() = 0;
 
-    [[nodiscard]] virtual std::string getType() = 0;
+    [[nodiscard]] virtual std::string getType() const = 0;
+
+    //Save the complete machine state (memories, peripherals, processor), return false if the file can't be written
+    bool saveSnapshot(const std::filesystem::path& path) const;
+    //Restore a snapshot of a board with the same type, throw a codeg::Error if the snapshot doesn't match
+    void loadSnapshot(const std::filesystem::path& path);
+    //Same as loadSnapshot() with the content of a snapshot file
+    void loadSnapshotData(const uint8_t* data, std::size_t size);
+
+    virtual void saveState(codeg::SnapshotWriter& writer) const;
+    virtual void loadState(codeg::SnapshotReader& reader);
+
+    //Take the state of a board with the same type, memory modules are forked (see MemoryModule::fork())
+    //and the peripherals state is copied (the same peripherals must be plugged)
+    virtual void fork(const codeg::Motherboard& parent);
+
+    //Peripherals report the accesses they do on the motherboard memory slots, only kept when the tracking is enabled (watchpoints)
+    void reportMemoryAccess(std::size_t slot, codeg::MemoryAddress address, bool write)
+    {
+        if (this->g_memoryAccessTracking)
+        {
+            this->g_memoryAccesses.push_back({slot, address, write});
+        }
+    }
+    void setMemoryAccessTracking(bool enable)
+    {
+        this->g_memoryAccessTracking = enable;
+        this->g_memoryAccesses.clear();
+    }
+    [[nodiscard]] const std::vector<codeg::MemoryAccess>& getMemoryAccesses() const
+    {
+        return this->g_memoryAccesses;
+    }
+    void clearMemoryAccesses()
+    {
+        this->g_memoryAccesses.clear();
+    }
+
+    //Console used by the board and its peripherals (codeg::varConsole if none is set), it's not copied by fork()
+    void setConsole(codeg::Console* console)
+    {
+        this->g_console = console;
+    }
+    [[nodiscard]] codeg::Console& getConsole() const;
 
 protected:
     codeg::MemoryAddress _g_programCounter{0};
+
+private:
+    std::vector<codeg::MemoryAccess> g_memoryAccesses;
+    bool g_memoryAccessTracking{false};
+
+    codeg::Console* g_console{nullptr};
 };
 
 class MotherboardClassTypeBase
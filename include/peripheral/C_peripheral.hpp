@@ -27,6 +27,8 @@ namespace codeg
 {
 
 class Motherboard;
+class SnapshotWriter;
+class SnapshotReader;
 
 enum PeripheralType
 {
@@ -53,6 +55,26 @@ public:
 
     virtual void update(codeg::Motherboard& motherboard, codeg::BusMap& busses, codeg::SignalMap& signals) = 0;
 
+    //A peripheral that track its changes must increment the change count every time its internal state
+    //change or when it have an effect outside the simulation (ex: printing), needed for busy-wait fast-forward
+    [[nodiscard]] virtual bool isChangeTracked() const
+    {
+        return false;
+    }
+    [[nodiscard]] uint64_t getChangeCount() const
+    {
+        return this->_g_changeCount;
+    }
+
+    //Save/restore the internal state, a peripheral without state don't have to override them
+    virtual void saveState([[maybe_unused]] codeg::SnapshotWriter& writer) const
+    {}
+    virtual void loadState([[maybe_unused]] codeg::SnapshotReader& reader)
+    {}
+
+protected:
+    uint64_t _g_changeCount{0};
+
 private:
     bool g_isSelected{false};
 };
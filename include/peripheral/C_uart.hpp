@@ -18,6 +18,7 @@
 #define C_UART_PERIPHERAL_CARD_A_1_1_HPP_INCLUDED
 
 #include "peripheral/C_peripheral.hpp"
+#include <ostream>
 #include <string>
 
 #define CG_PERIPHERAL_UART_RST_RX_FLAG_MASK 0x01
@@ -38,15 +39,25 @@ public:
 
     [[nodiscard]] codeg::PeripheralType getType() const override;
 
+    [[nodiscard]] bool isChangeTracked() const override;
+
     [[nodiscard]] const std::string& getInputBuffer() const;
     void setInputBuffer(std::string input);
 
     void clearOutputBuffer();
     const std::string& getOutputBuffer() const;
 
+    //Every transmitted byte is also written in this stream (nullptr to disable)
+    void setOutputStream(std::ostream* stream);
+
+    //The output stream is not part of the state
+    void saveState(codeg::SnapshotWriter& writer) const override;
+    void loadState(codeg::SnapshotReader& reader) override;
+
 private:
     std::string g_inputBuffer;
     std::string g_outputBuffer;
+    std::ostream* g_outputStream{nullptr};
 
     uint8_t g_txData{0};
 
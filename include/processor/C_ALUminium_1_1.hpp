@@ -18,6 +18,8 @@
 #define C_ALUMINIUM_1_1_HPP_INCLUDED
 
 #include <cstdint>
+#include <array>
+#include <utility>
 #include "processor/C_alu.hpp"
 
 namespace codeg
@@ -60,24 +62,82 @@ enum AluminiumOperations_1_1 : uint8_t
     ALU_1_1_OP_OPAR  //Write to the operation left/right and return accumulator right
 };
 
-class Aluminium_1_1 : public codeg::Alu
+[[nodiscard]] const char* AluminiumOperationToString(uint8_t operation);
+
+class Aluminium_1_1 final : public codeg::Alu
 {
 public:
-    Aluminium_1_1() = default;
+    Aluminium_1_1();
     ~Aluminium_1_1() override = default;
 
-    void setOperationLeft(uint8_t val) override;
-    void setOperation(uint8_t val) override;
-    void setOperationRight(uint8_t val) override;
+    void setOperationLeft(uint8_t val) final
+    {
+        if (this->g_writeAccumulator)
+        {
+            this->g_accumulatorLeft = val;
+        }
+        else
+        {
+            this->g_operationLeft = val;
+        }
+        this->g_dirty = true;
+    }
+    void setOperation(uint8_t val) final;
+    void setOperationRight(uint8_t val) final
+    {
+        if (this->g_writeAccumulator)
+        {
+            this->g_accumulatorRight = val;
+        }
+        else
+        {
+            this->g_operationRight = val;
+        }
+        this->g_dirty = true;
+    }
+
+    //The result is only computed when it is read
+    [[nodiscard]] uint8_t getResult() const final
+    {
+        if (this->g_dirty)
+        {
+            this->_g_result = this->g_kernel(*this);
+            this->g_dirty = false;
+        }
+        return this->_g_result;
+    }
+
+    [[nodiscard]] bool getPackedState(uint64_t& state) const final
+    {//The result is deduced from the other registers
+        state = static_cast<uint64_t>(this->g_accumulatorLeft) |
+                (static_cast<uint64_t>(this->g_accumulatorRight)<<8) |
+                (static_cast<uint64_t>(this->g_operationLeft)<<16) |
+                (static_cast<uint64_t>(this->g_operationRight)<<24) |
+                (static_cast<uint64_t>(this->g_operation)<<32);
+        return true;
+    }
+
+    void saveState(codeg::SnapshotWriter& writer) const final;
+    void loadState(codeg::SnapshotReader& reader) final;
 
 private:
-    void updateResult();
+    using Kernel = uint8_t (*)(const codeg::Aluminium_1_1& alu);
+
+    template<uint8_t TOperation>
+    static uint8_t kernel(const codeg::Aluminium_1_1& alu);
+    template<std::size_t... TIndex>
+    static constexpr std::array<Kernel, 256> makeKernelTable([[maybe_unused]] std::index_sequence<TIndex...> indexes);
+    static const std::array<Kernel, 256>& getKernels();
 
     uint8_t g_accumulatorLeft{0};
     uint8_t g_accumulatorRight{0};
     uint8_t g_operationLeft{0};
     uint8_t g_operationRight{0};
     uint8_t g_operation{0};
+
+    bool g_writeAccumulator{false}; //True for ALU_1_1_OP_AOPL and ALU_1_1_OP_AOPR
+    Kernel g_kernel;
+    mutable bool g_dirty{false};
 };
 
 }//end codeg
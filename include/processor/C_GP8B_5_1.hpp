@@ -19,6 +19,12 @@
 
 #include <cstdint>
 #include "processor/C_processor.hpp"
+#include "processor/C_instructionCache.hpp"
+
+#define CG_GP8B_5_1_INSTRUCTION_PHASES 3 //One per state (sync bit, instruction set, execution)
+#define CG_GP8B_5_1_ARGUMENT_PHASES 1 //Extra ADDSRC_CLK to skip the argument when the source bus is read
+#define CG_GP8B_5_1_PERIPHERAL_PHASES 1 //Extra PERIPHERAL_CLK given to the motherboard
+#define CG_GP8B_5_1_SKIP_PHASES 1 //Extra ADDSRC_CLK when an IF/IFNOT skip the next address
 
 namespace codeg
 {
@@ -46,6 +52,88 @@ public:
 
     [[nodiscard]] bool isSync() const override;
 
+    void saveState(codeg::SnapshotWriter& writer) const override;
+    void loadState(codeg::SnapshotReader& reader) override;
+
+    //Execute a complete instruction from a synchronized state without the clock state machine,
+    //the caller is responsible to move the program counter past the instruction and its argument
+    void executeDecoded(const codeg::DecodedInstruction& decoded);
+
+    [[nodiscard]] Stats getStat() const
+    {
+        return this->g_stat;
+    }
+    [[nodiscard]] uint8_t getInstruction() const
+    {
+        return this->g_instruction;
+    }
+    [[nodiscard]] uint8_t getArguments() const
+    {
+        return this->g_arguments;
+    }
+    void setLastInstruction(uint8_t instruction, uint8_t arguments)
+    {
+        this->g_instruction = instruction;
+        this->g_arguments = arguments;
+    }
+
+    //Clock phases needed by a complete instruction on the real processor,
+    //the argument is needed as a taken IF/IFNOT skip cost one more phase
+    [[nodiscard]] static constexpr uint64_t getInstructionPhases(uint8_t instruction, uint8_t argument)
+    {
+        const auto opcode = static_cast<codeg::CodegBinaryRev1>(instruction&CG_CODEGBINARYREV1_OPCODE_MASK);
+        const auto bus = static_cast<codeg::CodegBinaryRev1Busses>(instruction&CG_CODEGBINARYREV1_BUSSES_MASK);
+
+        uint64_t phases = CG_GP8B_5_1_INSTRUCTION_PHASES;
+        if ( (bus == codeg::CodegBinaryRev1Busses::READABLE_SOURCE) && (opcode != codeg::CodegBinaryRev1::OPCODE_JMPSRC_CLK) )
+        {//The jump instruction inhibit a clock to the next address
+            phases += CG_GP8B_5_1_ARGUMENT_PHASES;
+        }
+        if (opcode == codeg::CodegBinaryRev1::OPCODE_PERIPHERAL_CLK)
+        {
+            phases += CG_GP8B_5_1_PERIPHERAL_PHASES;
+        }
+        if ( ((opcode == codeg::CodegBinaryRev1::OPCODE_IF) && (argument != 0)) ||
+             ((opcode == codeg::CodegBinaryRev1::OPCODE_IFNOT) && (argument == 0)) )
+        {
+            phases += CG_GP8B_5_1_SKIP_PHASES;
+        }
+        return phases;
+    }
+
+    //Clock phases since the start (kept by the resets), every engine charge getInstructionPhases() per instruction
+    [[nodiscard]] uint64_t getPhaseCount() const
+    {
+        return this->g_phaseCount;
+    }
+    void addPhases(uint64_t phases)
+    {
+        this->g_phaseCount += phases;
+    }
+    void setPhaseCount(uint64_t phases)
+    {
+        this->g_phaseCount = phases;
+    }
+
+    [[nodiscard]] uint16_t getRamAddress() const
+    {
+        return this->g_ramAddress;
+    }
+    void setRamAddress(uint16_t address)
+    {
+        this->g_ramAddress = address;
+    }
+
+    //Raw storage written by the native code of the NativeBlockEngine
+    [[nodiscard]] uint16_t* getRamAddressData()
+    {
+        return &this->g_ramAddress;
+    }
+    [[nodiscard]] uint64_t* getPhaseCountData()
+    {
+        return &this->g_phaseCount;
+    }
+
 private:
     void executeInstruction();
     void computeArgument();
@@ -55,6 +143,8 @@ private:
     uint8_t g_arguments{0};
 
     uint16_t g_ramAddress{0};
+
+    uint64_t g_phaseCount{0};
 };
 
 }//end codeg
@@ -22,6 +22,9 @@
 namespace codeg
 {
 
+class SnapshotWriter;
+class SnapshotReader;
+
 class Alu
 {
 public:
@@ -32,13 +35,22 @@ public:
     virtual void setOperation(uint8_t val) = 0;
     virtual void setOperationRight(uint8_t val) = 0;
 
-    [[nodiscard]] uint8_t getResult() const
+    [[nodiscard]] virtual uint8_t getResult() const
     {
         return this->_g_result;
     }
 
+    //Pack the whole internal state in 64bits, return false if the ALU can't (disable busy-wait fast-forward)
+    [[nodiscard]] virtual bool getPackedState([[maybe_unused]] uint64_t& state) const
+    {
+        return false;
+    }
+
+    virtual void saveState(codeg::SnapshotWriter& writer) const = 0;
+    virtual void loadState(codeg::SnapshotReader& reader) = 0;
+
 protected:
-    uint8_t _g_result{0};
+    mutable uint8_t _g_result{0}; //Can be computed lazily by getResult()
 };
 
 }//end codeg
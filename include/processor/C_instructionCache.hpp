@@ -0,0 +1,71 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef C_INSTRUCTIONCACHE_HPP_INCLUDED
+#define C_INSTRUCTIONCACHE_HPP_INCLUDED
+
+#include <cstdint>
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include "memoryModule/memoryModules.hpp"
+#include "C_codeg.hpp"
+
+#define CG_INSTRUCTIONCACHE_PAGE_SIZE 256
+
+namespace codeg
+{
+
+struct DecodedInstruction
+{
+    uint8_t _instruction{0};
+    codeg::CodegBinaryRev1 _opcode{codeg::CodegBinaryRev1::OPCODE_BWRITE1_CLK};
+    codeg::CodegBinaryRev1Busses _bus{codeg::CodegBinaryRev1Busses::READABLE_SOURCE};
+    uint8_t _immediate{0}; //Only meaningful when _bus is READABLE_SOURCE
+    bool _valid{false};
+
+    codeg::MemoryAddress _nextAddress{0}; //Address of the next instruction if there is no jump/skip
+};
+
+codeg::DecodedInstruction DecodeInstruction(const codeg::MemoryModule& memory, codeg::MemoryAddress address);
+//One line in the .rcg style, ex: "[0x0C] BRAMADD2_CLK <SOURCE> [0x00]"
+std::string DisassembleInstruction(const codeg::DecodedInstruction& decoded);
+
+class InstructionCache
+{
+public:
+    InstructionCache() = default;
+    ~InstructionCache() = default;
+
+    //The whole cache is invalidated when the memory module change or when it was written since the last call
+    [[nodiscard]] const codeg::DecodedInstruction& get(const std::shared_ptr<codeg::MemoryModule>& memory, codeg::MemoryAddress address);
+
+    void clear();
+
+private:
+    using Page = std::array<codeg::DecodedInstruction, CG_INSTRUCTIONCACHE_PAGE_SIZE>;
+
+    std::vector<std::unique_ptr<Page> > g_pages;
+    std::shared_ptr<const codeg::MemoryModule> g_memory;
+    uint64_t g_modificationCount{0};
+
+    codeg::DecodedInstruction g_outOfRange;
+};
+
+}//end codeg
+
+#endif // C_INSTRUCTIONCACHE_HPP_INCLUDED
@@ -41,25 +41,74 @@
 namespace codeg
 {
 
+//Fixed layout of the SPS1 busses/signals, usable directly as an index in the BusMap/SignalMap of a ProcessorSPS1
+enum BusSPS1 : codeg::BusIndex
+{
+    BUS_SPS1_BJMPSRC,
+    BUS_SPS1_BWRITE1,
+    BUS_SPS1_BWRITE2,
+    BUS_SPS1_BREAD1,
+    BUS_SPS1_BREAD2,
+    BUS_SPS1_NUMBER,
+    BUS_SPS1_BDATASRC,
+    BUS_SPS1_BPCS,
+
+    BUS_SPS1_COUNT
+};
+enum SignalSPS1 : codeg::SignalIndex
+{
+    SIGNAL_SPS1_ADDSRC_CLK,
+    SIGNAL_SPS1_JMPSRC_CLK,
+    SIGNAL_SPS1_PERIPHERAL_CLK,
+    SIGNAL_SPS1_SELECTING_RBEXT1,
+    SIGNAL_SPS1_SELECTING_RBEXT2,
+
+    SIGNAL_SPS1_COUNT
+};
+
+constexpr const char* BusSPS1Names[BUS_SPS1_COUNT] = {
+    CG_PROC_SPS1_BUS_BJMPSRC,
+    CG_PROC_SPS1_BUS_BWRITE1,
+    CG_PROC_SPS1_BUS_BWRITE2,
+    CG_PROC_SPS1_BUS_BREAD1,
+    CG_PROC_SPS1_BUS_BREAD2,
+    CG_PROC_SPS1_BUS_NUMBER,
+    CG_PROC_SPS1_BUS_BDATASRC,
+    CG_PROC_SPS1_BUS_BPCS
+};
+constexpr codeg::BitSize BusSPS1BitSizes[BUS_SPS1_COUNT] = {24, 8, 8, 8, 8, 8, 8, 6};
+constexpr uint64_t BusSPS1Masks[BUS_SPS1_COUNT] = {
+    codeg::GetBusMask(BusSPS1BitSizes[BUS_SPS1_BJMPSRC]),
+    codeg::GetBusMask(BusSPS1BitSizes[BUS_SPS1_BWRITE1]),
+    codeg::GetBusMask(BusSPS1BitSizes[BUS_SPS1_BWRITE2]),
+    codeg::GetBusMask(BusSPS1BitSizes[BUS_SPS1_BREAD1]),
+    codeg::GetBusMask(BusSPS1BitSizes[BUS_SPS1_BREAD2]),
+    codeg::GetBusMask(BusSPS1BitSizes[BUS_SPS1_NUMBER]),
+    codeg::GetBusMask(BusSPS1BitSizes[BUS_SPS1_BDATASRC]),
+    codeg::GetBusMask(BusSPS1BitSizes[BUS_SPS1_BPCS])
+};
+
+constexpr const char* SignalSPS1Names[SIGNAL_SPS1_COUNT] = {
+    CG_PROC_SPS1_SIGNAL_ADDSRC_CLK,
+    CG_PROC_SPS1_SIGNAL_JMPSRC_CLK,
+    CG_PROC_SPS1_SIGNAL_PERIPHERAL_CLK,
+    CG_PROC_SPS1_SIGNAL_SELECTING_RBEXT1,
+    CG_PROC_SPS1_SIGNAL_SELECTING_RBEXT2
+};
+
 class ProcessorSPS1 : public codeg::MemoryModuleSlotCapable
 {
 public:
     ProcessorSPS1()
     {
-        this->_busses.add(CG_PROC_SPS1_BUS_BJMPSRC, 24);
-        this->_busses.add(CG_PROC_SPS1_BUS_BWRITE1, 8);
-        this->_busses.add(CG_PROC_SPS1_BUS_BWRITE2, 8);
-        this->_busses.add(CG_PROC_SPS1_BUS_BREAD1, 8);
-        this->_busses.add(CG_PROC_SPS1_BUS_BREAD2, 8);
-        this->_busses.add(CG_PROC_SPS1_BUS_NUMBER, 8);
-        this->_busses.add(CG_PROC_SPS1_BUS_BDATASRC, 8);
-        this->_busses.add(CG_PROC_SPS1_BUS_BPCS, 6);
-
-        this->_signals.add(CG_PROC_SPS1_SIGNAL_ADDSRC_CLK);
-        this->_signals.add(CG_PROC_SPS1_SIGNAL_JMPSRC_CLK);
-        this->_signals.add(CG_PROC_SPS1_SIGNAL_PERIPHERAL_CLK);
-        this->_signals.add(CG_PROC_SPS1_SIGNAL_SELECTING_RBEXT1);
-        this->_signals.add(CG_PROC_SPS1_SIGNAL_SELECTING_RBEXT2);
+        for (codeg::BusIndex i=0; i<BUS_SPS1_COUNT; ++i)
+        {
+            this->_busses.add(BusSPS1Names[i], BusSPS1BitSizes[i]);
+        }
+        for (codeg::SignalIndex i=0; i<SIGNAL_SPS1_COUNT; ++i)
+        {
+            this->_signals.add(SignalSPS1Names[i]);
+        }
     }
     ~ProcessorSPS1() override = default;
 
@@ -80,6 +129,10 @@ public:
 
     [[nodiscard]] virtual bool isSync() const = 0;
 
+    //Save/restore the bus values and the internal state (the ALU and the memory slots are not included)
+    virtual void saveState(codeg::SnapshotWriter& writer) const = 0;
+    virtual void loadState(codeg::SnapshotReader& reader) = 0;
+
     codeg::BusMap _busses;
     codeg::SignalMap _signals;
     std::shared_ptr<codeg::Alu> _alu;
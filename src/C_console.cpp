@@ -17,6 +17,8 @@
 #include "C_console.hpp"
 #include <iostream>
 #include <fstream>
+#include <ctime>
+#include <iomanip>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -29,8 +31,16 @@
 namespace codeg
 {
 
+Console::Console(codeg::Console& output, std::string prefix) :
+        g_output(&output),
+        g_prefix(std::move(prefix))
+{
+}
+
 bool Console::logOpen(const std::filesystem::path& path)
 {
+    std::scoped_lock<std::mutex> lock(this->g_mutex);
+
     if ( this->g_log.is_open() )
     {
         return false;
@@ -47,9 +57,57 @@ bool Console::logOpen(const std::filesystem::path& path)
 }
 void Console::logClose()
 {
+    std::scoped_lock<std::mutex> lock(this->g_mutex);
     this->g_log.close();
 }
 
+Console::Line& Console::getThreadLine()
+{
+    thread_local Line line;
+    return line;
+}
+std::string Console::getLocalTime()
+{
+    const std::time_t t = std::time(nullptr);
+    std::tm localTime{};
+
+#ifdef _WIN32
+    localtime_s(&localTime, &t);
+#else
+    localtime_r(&t, &localTime);
+#endif
+
+    std::ostringstream stream;
+    stream << std::put_time(&localTime, "%d.%m.%Y - %H:%M:%S");
+    return stream.str();
+}
+
+void Console::writeLine()
+{
+    Line& line = getThreadLine();
+
+    this->write(line._console.str(), line._log.str());
+
+    line._console.str({});
+    line._log.str({});
+}
+void Console::write(const std::string& consoleLine, const std::string& logLine)
+{
+    if (this->g_output != nullptr)
+    {
+        this->g_output->write(this->g_prefix + consoleLine, this->g_prefix + logLine);
+        return;
+    }
+
+    std::scoped_lock<std::mutex> lock(this->g_mutex);
+
+    std::cout << consoleLine << "\x1b[0m\n";
+    if (this->g_log)
+    {
+        this->g_log << logLine << '\n';
+    }
+}
+
 codeg::Console* varConsole{nullptr};
 
 int ConsoleInit()
@@ -0,0 +1,179 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include "C_inputLog.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace codeg
+{
+
+namespace
+{
+
+void WriteVarInt(std::string& out, uint64_t value)
+{
+    do
+    {
+        auto byte = static_cast<uint8_t>(value & 0x7F);
+        value >>= 7;
+        if (value != 0)
+        {
+            byte |= 0x80;
+        }
+        out.push_back(static_cast<char>(byte));
+    }
+    while (value != 0);
+}
+uint64_t ReadVarInt(const std::string& in, std::size_t& position)
+{
+    uint64_t value = 0;
+    for (unsigned int shift=0; shift<64; shift+=7)
+    {
+        if (position >= in.size())
+        {
+            break;
+        }
+        const auto byte = static_cast<uint8_t>(in[position++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ( (byte & 0x80) == 0 )
+        {
+            return value;
+        }
+    }
+    throw codeg::Error("input log: bad integer");
+}
+
+}//end
+
+void InputLog::add(codeg::InputEvent event)
+{
+    if ( !this->g_events.empty() && (event._cycle < this->g_events.back()._cycle) )
+    {
+        throw codeg::Error("input log: an event can't be before the previous one");
+    }
+    if (event._type == codeg::InputEventType::EVENT_END)
+    {
+        throw codeg::Error("input log: the end is not an event");
+    }
+    this->g_endCycle = std::max(this->g_endCycle, event._cycle);
+    this->g_events.push_back(std::move(event));
+}
+void InputLog::clear()
+{
+    this->g_events.clear();
+    this->g_endCycle = 0;
+}
+
+const std::vector<codeg::InputEvent>& InputLog::getEvents() const
+{
+    return this->g_events;
+}
+
+void InputLog::setEndCycle(uint64_t cycle)
+{
+    this->g_endCycle = cycle;
+}
+uint64_t InputLog::getEndCycle() const
+{
+    return this->g_endCycle;
+}
+
+bool InputLog::saveToFile(const std::filesystem::path& path) const
+{
+    std::string data(CG_INPUTLOG_MAGIC, CG_INPUTLOG_MAGIC_SIZE);
+    data.push_back(static_cast<char>(CG_INPUTLOG_VERSION));
+
+    uint64_t lastCycle = 0;
+    for (const auto& event : this->g_events)
+    {
+        data.push_back(static_cast<char>(event._type));
+        WriteVarInt(data, event._cycle - lastCycle);
+        WriteVarInt(data, event._target);
+        WriteVarInt(data, event._data.size());
+        data += event._data;
+        lastCycle = event._cycle;
+    }
+    data.push_back(static_cast<char>(codeg::InputEventType::EVENT_END));
+    WriteVarInt(data, std::max(this->g_endCycle, lastCycle) - lastCycle);
+    WriteVarInt(data, 0);
+    WriteVarInt(data, 0);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file);
+}
+void InputLog::loadFromFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw codeg::Error("input log: can't read the file "+path.string());
+    }
+    const std::string data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    if ( (data.size() < CG_INPUTLOG_MAGIC_SIZE+1) || (std::memcmp(data.data(), CG_INPUTLOG_MAGIC, CG_INPUTLOG_MAGIC_SIZE) != 0) )
+    {
+        throw codeg::Error("input log: bad magic, not an input log");
+    }
+    if (static_cast<uint8_t>(data[CG_INPUTLOG_MAGIC_SIZE]) != CG_INPUTLOG_VERSION)
+    {
+        throw codeg::Error("input log: unsupported version");
+    }
+
+    this->clear();
+    std::size_t position = CG_INPUTLOG_MAGIC_SIZE+1;
+    uint64_t cycle = 0;
+    while (position < data.size())
+    {
+        const auto type = static_cast<uint8_t>(data[position++]);
+        if (type > static_cast<uint8_t>(codeg::InputEventType::EVENT_END))
+        {
+            throw codeg::Error("input log: unknown event");
+        }
+
+        codeg::InputEvent event;
+        event._type = static_cast<codeg::InputEventType>(type);
+        cycle += ReadVarInt(data, position);
+        event._cycle = cycle;
+        event._target = ReadVarInt(data, position);
+
+        const uint64_t size = ReadVarInt(data, position);
+        if (size > data.size() - position)
+        {
+            throw codeg::Error("input log: truncated event");
+        }
+        event._data.assign(data, position, static_cast<std::size_t>(size));
+        position += static_cast<std::size_t>(size);
+
+        if (event._type == codeg::InputEventType::EVENT_END)
+        {
+            this->g_endCycle = cycle;
+            return;
+        }
+        this->g_events.push_back(std::move(event));
+    }
+    throw codeg::Error("input log: truncated log, no end");
+}
+
+}//end codeg
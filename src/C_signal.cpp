@@ -22,27 +22,28 @@ namespace codeg
 
 //Signal
 
-void Signal::call(bool val)
+void Signal::detach(const void* object)
 {
-    this->g_value = val;
-    if (this->g_function)
+    for (auto it=this->g_listeners.begin(); it!=this->g_listeners.end();)
     {
-        this->g_function(val);
+        if (it->_object == object)
+        {
+            it = this->g_listeners.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
     }
 }
-
-void Signal::attach(Signal::FunctionType func)
-{
-    this->g_function = std::move(func);
-}
 void Signal::detach()
 {
-    this->g_function = nullptr;
+    this->g_listeners.clear();
 }
 
-bool Signal::getValue() const
+std::size_t Signal::getListenerSize() const
 {
-    return this->g_value;
+    return this->g_listeners.size();
 }
 
 //SignalMap
@@ -54,29 +55,27 @@ std::size_t SignalMap::getSize() const
 
 bool SignalMap::exist(const std::string& key) const
 {
-    return this->g_data.find(key) != this->g_data.end();
+    return this->g_names.find(key) != this->g_names.end();
 }
 
-const codeg::Signal& SignalMap::get(const std::string& key) const
+codeg::SignalIndex SignalMap::getIndex(const std::string& key) const
 {
-    auto it = this->g_data.find(key);
+    auto it = this->g_names.find(key);
 
-    if (it != this->g_data.end())
+    if (it != this->g_names.end())
     {
         return it->second;
     }
     throw codeg::Error("unknown signal : "+key);
 }
+
+const codeg::Signal& SignalMap::get(const std::string& key) const
+{
+    return this->g_data[this->getIndex(key)].second;
+}
 codeg::Signal& SignalMap::get(const std::string& key)
 {
-    auto it = this->g_data.find(key);
-
-    if (it != this->g_data.end())
-    {
-        return it->second;
-    }
-    throw codeg::Error("unknown signal : "+key);
+    return this->g_data[this->getIndex(key)].second;
 }
 
-
 }//end codeg
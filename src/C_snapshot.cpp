@@ -0,0 +1,236 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include "C_snapshot.hpp"
+#include "memoryModule/memoryModules.hpp"
+#include "memoryModule/C_ROM1.hpp"
+#include <fstream>
+#include <limits>
+
+namespace codeg
+{
+
+namespace
+{
+
+constexpr uint32_t SnapshotByteOrderMark = 0x01020304;
+
+}//end
+
+///SnapshotWriter
+
+SnapshotWriter::SnapshotWriter()
+{
+    this->writeBytes(CG_SNAPSHOT_MAGIC, CG_SNAPSHOT_MAGIC_SIZE);
+    this->write<uint32_t>(CG_SNAPSHOT_VERSION);
+    this->write<uint32_t>(SnapshotByteOrderMark);
+}
+
+void SnapshotWriter::writeBytes(const void* data, std::size_t size)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    this->g_data.insert(this->g_data.end(), bytes, bytes+size);
+}
+void SnapshotWriter::writeString(const std::string& str)
+{
+    this->write<uint64_t>(str.size());
+    this->writeBytes(str.data(), str.size());
+}
+void SnapshotWriter::align()
+{
+    this->g_data.resize( (this->g_data.size()+CG_SNAPSHOT_ALIGNMENT-1) / CG_SNAPSHOT_ALIGNMENT * CG_SNAPSHOT_ALIGNMENT, 0 );
+}
+
+void SnapshotWriter::beginSection(codeg::SnapshotTag tag)
+{
+    if (this->g_sectionOpen)
+    {
+        throw codeg::Error("snapshot: a section is already open");
+    }
+    this->align();
+    this->write<uint32_t>(tag);
+    this->write<uint32_t>(0);
+    this->write<uint64_t>(0); //Size, written by endSection()
+
+    this->g_sectionStart = this->g_data.size();
+    this->g_sectionOpen = true;
+}
+void SnapshotWriter::endSection()
+{
+    if (!this->g_sectionOpen)
+    {
+        throw codeg::Error("snapshot: no section is open");
+    }
+    this->align();
+
+    const uint64_t size = this->g_data.size() - this->g_sectionStart;
+    std::memcpy(this->g_data.data() + this->g_sectionStart - sizeof(uint64_t), &size, sizeof(uint64_t));
+    this->g_sectionOpen = false;
+}
+
+void SnapshotWriter::setMemoryStore(codeg::MemoryModuleStore* store, const codeg::MemoryModuleStore* previous)
+{
+    this->g_memoryStore = store;
+    this->g_previousMemoryStore = previous;
+}
+bool SnapshotWriter::hasMemoryStore() const
+{
+    return this->g_memoryStore != nullptr;
+}
+void SnapshotWriter::saveMemoryModule(const std::shared_ptr<codeg::MemoryModule>& memoryModule)
+{
+    if (this->g_memoryStore == nullptr)
+    {
+        throw codeg::Error("snapshot: no memory store");
+    }
+    this->g_memoryStore->save(memoryModule, this->g_previousMemoryStore);
+}
+
+const std::vector<uint8_t>& SnapshotWriter::getData() const
+{
+    return this->g_data;
+}
+std::vector<uint8_t> SnapshotWriter::takeData()
+{
+    return std::move(this->g_data);
+}
+bool SnapshotWriter::saveToFile(const std::filesystem::path& path) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(this->g_data.data()), static_cast<std::streamsize>(this->g_data.size()));
+    return static_cast<bool>(file);
+}
+
+///SnapshotReader
+
+SnapshotReader::SnapshotReader(const uint8_t* data, std::size_t size) :
+        g_data(data),
+        g_size(size)
+{
+    if ( (size < CG_SNAPSHOT_MAGIC_SIZE) || (std::memcmp(data, CG_SNAPSHOT_MAGIC, CG_SNAPSHOT_MAGIC_SIZE) != 0) )
+    {
+        throw codeg::Error("snapshot: bad magic, not a snapshot");
+    }
+    this->g_position = CG_SNAPSHOT_MAGIC_SIZE;
+
+    if (this->read<uint32_t>() != CG_SNAPSHOT_VERSION)
+    {
+        throw codeg::Error("snapshot: unsupported version");
+    }
+    if (this->read<uint32_t>() != SnapshotByteOrderMark)
+    {
+        throw codeg::Error("snapshot: the byte order doesn't match");
+    }
+}
+
+const uint8_t* SnapshotReader::readBytes(std::size_t size)
+{
+    const std::size_t end = this->g_sectionOpen ? this->g_sectionEnd : this->g_size;
+    if (size > end - this->g_position)
+    {
+        throw codeg::Error("snapshot: unexpected end of data");
+    }
+
+    const uint8_t* data = this->g_data + this->g_position;
+    this->g_position += size;
+    return data;
+}
+std::string SnapshotReader::readString()
+{
+    const auto size = this->read<uint64_t>();
+    const uint8_t* data = this->readBytes(size);
+    return {reinterpret_cast<const char*>(data), size};
+}
+void SnapshotReader::align()
+{
+    const std::size_t position = (this->g_position+CG_SNAPSHOT_ALIGNMENT-1) / CG_SNAPSHOT_ALIGNMENT * CG_SNAPSHOT_ALIGNMENT;
+    static_cast<void>(this->readBytes(position - this->g_position));
+}
+
+void SnapshotReader::openSection(codeg::SnapshotTag tag)
+{
+    if (this->g_sectionOpen)
+    {
+        throw codeg::Error("snapshot: a section is already open");
+    }
+    this->align();
+
+    const auto sectionTag = this->read<uint32_t>();
+    static_cast<void>(this->read<uint32_t>());
+    const auto size = this->read<uint64_t>();
+
+    if (sectionTag != tag)
+    {
+        throw codeg::Error("snapshot: unexpected section");
+    }
+    if (size > this->g_size - this->g_position)
+    {
+        throw codeg::Error("snapshot: truncated section");
+    }
+
+    this->g_sectionEnd = this->g_position + size;
+    this->g_sectionOpen = true;
+}
+void SnapshotReader::closeSection()
+{
+    if (!this->g_sectionOpen)
+    {
+        throw codeg::Error("snapshot: no section is open");
+    }
+    this->align();
+    if (this->g_position != this->g_sectionEnd)
+    {
+        throw codeg::Error("snapshot: the section doesn't match the machine");
+    }
+    this->g_sectionOpen = false;
+}
+
+void SnapshotReader::setMemoryStore(const codeg::MemoryModuleStore* store)
+{
+    this->g_memoryStore = store;
+    this->g_memoryIndex = 0;
+}
+bool SnapshotReader::hasMemoryStore() const
+{
+    return this->g_memoryStore != nullptr;
+}
+void SnapshotReader::loadMemoryModule(std::shared_ptr<codeg::MemoryModule>& memoryModule)
+{
+    if (this->g_memoryStore == nullptr)
+    {
+        throw codeg::Error("snapshot: no memory store");
+    }
+    this->g_memoryStore->load(this->g_memoryIndex++, memoryModule);
+}
+
+std::shared_ptr<const codeg::ROMContent> MapSnapshotFile(const std::filesystem::path& path)
+{
+    try
+    {
+        return codeg::MapFileContent(path, std::numeric_limits<codeg::MemorySize>::max());
+    }
+    catch (const codeg::Error&)
+    {
+        throw codeg::Error("snapshot: can't read the file "+path.string());
+    }
+}
+
+}//end codeg
@@ -114,4 +114,50 @@ std::string ValueToHex(uint32_t val, unsigned int hexSize, bool removeExtraZero,
     return out;
 }
 
+std::size_t ReadValue(const char* str, uint64_t& value)
+{
+    uint64_t base = 10;
+    std::size_t size = 0;
+    if ( (str[0] == '0') && ((str[1] == 'x') || (str[1] == 'X')) )
+    {
+        base = 16;
+        size = 2;
+    }
+
+    const std::size_t firstDigit = size;
+    value = 0;
+    for (;; ++size)
+    {
+        const char c = str[size];
+        uint64_t digit;
+        if (c >= '0' && c <= '9')
+        {
+            digit = static_cast<uint64_t>(c - '0');
+        }
+        else if (base == 16 && c >= 'a' && c <= 'f')
+        {
+            digit = static_cast<uint64_t>(c - 'a') + 10;
+        }
+        else if (base == 16 && c >= 'A' && c <= 'F')
+        {
+            digit = static_cast<uint64_t>(c - 'A') + 10;
+        }
+        else
+        {
+            break;
+        }
+
+        if ( value > (UINT64_MAX - digit) / base )
+        {//Overflow
+            return 0;
+        }
+        value = value*base + digit;
+    }
+    return (size == firstDigit) ? 0 : size;
+}
+bool StringToValue(const std::string& str, uint64_t& value)
+{
+    return !str.empty() && (codeg::ReadValue(str.c_str(), value) == str.size());
+}
+
 }//end codeg
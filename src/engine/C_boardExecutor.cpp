@@ -0,0 +1,282 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include "engine/C_boardExecutor.hpp"
+#include <algorithm>
+#include <thread>
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#elif defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#endif
+
+namespace codeg
+{
+
+namespace
+{
+
+void SetCurrentThreadAffinity(std::size_t cpu)
+{
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu % CPU_SETSIZE, &cpuSet);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#elif defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << (cpu % (sizeof(DWORD_PTR)*8)));
+#else
+    (void)cpu;
+#endif
+}
+
+}//end
+
+BoardExecutor::BoardExecutor(std::size_t threadCount, std::size_t quantum) :
+        g_threadCount(threadCount),
+        g_quantum(quantum)
+{
+    if (this->g_threadCount == 0)
+    {
+        this->g_threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (this->g_quantum == 0)
+    {
+        throw codeg::Error("executor: the quantum can't be 0");
+    }
+}
+
+std::size_t BoardExecutor::addJob(codeg::ExecutionEngine& engine, std::size_t maxInstructions, const codeg::StopConditions& conditions)
+{
+    codeg::ExecutorJob& job = this->g_jobs.emplace_back();
+    job._engine = &engine;
+    job._maxInstructions = maxInstructions;
+    job._conditions = conditions;
+    return this->g_jobs.size()-1;
+}
+void BoardExecutor::clearJobs()
+{
+    this->g_jobs.clear();
+}
+
+std::size_t BoardExecutor::getJobCount() const
+{
+    return this->g_jobs.size();
+}
+const codeg::ExecutorJob& BoardExecutor::getJob(std::size_t index) const
+{
+    return this->g_jobs[index];
+}
+
+void BoardExecutor::setAffinity(bool enable)
+{
+    this->g_affinity = enable;
+}
+bool BoardExecutor::isAffinity() const
+{
+    return this->g_affinity;
+}
+
+std::size_t BoardExecutor::getThreadCount() const
+{
+    return this->g_threadCount;
+}
+std::size_t BoardExecutor::getQuantum() const
+{
+    return this->g_quantum;
+}
+
+void BoardExecutor::run()
+{
+    const std::size_t threadCount = std::max<std::size_t>(1, std::min(this->g_threadCount, this->g_jobs.size()));
+
+    this->g_queues.clear();
+    for (std::size_t i=0; i<threadCount; ++i)
+    {
+        this->g_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    this->g_statistics.assign(threadCount, codeg::ExecutorWorkerStatistics{});
+    this->g_exception = nullptr;
+
+    //Jobs are distributed evenly at the start, the stealing take care of the imbalance
+    std::size_t remainingJobs = 0;
+    for (std::size_t i=0; i<this->g_jobs.size(); ++i)
+    {
+        this->g_jobs[i]._result = codeg::RunResult{};
+        if ( (this->g_jobs[i]._engine != nullptr) && (this->g_jobs[i]._maxInstructions > 0) )
+        {
+            this->g_queues[i%threadCount]->_jobs.push_back(i);
+            ++remainingJobs;
+        }
+    }
+    this->g_queuedJobs = remainingJobs;
+    this->g_remainingJobs = remainingJobs;
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (std::size_t i=0; i<threadCount; ++i)
+    {
+        threads.emplace_back(&BoardExecutor::work, this, i);
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (this->g_exception)
+    {
+        std::rethrow_exception(this->g_exception);
+    }
+}
+
+const std::vector<codeg::ExecutorWorkerStatistics>& BoardExecutor::getStatistics() const
+{
+    return this->g_statistics;
+}
+
+void BoardExecutor::work(std::size_t workerIndex)
+{
+    if (this->g_affinity)
+    {
+        SetCurrentThreadAffinity(workerIndex % std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    codeg::ExecutorWorkerStatistics& statistics = this->g_statistics[workerIndex];
+    std::size_t jobIndex = 0;
+
+    while (true)
+    {
+        if ( !this->popJob(workerIndex, jobIndex) )
+        {//Every remaining job is being executed by another worker
+            std::unique_lock<std::mutex> lock(this->g_idleMutex);
+            this->g_idleCondition.wait(lock, [this](){
+                return (this->g_queuedJobs != 0) || (this->g_remainingJobs == 0);
+            });
+            if (this->g_remainingJobs == 0)
+            {
+                return;
+            }
+            continue;
+        }
+
+        codeg::ExecutorJob& job = this->g_jobs[jobIndex];
+        bool finished = true;
+
+        try
+        {
+            const std::size_t budget = std::min(this->g_quantum, job._maxInstructions - job._result._instructionCount);
+            const codeg::RunResult result = job._engine->run(budget, job._conditions);
+
+            job._result._instructionCount += result._instructionCount;
+            job._result._skippedInstructionCount += result._skippedInstructionCount;
+            job._result._skippedPhaseCount += result._skippedPhaseCount;
+            job._result._reason = result._reason;
+
+            ++statistics._quantumCount;
+            statistics._instructionCount += result._instructionCount;
+
+            finished = (result._reason != codeg::StopReason::STOP_BUDGET_EXHAUSTED) ||
+                       (job._result._instructionCount >= job._maxInstructions);
+        }
+        catch (...)
+        {
+            std::scoped_lock<std::mutex> lock(this->g_exceptionMutex);
+            if (!this->g_exception)
+            {
+                this->g_exception = std::current_exception();
+            }
+        }
+
+        if (finished)
+        {
+            ++statistics._finishedJobCount;
+            this->finishJob();
+        }
+        else
+        {
+            this->pushJob(workerIndex, jobIndex);
+        }
+    }
+}
+
+bool BoardExecutor::popJob(std::size_t workerIndex, std::size_t& jobIndex)
+{
+    bool found = false;
+
+    //The front of its own queue first, then steal from the back of the other queues
+    for (std::size_t i=0; (i<this->g_queues.size()) && !found; ++i)
+    {
+        WorkerQueue& queue = *this->g_queues[(workerIndex+i) % this->g_queues.size()];
+        std::scoped_lock<std::mutex> lock(queue._mutex);
+        if ( queue._jobs.empty() )
+        {
+            continue;
+        }
+
+        if (i == 0)
+        {
+            jobIndex = queue._jobs.front();
+            queue._jobs.pop_front();
+        }
+        else
+        {
+            jobIndex = queue._jobs.back();
+            queue._jobs.pop_back();
+            ++this->g_statistics[workerIndex]._stealCount;
+        }
+        found = true;
+    }
+
+    if (found)
+    {
+        std::scoped_lock<std::mutex> lock(this->g_idleMutex);
+        --this->g_queuedJobs;
+    }
+    return found;
+}
+void BoardExecutor::pushJob(std::size_t workerIndex, std::size_t jobIndex)
+{
+    {
+        WorkerQueue& queue = *this->g_queues[workerIndex];
+        std::scoped_lock<std::mutex> lock(queue._mutex);
+        queue._jobs.push_back(jobIndex);
+    }
+    {
+        std::scoped_lock<std::mutex> lock(this->g_idleMutex);
+        ++this->g_queuedJobs;
+    }
+    this->g_idleCondition.notify_one();
+}
+void BoardExecutor::finishJob()
+{
+    bool allFinished = false;
+    {
+        std::scoped_lock<std::mutex> lock(this->g_idleMutex);
+        allFinished = (--this->g_remainingJobs == 0);
+    }
+    if (allFinished)
+    {
+        this->g_idleCondition.notify_all();
+    }
+}
+
+}//end codeg
@@ -0,0 +1,300 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "engine/C_breakpoints.hpp"
+
+namespace codeg
+{
+
+bool BreakpointSet::addBreakpoint(codeg::MemoryAddress address)
+{
+    if ( (address >= CG_BREAKPOINT_ADDRESS_COUNT) || !this->g_breakpoints.insert(address).second )
+    {
+        return false;
+    }
+
+    this->updateProgramCounterTrigger(address);
+    return true;
+}
+bool BreakpointSet::removeBreakpoint(codeg::MemoryAddress address)
+{
+    if (this->g_breakpoints.erase(address) == 0)
+    {
+        return false;
+    }
+
+    this->updateProgramCounterTrigger(address);
+    return true;
+}
+void BreakpointSet::clearBreakpoints()
+{
+    this->g_breakpoints.clear();
+    this->updateTriggers();
+}
+
+bool BreakpointSet::hasBreakpoint(codeg::MemoryAddress address) const
+{
+    return this->g_breakpoints.find(address) != this->g_breakpoints.cend();
+}
+
+std::size_t BreakpointSet::getBreakpointCount() const
+{
+    return this->g_breakpoints.size();
+}
+std::vector<codeg::MemoryAddress> BreakpointSet::getBreakpoints() const
+{
+    return {this->g_breakpoints.cbegin(), this->g_breakpoints.cend()};
+}
+
+std::size_t BreakpointSet::addCondition(const std::string& expression)
+{
+    const codeg::Condition& condition = this->g_conditions.emplace_back(expression);
+    this->g_dataSourceRead |= condition.isDataSourceRead();
+
+    switch (condition.getTrigger())
+    {
+    case codeg::ConditionTrigger::TRIGGER_PROGRAM_COUNTER:
+        this->updateProgramCounterTrigger(condition.getTriggerValue());
+        break;
+    case codeg::ConditionTrigger::TRIGGER_OPCODE:
+        this->g_opcodeTriggers |= uint32_t{1} << condition.getTriggerValue();
+        break;
+    case codeg::ConditionTrigger::TRIGGER_EVERY_INSTRUCTION:
+        this->g_opcodeTriggers = std::numeric_limits<uint32_t>::max();
+        break;
+    }
+    return this->g_conditions.size()-1;
+}
+bool BreakpointSet::removeCondition(std::size_t index)
+{
+    if (index < this->g_conditions.size())
+    {
+        this->g_conditions.erase(this->g_conditions.begin() + static_cast<std::ptrdiff_t>(index));
+        if (index < this->g_firstNewCondition)
+        {
+            --this->g_firstNewCondition;
+        }
+        this->updateTriggers();
+        return true;
+    }
+    return false;
+}
+void BreakpointSet::clearConditions()
+{
+    this->g_conditions.clear();
+    this->g_firstNewCondition = 0;
+    this->updateTriggers();
+}
+
+const std::vector<codeg::Condition>& BreakpointSet::getConditions() const
+{
+    return this->g_conditions;
+}
+
+bool BreakpointSet::hasProgramCounterTriggerInRange(codeg::MemoryAddress startAddress, codeg::MemoryAddress endAddress) const
+{
+    if ( this->g_bitmap.empty() )
+    {
+        return false;
+    }
+    if (endAddress > CG_BREAKPOINT_ADDRESS_COUNT)
+    {
+        endAddress = CG_BREAKPOINT_ADDRESS_COUNT;
+    }
+
+    while (startAddress < endAddress)
+    {
+        const uint64_t word = this->g_bitmap[startAddress>>6] >> (startAddress&63);
+        const codeg::MemoryAddress bitCount = 64 - (startAddress&63);
+
+        if (endAddress-startAddress < bitCount)
+        {
+            return (word & ((uint64_t{1} << (endAddress-startAddress)) - 1)) != 0;
+        }
+        if (word != 0)
+        {
+            return true;
+        }
+        startAddress += bitCount;
+    }
+    return false;
+}
+
+bool BreakpointSet::checkProgramCounter(codeg::MemoryAddress pc, const codeg::GP8B_5_1& processor)
+{
+    if ( this->hasBreakpoint(pc) )
+    {
+        this->g_lastCondition = CG_BREAKPOINT_NO_CONDITION;
+        return true;
+    }
+
+    for (std::size_t i=0; i<this->g_conditions.size(); ++i)
+    {
+        const codeg::Condition& condition = this->g_conditions[i];
+
+        if ( (condition.getTrigger() == codeg::ConditionTrigger::TRIGGER_PROGRAM_COUNTER) &&
+             (condition.getTriggerValue() == pc) && condition.evaluate(processor, pc) )
+        {
+            this->g_lastCondition = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BreakpointSet::checkInstruction(codeg::MemoryAddress pc, const codeg::GP8B_5_1& processor)
+{
+    const uint32_t opcode = processor.getInstruction()&CG_CODEGBINARYREV1_OPCODE_MASK;
+
+    for (std::size_t i=0; i<this->g_conditions.size(); ++i)
+    {
+        const codeg::Condition& condition = this->g_conditions[i];
+
+        const bool triggered = (condition.getTrigger() == codeg::ConditionTrigger::TRIGGER_EVERY_INSTRUCTION) ||
+                               ((condition.getTrigger() == codeg::ConditionTrigger::TRIGGER_OPCODE) && (condition.getTriggerValue() == opcode));
+        if ( triggered && condition.evaluate(processor, pc) )
+        {
+            this->g_lastCondition = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BreakpointSet::checkNewConditions(codeg::MemoryAddress pc, const codeg::GP8B_5_1& processor)
+{
+    while (this->g_firstNewCondition < this->g_conditions.size())
+    {
+        const std::size_t index = this->g_firstNewCondition++;
+        const codeg::Condition& condition = this->g_conditions[index];
+
+        if ( condition.isRamOnly() && condition.evaluate(processor, pc) )
+        {
+            this->g_lastCondition = index;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t BreakpointSet::getLastCondition() const
+{
+    return this->g_lastCondition;
+}
+
+std::size_t BreakpointSet::addWatchpoint(const codeg::Watchpoint& watchpoint)
+{
+    this->g_watchpoints.push_back(watchpoint);
+    return this->g_watchpoints.size()-1;
+}
+bool BreakpointSet::removeWatchpoint(std::size_t index)
+{
+    if (index < this->g_watchpoints.size())
+    {
+        this->g_watchpoints.erase(this->g_watchpoints.begin() + static_cast<std::ptrdiff_t>(index));
+        return true;
+    }
+    return false;
+}
+void BreakpointSet::clearWatchpoints()
+{
+    this->g_watchpoints.clear();
+}
+
+const std::vector<codeg::Watchpoint>& BreakpointSet::getWatchpoints() const
+{
+    return this->g_watchpoints;
+}
+
+bool BreakpointSet::checkAccess(codeg::WatchpointTarget target, std::size_t slot, codeg::MemoryAddress address, uint8_t access)
+{
+    for (std::size_t i=0; i<this->g_watchpoints.size(); ++i)
+    {
+        const codeg::Watchpoint& watchpoint = this->g_watchpoints[i];
+
+        if ( (watchpoint._target == target) && (watchpoint._slot == slot) && (watchpoint._access & access) &&
+             (address >= watchpoint._startAddress) && (address <= watchpoint._endAddress) )
+        {
+            this->g_lastHit._index = i;
+            this->g_lastHit._address = address;
+            this->g_lastHit._access = access;
+            return true;
+        }
+    }
+    return false;
+}
+const codeg::WatchpointHit& BreakpointSet::getLastHit() const
+{
+    return this->g_lastHit;
+}
+
+void BreakpointSet::updateProgramCounterTrigger(codeg::MemoryAddress address)
+{
+    if (address >= CG_BREAKPOINT_ADDRESS_COUNT)
+    {
+        return;
+    }
+
+    bool triggered = this->hasBreakpoint(address);
+    for (const codeg::Condition& condition : this->g_conditions)
+    {
+        triggered = triggered || ((condition.getTrigger() == codeg::ConditionTrigger::TRIGGER_PROGRAM_COUNTER) &&
+                                  (condition.getTriggerValue() == address));
+    }
+
+    if (triggered)
+    {
+        if ( this->g_bitmap.empty() )
+        {
+            this->g_bitmap.resize(CG_BREAKPOINT_ADDRESS_COUNT/64, 0);
+        }
+        this->g_bitmap[address>>6] |= uint64_t{1} << (address&63);
+    }
+    else if ( !this->g_bitmap.empty() )
+    {
+        this->g_bitmap[address>>6] &=~ (uint64_t{1} << (address&63));
+    }
+}
+void BreakpointSet::updateTriggers()
+{
+    this->g_bitmap.clear();
+    this->g_bitmap.shrink_to_fit();
+    this->g_opcodeTriggers = 0;
+    this->g_dataSourceRead = false;
+
+    for (codeg::MemoryAddress address : this->g_breakpoints)
+    {
+        this->updateProgramCounterTrigger(address);
+    }
+    for (const codeg::Condition& condition : this->g_conditions)
+    {
+        this->g_dataSourceRead |= condition.isDataSourceRead();
+        switch (condition.getTrigger())
+        {
+        case codeg::ConditionTrigger::TRIGGER_PROGRAM_COUNTER:
+            this->updateProgramCounterTrigger(condition.getTriggerValue());
+            break;
+        case codeg::ConditionTrigger::TRIGGER_OPCODE:
+            this->g_opcodeTriggers |= uint32_t{1} << condition.getTriggerValue();
+            break;
+        case codeg::ConditionTrigger::TRIGGER_EVERY_INSTRUCTION:
+            this->g_opcodeTriggers = std::numeric_limits<uint32_t>::max();
+            break;
+        }
+    }
+}
+
+}//end codeg
@@ -0,0 +1,343 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include "engine/C_callGraph.hpp"
+#include "C_string.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <string>
+
+namespace codeg
+{
+
+namespace
+{
+
+constexpr codeg::MemoryAddress RootCaller = std::numeric_limits<codeg::MemoryAddress>::max();
+
+double Percent(uint64_t count, uint64_t total)
+{
+    return (total == 0) ? 0.0 : 100.0 * static_cast<double>(count) / static_cast<double>(total);
+}
+
+std::string FunctionName(codeg::MemoryAddress function)
+{
+    return (function == RootCaller) ? CG_CALLGRAPH_ROOT_NAME : codeg::ValueToHex(function, 6);
+}
+
+}//end
+
+CallGraphProfiler::CallGraphProfiler()
+{
+    this->clear();
+}
+
+void CallGraphProfiler::clear()
+{
+    this->g_nodes.assign(1, codeg::CallGraphNode{});
+    this->g_children.clear();
+    this->g_stack.clear();
+    this->g_current = 0;
+    this->g_maxDepth = 0;
+    this->g_ramWrites.clear();
+    this->g_jumpFromRam = 0;
+    this->g_returns = 0;
+    this->g_unmatchedReturns = 0;
+}
+
+uint64_t CallGraphProfiler::getInstructionCount() const
+{
+    uint64_t count = 0;
+    for (const codeg::CallGraphNode& node : this->g_nodes)
+    {
+        count += node._instructions;
+    }
+    return count;
+}
+uint64_t CallGraphProfiler::getCallCount() const
+{
+    uint64_t count = 0;
+    for (const codeg::CallGraphNode& node : this->g_nodes)
+    {
+        count += node._calls;
+    }
+    return count;
+}
+uint64_t CallGraphProfiler::getReturnCount() const
+{
+    return this->g_returns;
+}
+uint64_t CallGraphProfiler::getUnmatchedReturnCount() const
+{
+    return this->g_unmatchedReturns;
+}
+std::size_t CallGraphProfiler::getDepth() const
+{
+    return this->g_stack.size();
+}
+std::size_t CallGraphProfiler::getMaxDepth() const
+{
+    return this->g_maxDepth;
+}
+
+const std::vector<codeg::CallGraphNode>& CallGraphProfiler::getNodes() const
+{
+    return this->g_nodes;
+}
+
+std::vector<uint64_t> CallGraphProfiler::getInclusiveInstructions() const
+{
+    std::vector<uint64_t> inclusive(this->g_nodes.size(), 0);
+
+    //A child is always created after its parent
+    for (std::size_t i=this->g_nodes.size(); i>0; --i)
+    {
+        const std::size_t index = i-1;
+        inclusive[index] += this->g_nodes[index]._instructions;
+        if (index != 0)
+        {
+            inclusive[this->g_nodes[index]._parent] += inclusive[index];
+        }
+    }
+    return inclusive;
+}
+
+std::vector<codeg::CallGraphFunction> CallGraphProfiler::getFunctions() const
+{
+    const std::vector<uint64_t> inclusive = this->getInclusiveInstructions();
+    std::map<codeg::MemoryAddress, codeg::CallGraphFunction> functions;
+
+    for (std::size_t i=1; i<this->g_nodes.size(); ++i)
+    {
+        const codeg::CallGraphNode& node = this->g_nodes[i];
+        codeg::CallGraphFunction& function = functions[node._function];
+        function._function = node._function;
+        function._calls += node._calls;
+        function._exclusive += node._instructions;
+
+        //A recursive call is already in the inclusive count of its caller
+        bool recursive = false;
+        for (std::size_t parent=node._parent; parent!=0; parent=this->g_nodes[parent]._parent)
+        {
+            if (this->g_nodes[parent]._function == node._function)
+            {
+                recursive = true;
+                break;
+            }
+        }
+        if (!recursive)
+        {
+            function._inclusive += inclusive[i];
+        }
+    }
+
+    std::vector<codeg::CallGraphFunction> result;
+    result.reserve(functions.size());
+    for (const auto& function : functions)
+    {
+        result.push_back(function.second);
+    }
+    std::stable_sort(result.begin(), result.end(), [](const codeg::CallGraphFunction& a, const codeg::CallGraphFunction& b){
+        return a._inclusive > b._inclusive;
+    });
+    return result;
+}
+
+void CallGraphProfiler::writeReport(std::ostream& stream, std::size_t top) const
+{
+    const uint64_t total = this->getInstructionCount();
+    const std::vector<uint64_t> inclusive = this->getInclusiveInstructions();
+    const std::vector<codeg::CallGraphFunction> functions = this->getFunctions();
+
+    stream << std::fixed << std::setprecision(2);
+    stream << "instructions: " << total << " calls: " << this->getCallCount() << " returns: " << this->g_returns
+           << " unmatched returns: " << this->g_unmatchedReturns << '\n';
+    stream << "depth: " << this->g_stack.size() << " (max " << this->g_maxDepth << ")\n";
+
+    stream << "functions (calls, inclusive, exclusive):\n";
+    stream << '\t' << std::setw(8) << CG_CALLGRAPH_ROOT_NAME << ' ' << std::setw(12) << 0 << ' '
+           << std::setw(12) << total << ' ' << std::setw(6) << 100.0 << "% "
+           << std::setw(12) << this->g_nodes[0]._instructions << ' ' << std::setw(6) << Percent(this->g_nodes[0]._instructions, total) << "%\n";
+    for (std::size_t i=0; i<functions.size() && i<top; ++i)
+    {
+        const codeg::CallGraphFunction& function = functions[i];
+        stream << '\t' << std::setw(8) << FunctionName(function._function) << ' ' << std::setw(12) << function._calls << ' '
+               << std::setw(12) << function._inclusive << ' ' << std::setw(6) << Percent(function._inclusive, total) << "% "
+               << std::setw(12) << function._exclusive << ' ' << std::setw(6) << Percent(function._exclusive, total) << "%\n";
+    }
+
+    //Edges are merged by caller and callee function
+    struct Edge
+    {
+        codeg::MemoryAddress _caller;
+        codeg::MemoryAddress _callee;
+        uint64_t _calls;
+        uint64_t _inclusive;
+    };
+    std::map<std::pair<codeg::MemoryAddress, codeg::MemoryAddress>, Edge> mergedEdges;
+    for (std::size_t i=1; i<this->g_nodes.size(); ++i)
+    {
+        const codeg::CallGraphNode& node = this->g_nodes[i];
+        const codeg::MemoryAddress caller = (node._parent == 0) ? RootCaller : this->g_nodes[node._parent]._function;
+        Edge& edge = mergedEdges.try_emplace({caller, node._function}, Edge{caller, node._function, 0, 0}).first->second;
+        edge._calls += node._calls;
+        edge._inclusive += inclusive[i];
+    }
+    std::vector<Edge> edges;
+    edges.reserve(mergedEdges.size());
+    for (const auto& edge : mergedEdges)
+    {
+        edges.push_back(edge.second);
+    }
+    std::stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b){
+        return a._inclusive > b._inclusive;
+    });
+
+    stream << "calls (caller -> callee, calls, inclusive):\n";
+    for (std::size_t i=0; i<edges.size() && i<top; ++i)
+    {
+        stream << '\t' << std::setw(8) << FunctionName(edges[i]._caller) << " -> " << std::setw(8) << FunctionName(edges[i]._callee) << ' '
+               << std::setw(12) << edges[i]._calls << ' ' << std::setw(12) << edges[i]._inclusive << ' '
+               << std::setw(6) << Percent(edges[i]._inclusive, total) << "%\n";
+    }
+}
+
+bool CallGraphProfiler::saveCollapsedStacks(const std::filesystem::path& path) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    for (std::size_t i=0; i<this->g_nodes.size(); ++i)
+    {
+        if (this->g_nodes[i]._instructions == 0)
+        {
+            continue;
+        }
+
+        std::string stack;
+        for (std::size_t node=i; node!=0; node=this->g_nodes[node]._parent)
+        {
+            stack.insert(0, ";" + codeg::ValueToHex(this->g_nodes[node]._function, 6));
+        }
+        file << CG_CALLGRAPH_ROOT_NAME << stack << ' ' << this->g_nodes[i]._instructions << '\n';
+    }
+
+    return static_cast<bool>(file);
+}
+
+void CallGraphProfiler::onJump(codeg::MemoryAddress address, codeg::MemoryAddress target)
+{
+    //A jump loaded from the RAM is a return if the target is in the call stack
+    bool isReturn = false;
+    if (this->g_jumpFromRam != 0)
+    {
+        for (std::size_t i=this->g_stack.size(); i>0; --i)
+        {
+            if (this->g_stack[i-1]._returnAddress == target)
+            {
+                this->g_current = this->g_stack[i-1]._caller;
+                this->g_stack.resize(i-1);
+                ++this->g_returns;
+                isReturn = true;
+                break;
+            }
+        }
+    }
+
+    if (!isReturn)
+    {
+        //JMPSRC_CLK never have an argument, the return address is the next byte
+        if ( (this->g_stack.size() < CG_CALLGRAPH_MAX_DEPTH) && this->isReturnAddressStored(address+1) )
+        {
+            this->g_stack.push_back({this->g_current, address+1});
+            this->g_current = this->getChild(this->g_current, target);
+            ++this->g_nodes[this->g_current]._calls;
+            this->g_maxDepth = std::max(this->g_maxDepth, this->g_stack.size());
+        }
+        else if (this->g_jumpFromRam != 0)
+        {
+            ++this->g_unmatchedReturns;
+        }
+    }
+
+    this->g_ramWrites.clear();
+}
+
+bool CallGraphProfiler::isReturnAddressStored(codeg::MemoryAddress returnAddress) const
+{
+    const auto byte0 = static_cast<uint8_t>(returnAddress);
+    const auto byte1 = static_cast<uint8_t>(returnAddress>>8);
+    const auto byte2 = static_cast<uint8_t>(returnAddress>>16);
+
+    for (const RamWrite& write : this->g_ramWrites)
+    {
+        if (write._value != byte0)
+        {
+            continue;
+        }
+
+        //Little endian then big endian, the third byte can be omitted if it's 0
+        for (int32_t direction : {1, -1})
+        {
+            const RamWrite* write1 = this->findRamWrite(static_cast<int32_t>(write._address) + direction);
+            if ( (write1 == nullptr) || (write1->_value != byte1) )
+            {
+                continue;
+            }
+            const RamWrite* write2 = this->findRamWrite(static_cast<int32_t>(write._address) + 2*direction);
+            if ( (write2 != nullptr) ? (write2->_value == byte2) : (byte2 == 0) )
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+const CallGraphProfiler::RamWrite* CallGraphProfiler::findRamWrite(int32_t address) const
+{
+    for (std::size_t i=this->g_ramWrites.size(); i>0; --i)
+    {
+        if (static_cast<int32_t>(this->g_ramWrites[i-1]._address) == address)
+        {
+            return &this->g_ramWrites[i-1];
+        }
+    }
+    return nullptr;
+}
+
+std::size_t CallGraphProfiler::getChild(std::size_t parent, codeg::MemoryAddress function)
+{
+    const auto it = this->g_children.find({parent, function});
+    if (it != this->g_children.end())
+    {
+        return it->second;
+    }
+
+    codeg::CallGraphNode& node = this->g_nodes.emplace_back();
+    node._function = function;
+    node._parent = parent;
+    this->g_children.emplace(std::make_pair(parent, function), this->g_nodes.size()-1);
+    return this->g_nodes.size()-1;
+}
+
+}//end codeg
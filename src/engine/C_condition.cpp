@@ -0,0 +1,594 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include "engine/C_condition.hpp"
+#include "C_string.hpp"
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+namespace codeg
+{
+
+namespace
+{
+
+struct Node
+{
+    codeg::ConditionOpcode _opcode{codeg::ConditionOpcode::COND_PUSH_CONSTANT};
+    uint64_t _value{0};
+    std::unique_ptr<Node> _left;
+    std::unique_ptr<Node> _right;
+};
+
+struct OperatorToken
+{
+    std::size_t _level;
+    const char* _token;
+    codeg::ConditionOpcode _opcode;
+};
+
+//Binary operators from the lowest to the highest precedence, longest tokens first
+constexpr OperatorToken BinaryOperators[] = {
+    {0, "||", codeg::ConditionOpcode::COND_OR},
+    {1, "&&", codeg::ConditionOpcode::COND_AND},
+    {2, "|", codeg::ConditionOpcode::COND_BIT_OR},
+    {3, "^", codeg::ConditionOpcode::COND_BIT_XOR},
+    {4, "&", codeg::ConditionOpcode::COND_BIT_AND},
+    {5, "==", codeg::ConditionOpcode::COND_EQUAL},
+    {5, "!=", codeg::ConditionOpcode::COND_NOT_EQUAL},
+    {6, "<=", codeg::ConditionOpcode::COND_LESS_EQUAL},
+    {6, ">=", codeg::ConditionOpcode::COND_GREATER_EQUAL},
+    {6, "<", codeg::ConditionOpcode::COND_LESS},
+    {6, ">", codeg::ConditionOpcode::COND_GREATER},
+    {7, "+", codeg::ConditionOpcode::COND_ADD},
+    {7, "-", codeg::ConditionOpcode::COND_SUBTRACT}
+};
+constexpr std::size_t BinaryLevelCount = 8;
+
+struct NamedValue
+{
+    const char* _name;
+    codeg::ConditionOpcode _opcode;
+    uint64_t _value;
+};
+
+constexpr NamedValue NamedValues[] = {
+    {"PC", codeg::ConditionOpcode::COND_PUSH_PC, 0},
+    {"RAMADDRESS", codeg::ConditionOpcode::COND_PUSH_RAMADDRESS, 0},
+    {"ALU", codeg::ConditionOpcode::COND_PUSH_ALU, 0},
+    {"INSTRUCTION", codeg::ConditionOpcode::COND_PUSH_INSTRUCTION, 0},
+    {"OPCODE", codeg::ConditionOpcode::COND_PUSH_OPCODE, 0},
+    {"ARGUMENT", codeg::ConditionOpcode::COND_PUSH_ARGUMENT, 0},
+
+    {"BWRITE1_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x00},
+    {"BWRITE2_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x01},
+    {"BPCS_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x02},
+    {"OPLEFT_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x03},
+    {"OPRIGHT_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x04},
+    {"OPCHOOSE_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x05},
+    {"PERIPHERAL_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x06},
+    {"BJMPSRC1_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x07},
+    {"BJMPSRC2_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x08},
+    {"BJMPSRC3_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x09},
+    {"JMPSRC_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x0A},
+    {"BRAMADD1_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x0B},
+    {"BRAMADD2_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x0C},
+    {"SPI_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x0D},
+    {"BCFG_SPI_CLK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x0E},
+    {"STICK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x0F},
+    {"IF", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x10},
+    {"IFNOT", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x11},
+    {"RAMW", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x12},
+    {"LTICK", codeg::ConditionOpcode::COND_PUSH_CONSTANT, 0x17}
+};
+
+uint64_t ApplyUnary(codeg::ConditionOpcode opcode, uint64_t value)
+{
+    switch (opcode)
+    {
+    case codeg::ConditionOpcode::COND_NOT:
+        return (value == 0) ? 1 : 0;
+    case codeg::ConditionOpcode::COND_COMPLEMENT:
+        return ~value;
+    case codeg::ConditionOpcode::COND_NEGATE:
+        return uint64_t{0} - value;
+    default:
+        return value;
+    }
+}
+uint64_t ApplyBinary(codeg::ConditionOpcode opcode, uint64_t left, uint64_t right)
+{
+    switch (opcode)
+    {
+    case codeg::ConditionOpcode::COND_AND:
+        return (left != 0 && right != 0) ? 1 : 0;
+    case codeg::ConditionOpcode::COND_OR:
+        return (left != 0 || right != 0) ? 1 : 0;
+    case codeg::ConditionOpcode::COND_BIT_AND:
+        return left & right;
+    case codeg::ConditionOpcode::COND_BIT_OR:
+        return left | right;
+    case codeg::ConditionOpcode::COND_BIT_XOR:
+        return left ^ right;
+    case codeg::ConditionOpcode::COND_EQUAL:
+        return (left == right) ? 1 : 0;
+    case codeg::ConditionOpcode::COND_NOT_EQUAL:
+        return (left != right) ? 1 : 0;
+    case codeg::ConditionOpcode::COND_LESS:
+        return (left < right) ? 1 : 0;
+    case codeg::ConditionOpcode::COND_LESS_EQUAL:
+        return (left <= right) ? 1 : 0;
+    case codeg::ConditionOpcode::COND_GREATER:
+        return (left > right) ? 1 : 0;
+    case codeg::ConditionOpcode::COND_GREATER_EQUAL:
+        return (left >= right) ? 1 : 0;
+    case codeg::ConditionOpcode::COND_ADD:
+        return left + right;
+    case codeg::ConditionOpcode::COND_SUBTRACT:
+        return left - right;
+    default:
+        return 0;
+    }
+}
+
+bool IsConstant(const Node& node)
+{
+    return node._opcode == codeg::ConditionOpcode::COND_PUSH_CONSTANT;
+}
+
+std::unique_ptr<Node> MakeConstant(uint64_t value)
+{
+    auto node = std::make_unique<Node>();
+    node->_value = value;
+    return node;
+}
+
+class Parser
+{
+public:
+    explicit Parser(const std::string& expression) :
+            g_expression(expression)
+    {}
+
+    std::unique_ptr<Node> parse()
+    {
+        std::unique_ptr<Node> node = this->parseBinary(0);
+
+        this->skipSpaces();
+        if (this->g_position != this->g_expression.size())
+        {
+            throw codeg::Error("condition: unexpected \""+this->g_expression.substr(this->g_position)+"\"");
+        }
+        return node;
+    }
+
+private:
+    void skipSpaces()
+    {
+        while ( (this->g_position < this->g_expression.size()) &&
+                std::isspace(static_cast<unsigned char>(this->g_expression[this->g_position])) )
+        {
+            ++this->g_position;
+        }
+    }
+    bool match(const char* token)
+    {
+        this->skipSpaces();
+
+        const std::size_t size = std::strlen(token);
+        if (this->g_expression.compare(this->g_position, size, token) != 0)
+        {
+            return false;
+        }
+        //"|" and "&" must not match the first character of "||" and "&&"
+        if ( (size == 1) && ((token[0] == '|') || (token[0] == '&')) &&
+             (this->g_position+1 < this->g_expression.size()) && (this->g_expression[this->g_position+1] == token[0]) )
+        {
+            return false;
+        }
+
+        this->g_position += size;
+        return true;
+    }
+    void expect(const char* token)
+    {
+        if ( !this->match(token) )
+        {
+            throw codeg::Error(std::string{"condition: expected \""}+token+"\"");
+        }
+    }
+
+    std::unique_ptr<Node> parseBinary(std::size_t level)
+    {
+        if (level >= BinaryLevelCount)
+        {
+            return this->parseUnary();
+        }
+
+        std::unique_ptr<Node> left = this->parseBinary(level+1);
+        while (true)
+        {
+            const OperatorToken* found = nullptr;
+            for (const OperatorToken& op : BinaryOperators)
+            {
+                if ( (op._level == level) && this->match(op._token) )
+                {
+                    found = &op;
+                    break;
+                }
+            }
+            if (found == nullptr)
+            {
+                return left;
+            }
+
+            std::unique_ptr<Node> right = this->parseBinary(level+1);
+            if ( IsConstant(*left) && IsConstant(*right) )
+            {
+                left = MakeConstant( ApplyBinary(found->_opcode, left->_value, right->_value) );
+                continue;
+            }
+
+            auto node = std::make_unique<Node>();
+            node->_opcode = found->_opcode;
+            node->_left = std::move(left);
+            node->_right = std::move(right);
+            left = std::move(node);
+        }
+    }
+
+    std::unique_ptr<Node> parseUnary()
+    {
+        //Every nested parentheses, RAM[] or unary operator go through here
+        if (++this->g_nesting > CG_CONDITION_MAX_NESTING)
+        {
+            throw codeg::Error("condition: the expression is nested too deeply");
+        }
+        std::unique_ptr<Node> node = this->parseUnaryOperator();
+        --this->g_nesting;
+        return node;
+    }
+    std::unique_ptr<Node> parseUnaryOperator()
+    {
+        codeg::ConditionOpcode opcode;
+        if ( this->match("!") )
+        {
+            opcode = codeg::ConditionOpcode::COND_NOT;
+        }
+        else if ( this->match("~") )
+        {
+            opcode = codeg::ConditionOpcode::COND_COMPLEMENT;
+        }
+        else if ( this->match("-") )
+        {
+            opcode = codeg::ConditionOpcode::COND_NEGATE;
+        }
+        else
+        {
+            return this->parsePrimary();
+        }
+
+        std::unique_ptr<Node> operand = this->parseUnary();
+        if ( IsConstant(*operand) )
+        {
+            return MakeConstant( ApplyUnary(opcode, operand->_value) );
+        }
+
+        auto node = std::make_unique<Node>();
+        node->_opcode = opcode;
+        node->_left = std::move(operand);
+        return node;
+    }
+
+    std::unique_ptr<Node> parsePrimary()
+    {
+        if ( this->match("(") )
+        {
+            std::unique_ptr<Node> node = this->parseBinary(0);
+            this->expect(")");
+            return node;
+        }
+
+        this->skipSpaces();
+        if (this->g_position >= this->g_expression.size())
+        {
+            throw codeg::Error("condition: unexpected end of the expression");
+        }
+
+        const char* start = this->g_expression.c_str() + this->g_position;
+        if ( std::isdigit(static_cast<unsigned char>(*start)) )
+        {
+            uint64_t value = 0;
+            std::size_t size = codeg::ReadValue(start, value);
+            if ( (size == 0) || std::isalnum(static_cast<unsigned char>(start[size])) || (start[size] == '_') )
+            {
+                while ( std::isalnum(static_cast<unsigned char>(start[size])) || (start[size] == '_') )
+                {
+                    ++size;
+                }
+                throw codeg::Error("condition: bad number \""+std::string(start, size)+"\"");
+            }
+            this->g_position += size;
+            return MakeConstant(value);
+        }
+
+        std::size_t size = 0;
+        while ( std::isalnum(static_cast<unsigned char>(start[size])) || (start[size] == '_') )
+        {
+            ++size;
+        }
+        if (size == 0)
+        {
+            throw codeg::Error("condition: unexpected \""+this->g_expression.substr(this->g_position)+"\"");
+        }
+        const std::string name(start, size);
+        this->g_position += size;
+
+        if (name == "RAM")
+        {
+            this->expect("[");
+            auto node = std::make_unique<Node>();
+            node->_opcode = codeg::ConditionOpcode::COND_LOAD_RAM;
+            node->_left = this->parseBinary(0);
+            this->expect("]");
+            if ( IsConstant(*node->_left) && (node->_left->_value > std::numeric_limits<uint16_t>::max()) )
+            {
+                throw codeg::Error("condition: the RAM address "+std::to_string(node->_left->_value)+" is out of range");
+            }
+            return node;
+        }
+        for (codeg::BusIndex i=0; i<codeg::BUS_SPS1_COUNT; ++i)
+        {
+            if (name == codeg::BusSPS1Names[i])
+            {
+                auto node = std::make_unique<Node>();
+                node->_opcode = codeg::ConditionOpcode::COND_PUSH_BUS;
+                node->_value = i;
+                return node;
+            }
+        }
+        for (const NamedValue& value : NamedValues)
+        {
+            if (name == value._name)
+            {
+                auto node = std::make_unique<Node>();
+                node->_opcode = value._opcode;
+                node->_value = value._value;
+                return node;
+            }
+        }
+        throw codeg::Error("condition: unknown name \""+name+"\"");
+    }
+
+    const std::string& g_expression;
+    std::size_t g_position{0};
+    std::size_t g_nesting{0};
+};
+
+void CollectConjuncts(const Node& node, std::vector<const Node*>& conjuncts)
+{
+    if (node._opcode == codeg::ConditionOpcode::COND_AND)
+    {
+        CollectConjuncts(*node._left, conjuncts);
+        CollectConjuncts(*node._right, conjuncts);
+        return;
+    }
+    conjuncts.push_back(&node);
+}
+
+//Match "operand == constant" or "constant == operand"
+bool IsEqualTo(const Node& node, codeg::ConditionOpcode operand, uint64_t& value)
+{
+    if (node._opcode != codeg::ConditionOpcode::COND_EQUAL)
+    {
+        return false;
+    }
+    if ( (node._left->_opcode == operand) && IsConstant(*node._right) )
+    {
+        value = node._right->_value;
+        return true;
+    }
+    if ( (node._right->_opcode == operand) && IsConstant(*node._left) )
+    {
+        value = node._left->_value;
+        return true;
+    }
+    return false;
+}
+
+//True if the node only depends on constants and RAM[constant]
+bool DependsOnRamOnly(const Node& node, bool& readRam)
+{
+    switch (node._opcode)
+    {
+    case codeg::ConditionOpcode::COND_PUSH_CONSTANT:
+        return true;
+    case codeg::ConditionOpcode::COND_LOAD_RAM:
+        readRam = true;
+        return IsConstant(*node._left);
+    default:
+        if (node._left == nullptr)
+        {
+            return false;
+        }
+        return DependsOnRamOnly(*node._left, readRam) &&
+               ((node._right == nullptr) || DependsOnRamOnly(*node._right, readRam));
+    }
+}
+
+void Emit(const Node& node, std::vector<codeg::ConditionInstruction>& code, std::size_t depth)
+{
+    if (node._left != nullptr)
+    {
+        Emit(*node._left, code, depth);
+    }
+    if (node._right != nullptr)
+    {
+        Emit(*node._right, code, depth+1);
+    }
+    else if (node._left == nullptr)
+    {//Push
+        if (depth >= CG_CONDITION_STACK_SIZE)
+        {
+            throw codeg::Error("condition: the expression is too complex");
+        }
+    }
+
+    code.push_back({node._opcode, node._value});
+}
+
+}//end
+
+Condition::Condition(const std::string& expression) :
+        g_expression(expression)
+{
+    const std::unique_ptr<Node> root = Parser(this->g_expression).parse();
+
+    std::vector<const Node*> conjuncts;
+    CollectConjuncts(*root, conjuncts);
+
+    uint64_t value = 0;
+    bool found = false;
+    for (const Node* conjunct : conjuncts)
+    {
+        if ( IsEqualTo(*conjunct, codeg::ConditionOpcode::COND_PUSH_PC, value) &&
+             (value <= codeg::BusSPS1Masks[codeg::BUS_SPS1_BJMPSRC]) )
+        {
+            this->g_trigger = codeg::ConditionTrigger::TRIGGER_PROGRAM_COUNTER;
+            this->g_triggerValue = static_cast<uint32_t>(value);
+            found = true;
+            break;
+        }
+    }
+    for (std::size_t i=0; !found && i<conjuncts.size(); ++i)
+    {
+        if ( IsEqualTo(*conjuncts[i], codeg::ConditionOpcode::COND_PUSH_OPCODE, value) &&
+             (value <= CG_CODEGBINARYREV1_OPCODE_MASK) )
+        {
+            this->g_trigger = codeg::ConditionTrigger::TRIGGER_OPCODE;
+            this->g_triggerValue = static_cast<uint32_t>(value);
+            found = true;
+        }
+    }
+    bool readRam = false;
+    if ( !found && DependsOnRamOnly(*root, readRam) && readRam )
+    {//The processor RAM can only be modified by a RAMW instruction
+        this->g_ramOnly = true;
+        this->g_trigger = codeg::ConditionTrigger::TRIGGER_OPCODE;
+        this->g_triggerValue = static_cast<uint32_t>(codeg::CodegBinaryRev1::OPCODE_RAMW);
+    }
+
+    Emit(*root, this->g_code, 0);
+
+    for (const codeg::ConditionInstruction& instruction : this->g_code)
+    {
+        if ( (instruction._opcode == codeg::ConditionOpcode::COND_PUSH_BUS) &&
+             (instruction._value == codeg::BUS_SPS1_BDATASRC) )
+        {
+            this->g_dataSourceRead = true;
+        }
+    }
+}
+
+bool Condition::evaluate(const codeg::GP8B_5_1& processor, codeg::MemoryAddress pc) const
+{
+    std::array<uint64_t, CG_CONDITION_STACK_SIZE> stack{};
+    std::size_t top = 0;
+
+    for (const codeg::ConditionInstruction& instruction : this->g_code)
+    {
+        switch (instruction._opcode)
+        {
+        case codeg::ConditionOpcode::COND_PUSH_CONSTANT:
+            stack[top++] = instruction._value;
+            break;
+        case codeg::ConditionOpcode::COND_PUSH_BUS:
+            stack[top++] = processor._busses.get(static_cast<codeg::BusIndex>(instruction._value)).get();
+            break;
+        case codeg::ConditionOpcode::COND_PUSH_PC:
+            stack[top++] = pc;
+            break;
+        case codeg::ConditionOpcode::COND_PUSH_RAMADDRESS:
+            stack[top++] = processor.getRamAddress();
+            break;
+        case codeg::ConditionOpcode::COND_PUSH_ALU:
+            stack[top++] = processor._alu ? processor._alu->getResult() : 0;
+            break;
+        case codeg::ConditionOpcode::COND_PUSH_INSTRUCTION:
+            stack[top++] = processor.getInstruction();
+            break;
+        case codeg::ConditionOpcode::COND_PUSH_OPCODE:
+            stack[top++] = processor.getInstruction() & CG_CODEGBINARYREV1_OPCODE_MASK;
+            break;
+        case codeg::ConditionOpcode::COND_PUSH_ARGUMENT:
+            stack[top++] = processor.getArguments();
+            break;
+        case codeg::ConditionOpcode::COND_LOAD_RAM:
+        {
+            uint8_t data = 0;
+            const codeg::MemoryModuleSlot* slot = processor.getMemorySlot(0);
+            if ( (slot != nullptr) && slot->_mem && (stack[top-1] <= std::numeric_limits<uint16_t>::max()) )
+            {//An out of range read give 0
+                slot->_mem->get(static_cast<codeg::MemoryAddress>(stack[top-1]), data);
+            }
+            stack[top-1] = data;
+            break;
+        }
+        case codeg::ConditionOpcode::COND_NOT:
+        case codeg::ConditionOpcode::COND_COMPLEMENT:
+        case codeg::ConditionOpcode::COND_NEGATE:
+            stack[top-1] = ApplyUnary(instruction._opcode, stack[top-1]);
+            break;
+        default:
+            --top;
+            stack[top-1] = ApplyBinary(instruction._opcode, stack[top-1], stack[top]);
+            break;
+        }
+    }
+    return stack[0] != 0;
+}
+
+codeg::ConditionTrigger Condition::getTrigger() const
+{
+    return this->g_trigger;
+}
+uint32_t Condition::getTriggerValue() const
+{
+    return this->g_triggerValue;
+}
+bool Condition::isRamOnly() const
+{
+    return this->g_ramOnly;
+}
+bool Condition::isDataSourceRead() const
+{
+    return this->g_dataSourceRead;
+}
+
+const std::string& Condition::getExpression() const
+{
+    return this->g_expression;
+}
+const std::vector<codeg::ConditionInstruction>& Condition::getCode() const
+{
+    return this->g_code;
+}
+
+}//end codeg
@@ -0,0 +1,337 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include "engine/C_dataProfiler.hpp"
+#include "C_string.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+namespace codeg
+{
+
+namespace
+{
+
+constexpr const char* HeatmapLevels = ".:-=+*#%@";
+constexpr std::size_t HeatmapLevelCount = 9;
+
+const char* TargetToString(codeg::WatchpointTarget target)
+{
+    return (target == codeg::WatchpointTarget::TARGET_PROCESSOR_SLOT) ? "processor" : "motherboard";
+}
+
+double Percent(uint64_t count, uint64_t total)
+{
+    return (total == 0) ? 0.0 : 100.0 * static_cast<double>(count) / static_cast<double>(total);
+}
+
+uint64_t AccessCount(const codeg::DataAccessCounters& counters, uint8_t access)
+{
+    return ((access & codeg::WatchpointAccess::WATCH_READ) ? counters._reads : 0) +
+           ((access & codeg::WatchpointAccess::WATCH_WRITE) ? counters._writes : 0);
+}
+
+struct AccessedAddress
+{
+    codeg::MemoryAddress _address;
+    codeg::DataAccessCounters _counters;
+};
+
+struct AddressRange
+{
+    codeg::MemoryAddress _start;
+    codeg::MemorySize _size;
+};
+
+}//end
+
+void DataAccessProfiler::clear()
+{
+    for (std::vector<Slot>& slots : this->g_slots)
+    {
+        slots.clear();
+    }
+}
+
+uint64_t DataAccessProfiler::getReadCount() const
+{
+    uint64_t count = 0;
+    for (const std::vector<Slot>& slots : this->g_slots)
+    {
+        for (const Slot& slot : slots)
+        {
+            for (const std::unique_ptr<Page>& page : slot)
+            {
+                if (page)
+                {
+                    for (const codeg::DataAccessCounters& counters : *page)
+                    {
+                        count += counters._reads;
+                    }
+                }
+            }
+        }
+    }
+    return count;
+}
+uint64_t DataAccessProfiler::getWriteCount() const
+{
+    uint64_t count = 0;
+    for (const std::vector<Slot>& slots : this->g_slots)
+    {
+        for (const Slot& slot : slots)
+        {
+            for (const std::unique_ptr<Page>& page : slot)
+            {
+                if (page)
+                {
+                    for (const codeg::DataAccessCounters& counters : *page)
+                    {
+                        count += counters._writes;
+                    }
+                }
+            }
+        }
+    }
+    return count;
+}
+
+const codeg::DataAccessCounters* DataAccessProfiler::getCounters(codeg::WatchpointTarget target, std::size_t slot, codeg::MemoryAddress address) const
+{
+    const Slot* counterSlot = this->getSlot(target, slot);
+    const std::size_t pageIndex = address / CG_DATAPROFILER_PAGE_SIZE;
+    if ( (counterSlot == nullptr) || (pageIndex >= counterSlot->size()) || !(*counterSlot)[pageIndex] )
+    {
+        return nullptr;
+    }
+
+    const codeg::DataAccessCounters& counters = (*(*counterSlot)[pageIndex])[address % CG_DATAPROFILER_PAGE_SIZE];
+    return ( (counters._reads != 0) || (counters._writes != 0) ) ? &counters : nullptr;
+}
+
+void DataAccessProfiler::writeReport(std::ostream& stream, const codeg::MemoryModuleSlotCapable& processor, const codeg::MemoryModuleSlotCapable& motherboard,
+                                     std::size_t top) const
+{
+    stream << std::fixed << std::setprecision(2);
+    stream << "reads: " << this->getReadCount() << " writes: " << this->getWriteCount() << '\n';
+
+    for (std::size_t targetIndex=0; targetIndex<this->g_slots.size(); ++targetIndex)
+    {
+        const auto target = static_cast<codeg::WatchpointTarget>(targetIndex);
+        const codeg::MemoryModuleSlotCapable& slotCapable = (target == codeg::WatchpointTarget::TARGET_PROCESSOR_SLOT) ? processor : motherboard;
+
+        for (std::size_t slot=0; slot<this->g_slots[targetIndex].size(); ++slot)
+        {
+            //Accessed addresses and totals
+            std::vector<AccessedAddress> accessed;
+            codeg::DataAccessCounters total;
+            for (codeg::MemoryAddress address=0; address<this->getAccessedSize(target, slot); ++address)
+            {
+                const codeg::DataAccessCounters* counters = this->getCounters(target, slot, address);
+                if (counters != nullptr)
+                {
+                    accessed.push_back({address, *counters});
+                    total._reads += counters->_reads;
+                    total._writes += counters->_writes;
+                }
+            }
+            if (accessed.empty())
+            {
+                continue;
+            }
+
+            //The unused ranges are searched in the whole memory module if it's still plugged
+            const codeg::MemoryModuleSlot* memorySlot = slotCapable.getMemorySlot(slot);
+            codeg::MemorySize memorySize = this->getAccessedSize(target, slot);
+            stream << TargetToString(target) << " slot " << slot;
+            if ( (memorySlot != nullptr) && memorySlot->_mem )
+            {
+                memorySize = std::max(memorySize, memorySlot->_mem->getMemorySize());
+                stream << " (" << memorySlot->_mem->getType() << ", " << memorySlot->_mem->getMemorySize() << " bytes)";
+            }
+            stream << ": reads: " << total._reads << " writes: " << total._writes
+                   << " accessed: " << accessed.size() << " bytes (" << Percent(accessed.size(), memorySize) << "%)\n";
+
+            std::stable_sort(accessed.begin(), accessed.end(), [](const AccessedAddress& a, const AccessedAddress& b){
+                return (a._counters._reads+a._counters._writes) > (b._counters._reads+b._counters._writes);
+            });
+            stream << "\thottest addresses (reads, writes):\n";
+            for (std::size_t i=0; i<accessed.size() && i<top; ++i)
+            {
+                stream << "\t\t" << codeg::ValueToHex(accessed[i]._address, 6) << ' '
+                       << std::setw(12) << accessed[i]._counters._reads << std::setw(12) << accessed[i]._counters._writes << '\n';
+            }
+
+            std::vector<AddressRange> unused;
+            codeg::MemoryAddress rangeStart = 0;
+            for (codeg::MemoryAddress address=0; address<=memorySize; ++address)
+            {
+                if ( (address == memorySize) || (this->getCounters(target, slot, address) != nullptr) )
+                {
+                    if (address != rangeStart)
+                    {
+                        unused.push_back({rangeStart, address-rangeStart});
+                    }
+                    rangeStart = address+1;
+                }
+            }
+            std::stable_sort(unused.begin(), unused.end(), [](const AddressRange& a, const AddressRange& b){
+                return a._size > b._size;
+            });
+            stream << "\tlargest never accessed ranges:\n";
+            for (std::size_t i=0; i<unused.size() && i<top; ++i)
+            {
+                stream << "\t\t" << codeg::ValueToHex(unused[i]._start, 6) << '-' << codeg::ValueToHex(unused[i]._start+unused[i]._size-1, 6)
+                       << ' ' << unused[i]._size << " bytes\n";
+            }
+        }
+    }
+}
+
+void DataAccessProfiler::writeHeatmap(std::ostream& stream, codeg::WatchpointTarget target, std::size_t slot,
+                                      codeg::MemoryAddress startAddress, codeg::MemoryAddress endAddress, uint8_t access) const
+{
+    if (endAddress < startAddress)
+    {
+        std::swap(startAddress, endAddress);
+    }
+
+    const codeg::MemorySize size = endAddress-startAddress+1;
+    const std::size_t maxCells = CG_DATAPROFILER_HEATMAP_COLUMNS*CG_DATAPROFILER_HEATMAP_ROWS;
+    const codeg::MemorySize bytesPerCell = (size+maxCells-1) / maxCells;
+
+    std::vector<uint64_t> cells( (size+bytesPerCell-1) / bytesPerCell, 0 );
+    for (codeg::MemoryAddress address=startAddress; address<=endAddress; ++address)
+    {
+        const codeg::DataAccessCounters* counters = this->getCounters(target, slot, address);
+        if (counters != nullptr)
+        {
+            cells[(address-startAddress)/bytesPerCell] += AccessCount(*counters, access);
+        }
+    }
+    const uint64_t maxCount = cells.empty() ? 0 : *std::max_element(cells.begin(), cells.end());
+
+    stream << TargetToString(target) << " slot " << slot << ' ' << codeg::ValueToHex(startAddress, 6) << '-' << codeg::ValueToHex(endAddress, 6)
+           << ", " << bytesPerCell << " bytes per cell, scale: ' ' 0 '" << HeatmapLevels[0] << "' 1 '"
+           << HeatmapLevels[HeatmapLevelCount-1] << "' " << maxCount << " (log)\n";
+
+    //The level is logarithmic, a count of 1 is the lowest level and the max count the highest
+    const double logMax = std::log(static_cast<double>(std::max<uint64_t>(maxCount, 2)));
+    for (std::size_t cell=0; cell<cells.size(); ++cell)
+    {
+        if ( (cell % CG_DATAPROFILER_HEATMAP_COLUMNS) == 0 )
+        {
+            stream << (cell == 0 ? "" : "|\n") << codeg::ValueToHex(startAddress + cell*bytesPerCell, 6) << " |";
+        }
+
+        if (cells[cell] == 0)
+        {
+            stream << ' ';
+        }
+        else
+        {
+            const auto level = static_cast<std::size_t>(std::log(static_cast<double>(cells[cell])) / logMax * (HeatmapLevelCount-1) + 0.5);
+            stream << HeatmapLevels[std::min(level, HeatmapLevelCount-1)];
+        }
+    }
+    stream << "|\n";
+}
+
+bool DataAccessProfiler::saveCsv(const std::filesystem::path& path) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    file << "target,slot,address,reads,writes\n";
+    for (std::size_t targetIndex=0; targetIndex<this->g_slots.size(); ++targetIndex)
+    {
+        const auto target = static_cast<codeg::WatchpointTarget>(targetIndex);
+        for (std::size_t slot=0; slot<this->g_slots[targetIndex].size(); ++slot)
+        {
+            for (codeg::MemoryAddress address=0; address<this->getAccessedSize(target, slot); ++address)
+            {
+                const codeg::DataAccessCounters* counters = this->getCounters(target, slot, address);
+                if (counters != nullptr)
+                {
+                    file << (target == codeg::WatchpointTarget::TARGET_PROCESSOR_SLOT ? 'p' : 'm') << ','
+                         << slot << ',' << address << ',' << counters->_reads << ',' << counters->_writes << '\n';
+                }
+            }
+        }
+    }
+
+    return static_cast<bool>(file);
+}
+
+codeg::MemorySize DataAccessProfiler::getAccessedSize(codeg::WatchpointTarget target, std::size_t slot) const
+{
+    const Slot* counterSlot = this->getSlot(target, slot);
+    if (counterSlot == nullptr)
+    {
+        return 0;
+    }
+
+    for (std::size_t pageIndex=counterSlot->size(); pageIndex>0; --pageIndex)
+    {
+        const std::unique_ptr<Page>& page = (*counterSlot)[pageIndex-1];
+        if (!page)
+        {
+            continue;
+        }
+        for (std::size_t i=CG_DATAPROFILER_PAGE_SIZE; i>0; --i)
+        {
+            if ( ((*page)[i-1]._reads != 0) || ((*page)[i-1]._writes != 0) )
+            {
+                return (pageIndex-1)*CG_DATAPROFILER_PAGE_SIZE + i;
+            }
+        }
+    }
+    return 0;
+}
+
+const DataAccessProfiler::Slot* DataAccessProfiler::getSlot(codeg::WatchpointTarget target, std::size_t slot) const
+{
+    const std::vector<Slot>& slots = this->g_slots[static_cast<std::size_t>(target)];
+    return (slot < slots.size()) ? &slots[slot] : nullptr;
+}
+
+codeg::DataAccessCounters& DataAccessProfiler::growCounters(codeg::WatchpointTarget target, std::size_t slot, codeg::MemoryAddress address)
+{
+    std::vector<Slot>& slots = this->g_slots[static_cast<std::size_t>(target)];
+    if (slot >= slots.size())
+    {
+        slots.resize(slot+1);
+    }
+
+    const std::size_t pageIndex = address / CG_DATAPROFILER_PAGE_SIZE;
+    if (pageIndex >= slots[slot].size())
+    {
+        slots[slot].resize(pageIndex+1);
+    }
+    if (!slots[slot][pageIndex])
+    {
+        slots[slot][pageIndex] = std::make_unique<Page>();
+    }
+    return (*slots[slot][pageIndex])[address % CG_DATAPROFILER_PAGE_SIZE];
+}
+
+}//end codeg
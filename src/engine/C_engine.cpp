@@ -0,0 +1,240 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "engine/C_engine.hpp"
+#include "engine/C_threadedEngine.hpp"
+#include "engine/C_predecodedBlockEngine.hpp"
+#include "engine/C_nativeBlockEngine.hpp"
+#include "motherboard/C_staticBoard.hpp"
+
+namespace codeg
+{
+
+const char* StopReasonToString(codeg::StopReason reason)
+{
+    switch (reason)
+    {
+    case codeg::StopReason::STOP_BUDGET_EXHAUSTED:
+        return "budget exhausted";
+    case codeg::StopReason::STOP_BREAKPOINT:
+        return "breakpoint";
+    case codeg::StopReason::STOP_WATCHPOINT:
+        return "watchpoint";
+    case codeg::StopReason::STOP_PC_REACHED:
+        return "program counter reached";
+    case codeg::StopReason::STOP_UNSYNC_TIMEOUT:
+        return "unsync timeout";
+    case codeg::StopReason::STOP_PERIPHERAL_EVENT:
+        return "peripheral event";
+    }
+    return "unknown";
+}
+
+///ExecutionEngine
+
+uint64_t ExecutionEngine::getPeripheralChangeCount() const
+{
+    uint64_t count = 0;
+    for (std::size_t i=0; i<this->_g_motherboard.getPeripheralSlotSize(); ++i)
+    {
+        const std::shared_ptr<codeg::Peripheral>& peripheral = this->_g_motherboard.getPeripheralSlot(i)->_peripheral;
+        if (peripheral)
+        {
+            count += peripheral->getChangeCount();
+        }
+    }
+    return count;
+}
+
+bool ExecutionEngine::checkWatchpoints(codeg::BreakpointSet& breakpoints, uint8_t instruction, uint16_t ramAddress)
+{
+    const auto opcode = static_cast<codeg::CodegBinaryRev1>(instruction&CG_CODEGBINARYREV1_OPCODE_MASK);
+    const auto bus = static_cast<codeg::CodegBinaryRev1Busses>(instruction&CG_CODEGBINARYREV1_BUSSES_MASK);
+    bool hit = false;
+
+    if (bus == codeg::CodegBinaryRev1Busses::READABLE_RAM)
+    {
+        hit = breakpoints.checkAccess(codeg::WatchpointTarget::TARGET_PROCESSOR_SLOT, 0, ramAddress, codeg::WatchpointAccess::WATCH_READ);
+    }
+    if ( !hit && (opcode == codeg::CodegBinaryRev1::OPCODE_RAMW) )
+    {
+        hit = breakpoints.checkAccess(codeg::WatchpointTarget::TARGET_PROCESSOR_SLOT, 0, ramAddress, codeg::WatchpointAccess::WATCH_WRITE);
+    }
+
+    for (const codeg::MemoryAccess& access : this->_g_motherboard.getMemoryAccesses())
+    {
+        if (hit)
+        {
+            break;
+        }
+        hit = breakpoints.checkAccess(codeg::WatchpointTarget::TARGET_MOTHERBOARD_SLOT, access._slot, access._address,
+                                      access._write ? codeg::WatchpointAccess::WATCH_WRITE : codeg::WatchpointAccess::WATCH_READ);
+    }
+    this->_g_motherboard.clearMemoryAccesses();
+
+    return hit;
+}
+
+void ExecutionEngine::recordDataAccesses(codeg::DataAccessProfiler& profiler, bool watching, uint8_t instruction, uint16_t ramAddress)
+{
+    profiler.record(instruction, ramAddress, this->_g_motherboard.getMemoryAccesses());
+    if (!watching)
+    {//Else cleared by checkWatchpoints()
+        this->_g_motherboard.clearMemoryAccesses();
+    }
+}
+
+template<class TStep>
+codeg::RunResult ExecutionEngine::runStepByStep(std::size_t maxInstructions, const codeg::StopConditions& conditions, TStep step)
+{
+    codeg::RunResult result;
+    uint64_t peripheralChangeCount = conditions._stopOnPeripheralEvent ? this->getPeripheralChangeCount() : 0;
+    const bool watching = conditions.hasWatchpoints();
+
+    this->_g_motherboard.setMemoryAccessTracking(watching || (conditions._dataProfiler != nullptr));
+
+    while (true)
+    {
+        const codeg::MemoryAddress pc = this->_g_motherboard.getProgramCounter();
+        if ( conditions._stopAtProgramCounter && (pc == conditions._programCounter) )
+        {
+            result._reason = codeg::StopReason::STOP_PC_REACHED;
+            break;
+        }
+        if ( (result._instructionCount != 0) && (conditions._breakpoints != nullptr) &&
+             conditions._breakpoints->hasProgramCounterTrigger(pc) && conditions._breakpoints->checkProgramCounter(pc, this->_g_motherboard._processor) )
+        {
+            result._reason = codeg::StopReason::STOP_BREAKPOINT;
+            break;
+        }
+        if (result._instructionCount >= maxInstructions)
+        {
+            break;
+        }
+
+        const uint16_t ramAddress = this->_g_motherboard._processor.getRamAddress();
+        const std::size_t sourceIndex = this->_g_motherboard.getMemorySourceIndex();
+        if ( !step() )
+        {
+            result._reason = codeg::StopReason::STOP_UNSYNC_TIMEOUT;
+            break;
+        }
+        ++result._instructionCount;
+
+        if (conditions._profiler != nullptr)
+        {
+            conditions._profiler->record(sourceIndex, pc, this->_g_motherboard._processor.getInstruction(),
+                                         this->_g_motherboard._processor.getArguments());
+        }
+        if (conditions._dataProfiler != nullptr)
+        {
+            this->recordDataAccesses(*conditions._dataProfiler, watching, this->_g_motherboard._processor.getInstruction(), ramAddress);
+        }
+        if (conditions._callGraph != nullptr)
+        {
+            conditions._callGraph->record(pc, this->_g_motherboard._processor.getInstruction(), this->_g_motherboard._processor.getArguments(),
+                                          ramAddress, this->_g_motherboard.getProgramCounter());
+        }
+
+        if ( watching && this->checkWatchpoints(*conditions._breakpoints, this->_g_motherboard._processor.getInstruction(), ramAddress) )
+        {
+            result._reason = codeg::StopReason::STOP_WATCHPOINT;
+            break;
+        }
+        if ( (conditions._breakpoints != nullptr) && conditions._breakpoints->hasInstructionTrigger(this->_g_motherboard._processor.getInstruction()) &&
+             conditions._breakpoints->checkInstruction(this->_g_motherboard.getProgramCounter(), this->_g_motherboard._processor) )
+        {
+            result._reason = codeg::StopReason::STOP_BREAKPOINT;
+            break;
+        }
+        if (conditions._stopOnPeripheralEvent)
+        {
+            const uint64_t lastChangeCount = peripheralChangeCount;
+            peripheralChangeCount = this->getPeripheralChangeCount();
+            if (peripheralChangeCount != lastChangeCount)
+            {
+                result._reason = codeg::StopReason::STOP_PERIPHERAL_EVENT;
+                break;
+            }
+        }
+    }
+
+    this->_g_motherboard.setMemoryAccessTracking(false);
+    return result;
+}
+
+///ClockEngine
+
+codeg::RunResult ClockEngine::run(std::size_t maxInstructions, const codeg::StopConditions& conditions)
+{
+    return this->runStepByStep(maxInstructions, conditions, [this](){
+        return this->_g_motherboard._processor.clockUntilSync(20);
+    });
+}
+
+std::string ClockEngine::getType() const
+{
+    return "clock";
+}
+
+///CachedEngine
+
+codeg::RunResult CachedEngine::run(std::size_t maxInstructions, const codeg::StopConditions& conditions)
+{
+    return this->runStepByStep(maxInstructions, conditions, [this](){
+        return this->_g_motherboard.step();
+    });
+}
+
+std::string CachedEngine::getType() const
+{
+    return "cached";
+}
+
+std::unique_ptr<codeg::ExecutionEngine> CreateExecutionEngine(const std::string& type, codeg::GCM_5_1_SPS1& motherboard)
+{
+    if (type == "clock")
+    {
+        return std::make_unique<codeg::ClockEngine>(motherboard);
+    }
+    if (type == "cached")
+    {
+        return std::make_unique<codeg::CachedEngine>(motherboard);
+    }
+    if (type == "threaded")
+    {
+        return std::make_unique<codeg::ThreadedEngine>(motherboard);
+    }
+    if (type == "static")
+    {//The processor must use an Aluminium_1_1 ALU and a MM1 RAM
+        return std::make_unique<codeg::StaticEngineSPS1>(motherboard);
+    }
+    if (type == "block")
+    {
+        return std::make_unique<codeg::PredecodedBlockEngine>(motherboard);
+    }
+    if (type == "native")
+    {//Predecoded blocks when the native code can't be generated for the target
+#ifdef CG_NATIVEBLOCKENGINE_SUPPORTED
+        return std::make_unique<codeg::NativeBlockEngine>(motherboard);
+#else
+        return std::make_unique<codeg::PredecodedBlockEngine>(motherboard);
+#endif
+    }
+    return nullptr;
+}
+
+}//end codeg
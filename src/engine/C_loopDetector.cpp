@@ -0,0 +1,147 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "engine/C_loopDetector.hpp"
+
+namespace codeg
+{
+
+bool MachineState::operator==(const codeg::MachineState& r) const
+{
+    return (this->_programCounter == r._programCounter) &&
+           (this->_memorySource == r._memorySource) &&
+           (this->_busses == r._busses) &&
+           (this->_alu == r._alu) &&
+           (this->_memoryModificationCount == r._memoryModificationCount) &&
+           (this->_peripheralChangeCount == r._peripheralChangeCount) &&
+           (this->_ramAddress == r._ramAddress) &&
+           (this->_instruction == r._instruction) &&
+           (this->_arguments == r._arguments);
+}
+
+LoopDetector::LoopDetector(codeg::GCM_5_1_SPS1& motherboard) :
+        g_motherboard(motherboard)
+{
+}
+
+void LoopDetector::reset()
+{
+    this->g_valid = false;
+    this->g_jumpCount = 0;
+}
+
+std::size_t LoopDetector::onBackwardJump(codeg::MemoryAddress pc, std::size_t count, std::size_t remaining)
+{
+    //Capturing the state is not free, only check from time to time
+    if ( (++this->g_jumpCount % CG_LOOPDETECTOR_CHECK_INTERVAL) != 0 )
+    {
+        return 0;
+    }
+
+    codeg::MachineState state;
+    if ( !this->captureState(pc, state) )
+    {
+        this->g_valid = false;
+        return 0;
+    }
+
+    codeg::GP8B_5_1& processor = this->g_motherboard._processor;
+    if ( this->g_valid && (state == this->g_state) )
+    {//Same state, same address : every iteration will be the same
+        const std::size_t period = count - this->g_count;
+        const std::size_t iterations = (period != 0) ? (remaining / period) : 0;
+        const std::size_t skipped = iterations * period;
+
+        const uint64_t skippedPhases = iterations * (processor.getPhaseCount() - this->g_phaseCount);
+        processor.addPhases(skippedPhases);
+
+        this->g_count = count + skipped;
+        this->g_phaseCount = processor.getPhaseCount();
+        this->g_skippedInstructionCount += skipped;
+        this->g_skippedPhaseCount += skippedPhases;
+        return skipped;
+    }
+
+    this->g_state = state;
+    this->g_count = count;
+    this->g_phaseCount = processor.getPhaseCount();
+    this->g_valid = true;
+    return 0;
+}
+
+uint64_t LoopDetector::getSkippedInstructionCount() const
+{
+    return this->g_skippedInstructionCount;
+}
+uint64_t LoopDetector::getSkippedPhaseCount() const
+{
+    return this->g_skippedPhaseCount;
+}
+
+bool LoopDetector::captureState(codeg::MemoryAddress pc, codeg::MachineState& state) const
+{
+    const codeg::GP8B_5_1& processor = this->g_motherboard._processor;
+
+    if ( !processor._alu || !processor._alu->getPackedState(state._alu) )
+    {
+        return false;
+    }
+
+    for (std::size_t i=0; i<this->g_motherboard.getPeripheralSlotSize(); ++i)
+    {
+        const std::shared_ptr<codeg::Peripheral>& peripheral = this->g_motherboard.getPeripheralSlot(i)->_peripheral;
+        if (peripheral)
+        {
+            if ( !peripheral->isChangeTracked() )
+            {
+                return false;
+            }
+            state._peripheralChangeCount += peripheral->getChangeCount();
+        }
+    }
+
+    //Modification counts only grow, so the sum only stay the same if nothing was written
+    for (std::size_t i=0; i<this->g_motherboard.getMemorySlotSize(); ++i)
+    {
+        const std::shared_ptr<codeg::MemoryModule>& memory = this->g_motherboard.getMemorySlot(i)->_mem;
+        if (memory)
+        {
+            state._memoryModificationCount += memory->getModificationCount();
+        }
+    }
+    for (std::size_t i=0; i<processor.getMemorySlotSize(); ++i)
+    {
+        const std::shared_ptr<codeg::MemoryModule>& memory = processor.getMemorySlot(i)->_mem;
+        if (memory)
+        {
+            state._memoryModificationCount += memory->getModificationCount();
+        }
+    }
+
+    state._programCounter = pc;
+    state._memorySource = this->g_motherboard.getMemorySourceIndex();
+    for (std::size_t i=0; i<codeg::BUS_SPS1_COUNT; ++i)
+    {
+        state._busses[i] = processor._busses.get(i).get();
+    }
+    state._busses[codeg::BUS_SPS1_BDATASRC] = 0; //Deduced from the program counter and can be outdated during a run
+    state._ramAddress = processor.getRamAddress();
+    state._instruction = processor.getInstruction();
+    state._arguments = processor.getArguments();
+    return true;
+}
+
+}//end codeg
@@ -0,0 +1,330 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include "engine/C_nativeBlockEngine.hpp"
+
+#ifdef CG_NATIVEBLOCKENGINE_SUPPORTED
+
+#include <cstring>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+#endif
+
+#define CG_NATIVEBLOCKENGINE_CODE_ALIGNMENT 16
+
+namespace codeg
+{
+
+namespace
+{
+
+/*
+ * The few x86-64 instructions needed by the compiled blocks, every address is an immediate.
+ * The compiled function only use rax and the argument registers (caller-saved) and keep the stack aligned on 16 bytes for the calls.
+ */
+class X86Emitter
+{
+public:
+    X86Emitter() = default;
+    ~X86Emitter() = default;
+
+    void enter()
+    {
+        //sub rsp, stackSize
+        this->emit({0x48, 0x83, 0xEC, StackSize});
+    }
+    void leave(codeg::MemoryAddress pc)
+    {
+        //add rsp, stackSize
+        this->emit({0x48, 0x83, 0xC4, StackSize});
+        //mov rax, pc ; ret
+        this->emit({0x48, 0xB8});
+        this->emit64(pc);
+        this->emit({0xC3});
+    }
+
+    //Replace the bytes of the value selected by the mask, the value must already be masked by the bus
+    void storeBytes(const void* address, uint64_t value, uint64_t mask)
+    {
+        if (mask == 0)
+        {
+            return;
+        }
+        this->loadAddress(address);
+        for (uint8_t i=0; i<sizeof(uint64_t); ++i)
+        {
+            if ((mask >> (i*8)) & 0xFF)
+            {
+                //mov byte [rax+i], value
+                this->emit({0xC6, 0x40, i, static_cast<uint8_t>(value >> (i*8))});
+            }
+        }
+    }
+    void addQword(const uint64_t* address, uint32_t value)
+    {
+        this->loadAddress(address);
+        //add qword [rax], value (sign extended)
+        this->emit({0x48, 0x81, 0x00});
+        this->emit32(value);
+    }
+
+    template<class THandler>
+    void callHandler(THandler handler, const void* engine, const void* decoded, codeg::MemoryAddress pc)
+    {
+#ifdef _WIN32
+        //mov rcx, engine ; mov rdx, decoded ; mov r8, pc
+        this->emit({0x48, 0xB9});
+        this->emit64(reinterpret_cast<uintptr_t>(engine));
+        this->emit({0x48, 0xBA});
+        this->emit64(reinterpret_cast<uintptr_t>(decoded));
+        this->emit({0x49, 0xB8});
+        this->emit64(pc);
+#else
+        //mov rdi, engine ; mov rsi, decoded ; mov rdx, pc
+        this->emit({0x48, 0xBF});
+        this->emit64(reinterpret_cast<uintptr_t>(engine));
+        this->emit({0x48, 0xBE});
+        this->emit64(reinterpret_cast<uintptr_t>(decoded));
+        this->emit({0x48, 0xBA});
+        this->emit64(pc);
+#endif
+        //mov rax, handler ; call rax
+        this->emit({0x48, 0xB8});
+        this->emit64(reinterpret_cast<uintptr_t>(handler));
+        this->emit({0xFF, 0xD0});
+    }
+
+    [[nodiscard]] const std::vector<uint8_t>& getCode() const
+    {
+        return this->g_code;
+    }
+
+private:
+#ifdef _WIN32
+    static constexpr uint8_t StackSize = 40; //32 bytes of shadow space + alignment
+#else
+    static constexpr uint8_t StackSize = 8; //Alignment
+#endif
+
+    void loadAddress(const void* address)
+    {
+        //mov rax, address
+        this->emit({0x48, 0xB8});
+        this->emit64(reinterpret_cast<uintptr_t>(address));
+    }
+
+    void emit(std::initializer_list<uint8_t> bytes)
+    {
+        this->g_code.insert(this->g_code.end(), bytes);
+    }
+    void emit32(uint32_t value)
+    {
+        for (std::size_t i=0; i<sizeof(value); ++i)
+        {
+            this->g_code.push_back(static_cast<uint8_t>(value >> (i*8)));
+        }
+    }
+    void emit64(uint64_t value)
+    {
+        for (std::size_t i=0; i<sizeof(value); ++i)
+        {
+            this->g_code.push_back(static_cast<uint8_t>(value >> (i*8)));
+        }
+    }
+
+    std::vector<uint8_t> g_code;
+};
+
+}//end
+
+//NativeCodeBuffer
+
+NativeCodeBuffer::NativeCodeBuffer(std::size_t size) :
+        g_size(size)
+{
+#ifdef _WIN32
+    this->g_data = static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    this->g_data = (data == MAP_FAILED) ? nullptr : static_cast<uint8_t*>(data);
+#endif
+    if (this->g_data == nullptr)
+    {
+        throw codeg::Error("native engine: can't allocate "+std::to_string(size)+" bytes of executable memory");
+    }
+}
+NativeCodeBuffer::~NativeCodeBuffer()
+{
+#ifdef _WIN32
+    VirtualFree(this->g_data, 0, MEM_RELEASE);
+#else
+    munmap(this->g_data, this->g_size);
+#endif
+}
+
+const uint8_t* NativeCodeBuffer::append(const std::vector<uint8_t>& code)
+{
+    const std::size_t offset = (this->g_usedSize + CG_NATIVEBLOCKENGINE_CODE_ALIGNMENT-1) & ~std::size_t{CG_NATIVEBLOCKENGINE_CODE_ALIGNMENT-1};
+    if ( code.empty() || (offset + code.size() > this->g_size) )
+    {
+        return nullptr;
+    }
+
+    //The buffer is never writable and executable at the same time
+#ifdef _WIN32
+    DWORD oldProtection = 0;
+    if ( !VirtualProtect(this->g_data, this->g_size, PAGE_READWRITE, &oldProtection) )
+    {
+        return nullptr;
+    }
+    std::memcpy(this->g_data + offset, code.data(), code.size());
+    if ( !VirtualProtect(this->g_data, this->g_size, PAGE_EXECUTE_READ, &oldProtection) )
+    {
+        return nullptr;
+    }
+    FlushInstructionCache(GetCurrentProcess(), this->g_data + offset, code.size());
+#else
+    if (mprotect(this->g_data, this->g_size, PROT_READ | PROT_WRITE) != 0)
+    {
+        return nullptr;
+    }
+    std::memcpy(this->g_data + offset, code.data(), code.size());
+    if (mprotect(this->g_data, this->g_size, PROT_READ | PROT_EXEC) != 0)
+    {//Executable memory can be forbidden by the system, the blocks are then only interpreted
+        return nullptr;
+    }
+#endif
+
+    this->g_usedSize = offset + code.size();
+    return this->g_data + offset;
+}
+void NativeCodeBuffer::clear()
+{
+    this->g_usedSize = 0;
+}
+
+std::size_t NativeCodeBuffer::getSize() const
+{
+    return this->g_size;
+}
+std::size_t NativeCodeBuffer::getUsedSize() const
+{
+    return this->g_usedSize;
+}
+
+//NativeBlockEngine
+
+NativeBlockEngine::NativeBlockEngine(codeg::GCM_5_1_SPS1& motherboard) :
+        codeg::PredecodedBlockEngine(motherboard),
+        g_code(CG_NATIVEBLOCKENGINE_CODE_SIZE),
+
+        g_busBJMPSRC(motherboard._processor._busses.get(codeg::BUS_SPS1_BJMPSRC).getData()),
+        g_busBWRITE1(motherboard._processor._busses.get(codeg::BUS_SPS1_BWRITE1).getData()),
+        g_busBWRITE2(motherboard._processor._busses.get(codeg::BUS_SPS1_BWRITE2).getData()),
+        g_busNUMBER(motherboard._processor._busses.get(codeg::BUS_SPS1_NUMBER).getData()),
+        g_busBPCS(motherboard._processor._busses.get(codeg::BUS_SPS1_BPCS).getData()),
+        g_ramAddress(motherboard._processor.getRamAddressData()),
+        g_phaseCount(motherboard._processor.getPhaseCountData())
+{
+}
+
+std::string NativeBlockEngine::getType() const
+{
+    return "native";
+}
+
+void NativeBlockEngine::clearBlocks()
+{
+    codeg::PredecodedBlockEngine::clearBlocks();
+    this->g_code.clear();
+    this->g_compiledBlockCount = 0;
+}
+
+std::size_t NativeBlockEngine::getCompiledBlockCount() const
+{
+    return this->g_compiledBlockCount;
+}
+const codeg::NativeCodeBuffer& NativeBlockEngine::getCodeBuffer() const
+{
+    return this->g_code;
+}
+
+void NativeBlockEngine::compileBlock(Block& block)
+{
+    //The last instruction exit to the runtime
+    std::size_t operationCount = block._operations.size();
+    if ( (operationCount != 0) && isBlockTerminal(block._operations.back()._decoded._opcode) )
+    {
+        --operationCount;
+    }
+    if (operationCount == 0)
+    {
+        return;
+    }
+
+    const std::array<Handler, 256>& handlers = getHandlers();
+    const codeg::ThreadedEngine* engine = this;
+
+    X86Emitter emitter;
+    emitter.enter();
+
+    codeg::MemoryAddress pc = block._startAddress;
+    std::size_t instructionCount = 0;
+    for (std::size_t i=0; i<operationCount; ++i)
+    {
+        const Operation& operation = block._operations[i];
+        const FusedPrefix& prefix = operation._prefix;
+
+        if (operation._instructionCount > 1)
+        {//Same as the fused handler, the values are masked here as Bus::set() is not used
+            emitter.storeBytes(this->g_busBJMPSRC, prefix._jumpValue & codeg::BusSPS1Masks[codeg::BUS_SPS1_BJMPSRC], prefix._jumpMask);
+            emitter.storeBytes(this->g_busBWRITE1, prefix._write1Value & codeg::BusSPS1Masks[codeg::BUS_SPS1_BWRITE1], prefix._write1Mask);
+            emitter.storeBytes(this->g_busBWRITE2, prefix._write2Value & codeg::BusSPS1Masks[codeg::BUS_SPS1_BWRITE2], prefix._write2Mask);
+            emitter.storeBytes(this->g_busBPCS, prefix._pcsValue & codeg::BusSPS1Masks[codeg::BUS_SPS1_BPCS], prefix._pcsMask);
+            emitter.storeBytes(this->g_ramAddress, prefix._ramAddressValue, prefix._ramAddressMask);
+            emitter.storeBytes(this->g_busNUMBER, prefix._number & codeg::BusSPS1Masks[codeg::BUS_SPS1_NUMBER], 0xFF);
+            emitter.addQword(this->g_phaseCount, static_cast<uint32_t>(prefix._phases));
+        }
+        emitter.callHandler(handlers[operation._decoded._instruction], engine, &operation._decoded, pc + prefix._size);
+
+        pc = operation._decoded._nextAddress;
+        instructionCount += operation._instructionCount;
+    }
+
+    emitter.leave(pc);
+
+    const uint8_t* code = this->g_code.append(emitter.getCode());
+    if (code == nullptr)
+    {//Full, interpreted until the next clearBlocks()
+        return;
+    }
+
+    block._compiled = reinterpret_cast<CompiledCode>(reinterpret_cast<uintptr_t>(code));
+    block._compiledOperationCount = operationCount;
+    block._compiledInstructionCount = instructionCount;
+    ++this->g_compiledBlockCount;
+}
+
+}//end codeg
+
+#endif //CG_NATIVEBLOCKENGINE_SUPPORTED
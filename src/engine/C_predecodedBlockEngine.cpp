@@ -0,0 +1,370 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "engine/C_predecodedBlockEngine.hpp"
+#include <algorithm>
+
+namespace codeg
+{
+
+PredecodedBlockEngine::PredecodedBlockEngine(codeg::GCM_5_1_SPS1& motherboard) :
+        codeg::ThreadedEngine(motherboard),
+
+        g_busBJMPSRC(motherboard._processor._busses.get(codeg::BUS_SPS1_BJMPSRC)),
+        g_busBWRITE1(motherboard._processor._busses.get(codeg::BUS_SPS1_BWRITE1)),
+        g_busBWRITE2(motherboard._processor._busses.get(codeg::BUS_SPS1_BWRITE2)),
+        g_busNUMBER(motherboard._processor._busses.get(codeg::BUS_SPS1_NUMBER)),
+        g_busBPCS(motherboard._processor._busses.get(codeg::BUS_SPS1_BPCS))
+{
+}
+
+template<uint8_t TInstruction>
+codeg::MemoryAddress PredecodedBlockEngine::singleHandler(codeg::PredecodedBlockEngine& engine, const Operation& operation, codeg::MemoryAddress pc)
+{
+    return ThreadedEngine::handler<TInstruction>(engine, operation._decoded, pc);
+}
+
+template<uint8_t TInstruction>
+codeg::MemoryAddress PredecodedBlockEngine::fusedHandler(codeg::PredecodedBlockEngine& engine, const Operation& operation, codeg::MemoryAddress pc)
+{
+    const FusedPrefix& prefix = operation._prefix;
+
+    engine.g_busBJMPSRC.set( (engine.g_busBJMPSRC.get() & ~prefix._jumpMask) | prefix._jumpValue );
+    engine.g_busBWRITE1.set( (engine.g_busBWRITE1.get() & ~prefix._write1Mask) | prefix._write1Value );
+    engine.g_busBWRITE2.set( (engine.g_busBWRITE2.get() & ~prefix._write2Mask) | prefix._write2Value );
+    engine.g_busBPCS.set( (engine.g_busBPCS.get() & ~prefix._pcsMask) | prefix._pcsValue );
+    engine._g_processor.setRamAddress( (engine._g_processor.getRamAddress() & ~prefix._ramAddressMask) | prefix._ramAddressValue );
+
+    //An external readable bus can return the previous NUMBER value
+    engine.g_busNUMBER.set(prefix._number);
+    engine._g_processor.addPhases(prefix._phases);
+
+    return ThreadedEngine::handler<TInstruction>(engine, operation._decoded, pc + prefix._size);
+}
+
+template<std::size_t... TIndex>
+constexpr std::array<PredecodedBlockEngine::OperationHandler, 256> PredecodedBlockEngine::makeSingleHandlerTable([[maybe_unused]] std::index_sequence<TIndex...> indexes)
+{
+    return {{&PredecodedBlockEngine::singleHandler<static_cast<uint8_t>(TIndex)>...}};
+}
+template<std::size_t... TIndex>
+constexpr std::array<PredecodedBlockEngine::OperationHandler, 256> PredecodedBlockEngine::makeFusedHandlerTable([[maybe_unused]] std::index_sequence<TIndex...> indexes)
+{
+    return {{&PredecodedBlockEngine::fusedHandler<static_cast<uint8_t>(TIndex)>...}};
+}
+
+const std::array<PredecodedBlockEngine::OperationHandler, 256>& PredecodedBlockEngine::getSingleHandlers()
+{
+    static constexpr std::array<OperationHandler, 256> handlers = makeSingleHandlerTable(std::make_index_sequence<256>{});
+    return handlers;
+}
+const std::array<PredecodedBlockEngine::OperationHandler, 256>& PredecodedBlockEngine::getFusedHandlers()
+{
+    static constexpr std::array<OperationHandler, 256> handlers = makeFusedHandlerTable(std::make_index_sequence<256>{});
+    return handlers;
+}
+
+codeg::RunResult PredecodedBlockEngine::run(std::size_t maxInstructions, const codeg::StopConditions& conditions)
+{
+    const std::array<Handler, 256>& handlers = getHandlers();
+
+    if ( conditions._stopAtProgramCounter || conditions._stopOnPeripheralEvent ||
+         conditions.hasWatchpoints() || conditions.hasInstructionTriggers() || conditions.isProfiling() )
+    {
+        return codeg::ThreadedEngine::run(maxInstructions, conditions);
+    }
+    //Only breakpoints and conditions triggered by a program counter are checked at the block level
+    codeg::BreakpointSet* breakpoints = conditions.hasBreakpoints() ? conditions._breakpoints : nullptr;
+
+    codeg::RunResult result;
+    if (maxInstructions == 0)
+    {
+        return result;
+    }
+    if ( !this->prepareRun(result._instructionCount) )
+    {
+        result._reason = codeg::StopReason::STOP_UNSYNC_TIMEOUT;
+        return result;
+    }
+
+    std::size_t& count = result._instructionCount;
+    const std::size_t resumeCount = count;
+    const uint64_t skippedInstructionCount = this->_g_loopDetector.getSkippedInstructionCount();
+    const uint64_t skippedPhaseCount = this->_g_loopDetector.getSkippedPhaseCount();
+    codeg::MemoryAddress pc = this->_g_motherboard.getProgramCounter();
+
+    while (count < maxInstructions)
+    {
+        const codeg::MemoryModuleSlot* sourceSlot = this->_g_motherboard.getMemorySourceSlot();
+        if ( (sourceSlot == nullptr) || !sourceSlot->_mem )
+        {
+            result._reason = codeg::StopReason::STOP_UNSYNC_TIMEOUT;
+            break;
+        }
+        const std::shared_ptr<codeg::MemoryModule>& memory = sourceSlot->_mem;
+
+        if ( (memory.get() != this->g_memory.get()) || (memory->getModificationCount() != this->g_modificationCount) )
+        {//Translated blocks are no longer valid
+            this->clearBlocks();
+            this->g_memory = memory;
+            this->g_modificationCount = memory->getModificationCount();
+        }
+
+        const codeg::MemoryAddress blockPc = pc;
+        auto it = this->g_blocks.find(pc);
+        if (it == this->g_blocks.end())
+        {
+            if (++this->g_hotness[pc] < CG_PREDECODEDBLOCKENGINE_HOT_THRESHOLD)
+            {//Not hot enough, interpret until the end of the block
+                codeg::CodegBinaryRev1 opcode;
+                do
+                {
+                    if ( (breakpoints != nullptr) && (count != resumeCount) &&
+                         breakpoints->hasProgramCounterTrigger(pc) && this->checkProgramCounter(*breakpoints, pc) )
+                    {
+                        result._reason = codeg::StopReason::STOP_BREAKPOINT;
+                        break;
+                    }
+
+                    const codeg::DecodedInstruction& decoded = this->_g_cache.get(memory, pc);
+                    opcode = decoded._opcode;
+                    pc = handlers[decoded._instruction](*this, decoded, pc);
+                    ++count;
+                }
+                while ( (count < maxInstructions) && !isBlockTerminal(opcode) );
+
+                if (result._reason == codeg::StopReason::STOP_BREAKPOINT)
+                {
+                    break;
+                }
+                if ( (pc <= blockPc) && this->_g_fastForward )
+                {
+                    count += this->_g_loopDetector.onBackwardJump(pc, count, maxInstructions-count);
+                }
+                continue;
+            }
+
+            it = this->g_blocks.emplace(pc, this->translate(*memory, pc)).first;
+            this->compileBlock(it->second);
+        }
+
+        if ( (breakpoints != nullptr) && breakpoints->hasProgramCounterTriggerInRange(blockPc, it->second._endAddress) )
+        {//A breakpoint or a condition is inside the block, execute it instruction by instruction
+            this->_g_motherboard.setProgramCounter(pc);
+            result._reason = this->runInstructions<true>(count, std::min(maxInstructions, count+it->second._instructionCount),
+                                                         conditions, resumeCount);
+            pc = this->_g_motherboard.getProgramCounter();
+
+            if (result._reason != codeg::StopReason::STOP_BUDGET_EXHAUSTED)
+            {
+                break;
+            }
+            continue;
+        }
+
+        const Block& block = it->second;
+        std::size_t operationIndex = 0;
+        if ( (block._compiled != nullptr) && (count+block._compiledInstructionCount <= maxInstructions) )
+        {
+            pc = block._compiled();
+            count += block._compiledInstructionCount;
+            operationIndex = block._compiledOperationCount;
+        }
+
+        for (; operationIndex<block._operations.size(); ++operationIndex)
+        {
+            const Operation& operation = block._operations[operationIndex];
+            if (count+operation._instructionCount > maxInstructions)
+            {//Not enough budget for the whole operation, finish instruction by instruction
+                while (count < maxInstructions)
+                {
+                    const codeg::DecodedInstruction& decoded = this->_g_cache.get(memory, pc);
+                    pc = handlers[decoded._instruction](*this, decoded, pc);
+                    ++count;
+                }
+                break;
+            }
+            pc = operation._handler(*this, operation, pc);
+            count += operation._instructionCount;
+        }
+
+        if ( (pc <= blockPc) && this->_g_fastForward && (count < maxInstructions) )
+        {
+            count += this->_g_loopDetector.onBackwardJump(pc, count, maxInstructions-count);
+        }
+    }
+
+    //Like the threaded engine, a breakpoint at the address where the budget is exhausted is reported,
+    //else the next run would start on it and ignore it
+    if ( (result._reason == codeg::StopReason::STOP_BUDGET_EXHAUSTED) && (breakpoints != nullptr) && (count != resumeCount) &&
+         breakpoints->hasProgramCounterTrigger(pc) && this->checkProgramCounter(*breakpoints, pc) )
+    {
+        result._reason = codeg::StopReason::STOP_BREAKPOINT;
+    }
+
+    result._skippedInstructionCount = static_cast<std::size_t>(this->_g_loopDetector.getSkippedInstructionCount() - skippedInstructionCount);
+    result._skippedPhaseCount = this->_g_loopDetector.getSkippedPhaseCount() - skippedPhaseCount;
+
+    this->_g_motherboard.setProgramCounter(pc);
+    return result;
+}
+
+std::string PredecodedBlockEngine::getType() const
+{
+    return "block";
+}
+
+void PredecodedBlockEngine::clearBlocks()
+{
+    this->g_blocks.clear();
+    this->g_hotness.clear();
+    this->g_memory.reset();
+    this->g_modificationCount = 0;
+}
+std::size_t PredecodedBlockEngine::getBlockCount() const
+{
+    return this->g_blocks.size();
+}
+
+bool PredecodedBlockEngine::isBlockTerminal(codeg::CodegBinaryRev1 opcode)
+{
+    switch (opcode)
+    {
+    case codeg::CodegBinaryRev1::OPCODE_JMPSRC_CLK:
+    case codeg::CodegBinaryRev1::OPCODE_IF:
+    case codeg::CodegBinaryRev1::OPCODE_IFNOT:
+    case codeg::CodegBinaryRev1::OPCODE_PERIPHERAL_CLK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool PredecodedBlockEngine::isFusable(const codeg::DecodedInstruction& decoded)
+{
+    if (decoded._bus != codeg::CodegBinaryRev1Busses::READABLE_SOURCE)
+    {
+        return false;
+    }
+
+    switch (decoded._opcode)
+    {
+    case codeg::CodegBinaryRev1::OPCODE_BWRITE1_CLK:
+    case codeg::CodegBinaryRev1::OPCODE_BWRITE2_CLK:
+    case codeg::CodegBinaryRev1::OPCODE_BPCS_CLK:
+    case codeg::CodegBinaryRev1::OPCODE_BJMPSRC1_CLK:
+    case codeg::CodegBinaryRev1::OPCODE_BJMPSRC2_CLK:
+    case codeg::CodegBinaryRev1::OPCODE_BJMPSRC3_CLK:
+    case codeg::CodegBinaryRev1::OPCODE_BRAMADD1_CLK:
+    case codeg::CodegBinaryRev1::OPCODE_BRAMADD2_CLK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void PredecodedBlockEngine::appendToPrefix(FusedPrefix& prefix, const codeg::DecodedInstruction& decoded)
+{
+    const uint8_t value = decoded._immediate;
+
+    switch (decoded._opcode)
+    {
+    case codeg::CodegBinaryRev1::OPCODE_BWRITE1_CLK:
+        prefix._write1Mask = 0xFF;
+        prefix._write1Value = value;
+        break;
+    case codeg::CodegBinaryRev1::OPCODE_BWRITE2_CLK:
+        prefix._write2Mask = 0xFF;
+        prefix._write2Value = value;
+        break;
+    case codeg::CodegBinaryRev1::OPCODE_BPCS_CLK:
+        prefix._pcsMask = 0xFF;
+        prefix._pcsValue = value;
+        break;
+    case codeg::CodegBinaryRev1::OPCODE_BJMPSRC1_CLK:
+        prefix._jumpMask |= 0x000000FFu;
+        prefix._jumpValue = (prefix._jumpValue & ~0x000000FFu) | static_cast<uint32_t>(value);
+        break;
+    case codeg::CodegBinaryRev1::OPCODE_BJMPSRC2_CLK:
+        prefix._jumpMask |= 0x0000FF00u;
+        prefix._jumpValue = (prefix._jumpValue & ~0x0000FF00u) | (static_cast<uint32_t>(value)<<8);
+        break;
+    case codeg::CodegBinaryRev1::OPCODE_BJMPSRC3_CLK:
+        prefix._jumpMask |= 0x00FF0000u;
+        prefix._jumpValue = (prefix._jumpValue & ~0x00FF0000u) | (static_cast<uint32_t>(value)<<16);
+        break;
+    case codeg::CodegBinaryRev1::OPCODE_BRAMADD1_CLK:
+        prefix._ramAddressMask |= 0x00FF;
+        prefix._ramAddressValue = (prefix._ramAddressValue & 0xFF00) | static_cast<uint16_t>(value);
+        break;
+    case codeg::CodegBinaryRev1::OPCODE_BRAMADD2_CLK:
+        prefix._ramAddressMask |= 0xFF00;
+        prefix._ramAddressValue = (prefix._ramAddressValue & 0x00FF) | (static_cast<uint16_t>(value)<<8);
+        break;
+    default:
+        break;
+    }
+
+    prefix._number = value;
+    prefix._size += 2; //Instruction + immediate
+    prefix._phases += codeg::GP8B_5_1::getInstructionPhases(decoded._instruction, value);
+}
+
+codeg::PredecodedBlockEngine::Block PredecodedBlockEngine::translate(const codeg::MemoryModule& memory, codeg::MemoryAddress address) const
+{
+    const std::array<OperationHandler, 256>& singleHandlers = getSingleHandlers();
+    const std::array<OperationHandler, 256>& fusedHandlers = getFusedHandlers();
+    Block block;
+    block._startAddress = address;
+    std::size_t blockSize = 0;
+
+    do
+    {
+        Operation operation;
+        operation._decoded = codeg::DecodeInstruction(memory, address);
+        address = operation._decoded._nextAddress;
+        ++blockSize;
+
+        while ( isFusable(operation._decoded) &&
+                (operation._instructionCount < CG_PREDECODEDBLOCKENGINE_MAX_FUSED_SIZE) &&
+                (blockSize < CG_PREDECODEDBLOCKENGINE_MAX_BLOCK_SIZE) )
+        {//Constant load, fuse it with the next instruction
+            appendToPrefix(operation._prefix, operation._decoded);
+            operation._decoded = codeg::DecodeInstruction(memory, address);
+            address = operation._decoded._nextAddress;
+            ++operation._instructionCount;
+            ++blockSize;
+        }
+
+        if (operation._instructionCount > 1)
+        {
+            operation._handler = fusedHandlers[operation._decoded._instruction];
+        }
+        else
+        {
+            operation._handler = singleHandlers[operation._decoded._instruction];
+        }
+        block._operations.push_back(operation);
+    }
+    while ( !isBlockTerminal(block._operations.back()._decoded._opcode) &&
+            (blockSize < CG_PREDECODEDBLOCKENGINE_MAX_BLOCK_SIZE) );
+
+    block._endAddress = address;
+    block._instructionCount = blockSize;
+    return block;
+}
+
+}//end codeg
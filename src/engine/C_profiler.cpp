@@ -0,0 +1,255 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "engine/C_profiler.hpp"
+#include "processor/C_instructionCache.hpp"
+#include "processor/C_ALUminium_1_1.hpp"
+#include "C_string.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace codeg
+{
+
+namespace
+{
+
+std::string Disassemble(const codeg::Motherboard& motherboard, std::size_t sourceIndex, codeg::MemoryAddress address)
+{
+    const codeg::MemoryModuleSlot* slot = motherboard.getMemorySlot(sourceIndex);
+    if ( (slot == nullptr) || !slot->_mem )
+    {
+        return "?";
+    }
+    return codeg::DisassembleInstruction(codeg::DecodeInstruction(*slot->_mem, address));
+}
+
+double Percent(uint64_t count, uint64_t total)
+{
+    return (total == 0) ? 0.0 : 100.0 * static_cast<double>(count) / static_cast<double>(total);
+}
+
+}//end
+
+void ExecutionProfiler::clear()
+{
+    this->g_addresses.clear();
+    this->g_instructions.fill(0);
+    this->g_aluResults.fill(0);
+    this->g_aluSelections.fill(0);
+    this->g_aluOperation = 0;
+}
+
+uint64_t ExecutionProfiler::getInstructionCount() const
+{
+    uint64_t count = 0;
+    for (uint64_t instructionCount : this->g_instructions)
+    {
+        count += instructionCount;
+    }
+    return count;
+}
+uint64_t ExecutionProfiler::getInstructionCount(uint8_t instruction) const
+{
+    return this->g_instructions[instruction];
+}
+uint64_t ExecutionProfiler::getOpcodeCount(codeg::CodegBinaryRev1 opcode) const
+{
+    uint64_t count = 0;
+    for (std::size_t i=0; i<this->g_instructions.size(); ++i)
+    {
+        if ( (i&CG_CODEGBINARYREV1_OPCODE_MASK) == static_cast<std::size_t>(opcode) )
+        {
+            count += this->g_instructions[i];
+        }
+    }
+    return count;
+}
+uint64_t ExecutionProfiler::getBusCount(codeg::CodegBinaryRev1Busses bus) const
+{
+    uint64_t count = 0;
+    for (std::size_t i=0; i<this->g_instructions.size(); ++i)
+    {
+        if ( (i&CG_CODEGBINARYREV1_BUSSES_MASK) == static_cast<std::size_t>(bus) )
+        {
+            count += this->g_instructions[i];
+        }
+    }
+    return count;
+}
+uint64_t ExecutionProfiler::getAluResultCount(uint8_t operation) const
+{
+    return this->g_aluResults[operation];
+}
+uint64_t ExecutionProfiler::getAluSelectionCount(uint8_t operation) const
+{
+    return this->g_aluSelections[operation];
+}
+
+const codeg::ProfilerAddressCounters* ExecutionProfiler::getCounters(std::size_t sourceIndex, codeg::MemoryAddress address) const
+{
+    if ( (sourceIndex < this->g_addresses.size()) && (address < this->g_addresses[sourceIndex].size()) &&
+         (this->g_addresses[sourceIndex][address]._executions != 0) )
+    {
+        return &this->g_addresses[sourceIndex][address];
+    }
+    return nullptr;
+}
+
+void ExecutionProfiler::writeReport(std::ostream& stream, const codeg::Motherboard& motherboard, std::size_t top) const
+{
+    const uint64_t total = this->getInstructionCount();
+    const std::vector<HotSpot> hotSpots = this->getSortedHotSpots();
+
+    stream << std::fixed << std::setprecision(2);
+    stream << "instructions: " << total << " at " << hotSpots.size() << " addresses\n";
+
+    stream << "hot spots:\n";
+    for (std::size_t i=0; i<hotSpots.size() && i<top; ++i)
+    {
+        const HotSpot& hotSpot = hotSpots[i];
+        stream << '\t' << hotSpot._sourceIndex << ':' << codeg::ValueToHex(hotSpot._address, 6) << ' '
+               << std::setw(12) << hotSpot._counters._executions << ' '
+               << std::setw(6) << Percent(hotSpot._counters._executions, total) << "% "
+               << Disassemble(motherboard, hotSpot._sourceIndex, hotSpot._address) << '\n';
+    }
+
+    stream << "opcodes:\n";
+    for (uint8_t opcode=0; opcode<=CG_CODEGBINARYREV1_OPCODE_MASK; ++opcode)
+    {
+        const uint64_t count = this->getOpcodeCount(static_cast<codeg::CodegBinaryRev1>(opcode));
+        if (count != 0)
+        {
+            stream << '\t' << std::setw(16) << std::left << codeg::OpcodeToString(static_cast<codeg::CodegBinaryRev1>(opcode)) << std::right
+                   << std::setw(12) << count << ' ' << std::setw(6) << Percent(count, total) << "%\n";
+        }
+    }
+
+    stream << "readable busses:\n";
+    for (std::size_t bus=0; bus<256; bus+=0x20)
+    {
+        const uint64_t count = this->getBusCount(static_cast<codeg::CodegBinaryRev1Busses>(bus));
+        if (count != 0)
+        {
+            stream << '\t' << std::setw(16) << std::left << codeg::BusToString(static_cast<codeg::CodegBinaryRev1Busses>(bus)) << std::right
+                   << std::setw(12) << count << ' ' << std::setw(6) << Percent(count, total) << "%\n";
+        }
+    }
+
+    stream << "ALU operations (results read, selections):\n";
+    for (std::size_t operation=0; operation<256; ++operation)
+    {
+        if ( (this->g_aluResults[operation] != 0) || (this->g_aluSelections[operation] != 0) )
+        {
+            stream << '\t' << std::setw(16) << std::left << codeg::AluminiumOperationToString(static_cast<uint8_t>(operation)) << std::right
+                   << std::setw(12) << this->g_aluResults[operation] << std::setw(12) << this->g_aluSelections[operation] << '\n';
+        }
+    }
+
+    stream << "branches (taken = the next byte is skipped):\n";
+    for (const HotSpot& hotSpot : hotSpots)
+    {
+        const codeg::MemoryModuleSlot* slot = motherboard.getMemorySlot(hotSpot._sourceIndex);
+        if ( (slot == nullptr) || !slot->_mem )
+        {
+            continue;
+        }
+        const codeg::DecodedInstruction decoded = codeg::DecodeInstruction(*slot->_mem, hotSpot._address);
+        if ( (decoded._opcode == codeg::CodegBinaryRev1::OPCODE_IF) || (decoded._opcode == codeg::CodegBinaryRev1::OPCODE_IFNOT) )
+        {
+            stream << '\t' << hotSpot._sourceIndex << ':' << codeg::ValueToHex(hotSpot._address, 6) << ' '
+                   << "taken: " << hotSpot._counters._taken << " not taken: " << hotSpot._counters._executions-hotSpot._counters._taken << ' '
+                   << codeg::DisassembleInstruction(decoded) << '\n';
+        }
+    }
+}
+
+bool ExecutionProfiler::saveCsv(const std::filesystem::path& path, const codeg::Motherboard& motherboard) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    const uint64_t total = this->getInstructionCount();
+
+    file << std::fixed << std::setprecision(4);
+    file << "source,address,executions,percent,taken,not_taken,disassembly\n";
+    for (const HotSpot& hotSpot : this->getSortedHotSpots())
+    {
+        file << hotSpot._sourceIndex << ',' << hotSpot._address << ',' << hotSpot._counters._executions << ','
+             << Percent(hotSpot._counters._executions, total) << ',';
+
+        const codeg::MemoryModuleSlot* slot = motherboard.getMemorySlot(hotSpot._sourceIndex);
+        if ( (slot == nullptr) || !slot->_mem )
+        {
+            file << ",,\"?\"\n";
+            continue;
+        }
+
+        const codeg::DecodedInstruction decoded = codeg::DecodeInstruction(*slot->_mem, hotSpot._address);
+        if ( (decoded._opcode == codeg::CodegBinaryRev1::OPCODE_IF) || (decoded._opcode == codeg::CodegBinaryRev1::OPCODE_IFNOT) )
+        {
+            file << hotSpot._counters._taken << ',' << hotSpot._counters._executions-hotSpot._counters._taken;
+        }
+        else
+        {
+            file << ',';
+        }
+        file << ",\"" << codeg::DisassembleInstruction(decoded) << "\"\n";
+    }
+
+    return static_cast<bool>(file);
+}
+
+std::vector<ExecutionProfiler::HotSpot> ExecutionProfiler::getSortedHotSpots() const
+{
+    std::vector<HotSpot> hotSpots;
+    for (std::size_t sourceIndex=0; sourceIndex<this->g_addresses.size(); ++sourceIndex)
+    {
+        const std::vector<codeg::ProfilerAddressCounters>& addresses = this->g_addresses[sourceIndex];
+        for (std::size_t address=0; address<addresses.size(); ++address)
+        {
+            if (addresses[address]._executions != 0)
+            {
+                hotSpots.push_back({sourceIndex, address, addresses[address]});
+            }
+        }
+    }
+
+    std::stable_sort(hotSpots.begin(), hotSpots.end(), [](const HotSpot& a, const HotSpot& b){
+        return a._counters._executions > b._counters._executions;
+    });
+    return hotSpots;
+}
+
+codeg::ProfilerAddressCounters& ExecutionProfiler::growCounters(std::size_t sourceIndex, codeg::MemoryAddress address)
+{
+    if (sourceIndex >= this->g_addresses.size())
+    {
+        this->g_addresses.resize(sourceIndex+1);
+    }
+    std::vector<codeg::ProfilerAddressCounters>& addresses = this->g_addresses[sourceIndex];
+    if (address >= addresses.size())
+    {
+        addresses.resize( (address/CG_PROFILER_PAGE_SIZE + 1) * CG_PROFILER_PAGE_SIZE );
+    }
+    return addresses[address];
+}
+
+}//end codeg
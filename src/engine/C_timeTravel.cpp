@@ -0,0 +1,338 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include "engine/C_timeTravel.hpp"
+#include "C_snapshot.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace codeg
+{
+
+namespace
+{
+
+constexpr std::size_t NoCheckpoint = std::numeric_limits<std::size_t>::max();
+
+}//end
+
+TimeTravel::TimeTravel(codeg::Motherboard& motherboard, codeg::ExecutionEngine& engine, std::size_t memoryBudget) :
+        g_motherboard(motherboard),
+        g_engine(engine),
+        g_memoryBudget(memoryBudget)
+{}
+
+codeg::RunResult TimeTravel::run(std::size_t maxInstructions, const codeg::StopConditions& conditions)
+{
+    //The future can be different (conditions, inputs), it will be recorded again
+    while ( !this->g_checkpoints.empty() && (this->g_checkpoints.back()._cycle > this->g_cycle) )
+    {
+        this->g_memoryUsage -= this->g_checkpoints.back()._memoryUsage;
+        this->g_checkpoints.pop_back();
+    }
+    if (this->g_checkpoints.empty())
+    {
+        this->takeCheckpoint();
+    }
+
+    codeg::RunResult result;
+    while (result._instructionCount < maxInstructions)
+    {
+        const uint64_t nextCheckpoint = this->g_checkpoints.back()._cycle + this->g_interval;
+        if (this->g_cycle >= nextCheckpoint)
+        {
+            this->takeCheckpoint();
+            continue;
+        }
+
+        //A run stopped by the budget report a breakpoint at its last address, so chunks don't miss any hit
+        const auto chunk = static_cast<std::size_t>( std::min<uint64_t>(maxInstructions - result._instructionCount, nextCheckpoint - this->g_cycle) );
+
+        const auto start = std::chrono::steady_clock::now();
+        const codeg::RunResult chunkResult = this->g_engine.run(chunk, conditions);
+        this->updateInterval(chunkResult._instructionCount, std::chrono::steady_clock::now() - start);
+
+        this->g_cycle += chunkResult._instructionCount;
+        result._instructionCount += chunkResult._instructionCount;
+        result._skippedInstructionCount += chunkResult._skippedInstructionCount;
+        result._skippedPhaseCount += chunkResult._skippedPhaseCount;
+
+        if ( (chunkResult._reason != codeg::StopReason::STOP_BUDGET_EXHAUSTED) || (chunkResult._instructionCount == 0) )
+        {
+            result._reason = chunkResult._reason;
+            break;
+        }
+    }
+    return result;
+}
+
+bool TimeTravel::gotoCycle(uint64_t cycle)
+{
+    const std::size_t index = this->findCheckpoint(cycle);
+
+    //Use the nearest checkpoint if it's closer than the current state
+    if (cycle < this->g_cycle)
+    {
+        if (index == NoCheckpoint)
+        {
+            return false;
+        }
+        this->restoreCheckpoint(this->g_checkpoints[index]);
+    }
+    else if ( (index != NoCheckpoint) && (this->g_checkpoints[index]._cycle > this->g_cycle) )
+    {
+        this->restoreCheckpoint(this->g_checkpoints[index]);
+    }
+
+    //The known history is executed again without being recorded
+    if ( !this->g_checkpoints.empty() && (this->g_checkpoints.back()._cycle > this->g_cycle) )
+    {
+        return this->executeUntil(cycle);
+    }
+
+    const uint64_t remaining = cycle - this->g_cycle;
+    return this->run(static_cast<std::size_t>(remaining), codeg::StopConditions{})._instructionCount == remaining;
+}
+bool TimeTravel::stepBack(uint64_t count)
+{
+    if (count > this->g_cycle)
+    {
+        return false;
+    }
+    return this->gotoCycle(this->g_cycle - count);
+}
+codeg::RunResult TimeTravel::reverseContinue(const codeg::StopConditions& conditions)
+{
+    codeg::RunResult result;
+    const uint64_t start = this->g_cycle;
+
+    if ( (start == 0) || this->g_checkpoints.empty() || (this->g_checkpoints.front()._cycle >= start) )
+    {
+        return result;
+    }
+
+    //Only breakpoints and watchpoints are searched
+    codeg::StopConditions scanConditions;
+    scanConditions._breakpoints = conditions._breakpoints;
+
+    //Every interval is scanned from the most recent one, a hit exactly on a checkpoint is found
+    //at the end of the previous interval as the first instruction of a run ignore breakpoints
+    uint64_t end = start;
+    std::size_t index = this->findCheckpoint(start - 1);
+    while (true)
+    {
+        const codeg::TimeTravelCheckpoint& checkpoint = this->g_checkpoints[index];
+
+        bool found = false;
+        uint64_t lastHit = 0;
+        if ( conditions.hasBreakpoints() )
+        {
+            this->restoreCheckpoint(checkpoint);
+            while (this->g_cycle < end)
+            {
+                const codeg::RunResult scanResult = this->g_engine.run(static_cast<std::size_t>(end - this->g_cycle), scanConditions);
+                this->g_cycle += scanResult._instructionCount;
+
+                if ( (scanResult._reason == codeg::StopReason::STOP_BREAKPOINT) || (scanResult._reason == codeg::StopReason::STOP_WATCHPOINT) )
+                {
+                    if (this->g_cycle < start)
+                    {
+                        found = true;
+                        lastHit = this->g_cycle;
+                    }
+                }
+                else if (scanResult._reason != codeg::StopReason::STOP_BUDGET_EXHAUSTED)
+                {
+                    result._reason = scanResult._reason;
+                    return result;
+                }
+                else if (scanResult._instructionCount == 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        if (found)
+        {//Execute again until the hit so the breakpoint set describe it
+            this->restoreCheckpoint(checkpoint);
+            while (this->g_cycle < lastHit)
+            {
+                const codeg::RunResult hitResult = this->g_engine.run(static_cast<std::size_t>(lastHit - this->g_cycle), scanConditions);
+                this->g_cycle += hitResult._instructionCount;
+                result._reason = hitResult._reason;
+                if (hitResult._instructionCount == 0)
+                {
+                    break;
+                }
+            }
+            result._instructionCount = static_cast<std::size_t>(start - this->g_cycle);
+            return result;
+        }
+
+        if (index == 0)
+        {//Beginning of the history
+            this->restoreCheckpoint(checkpoint);
+            result._instructionCount = static_cast<std::size_t>(start - this->g_cycle);
+            return result;
+        }
+        end = checkpoint._cycle;
+        --index;
+    }
+}
+
+void TimeTravel::reset()
+{
+    this->g_checkpoints.clear();
+    this->g_memoryUsage = 0;
+    this->g_cycle = 0;
+}
+
+uint64_t TimeTravel::getCycle() const
+{
+    return this->g_cycle;
+}
+uint64_t TimeTravel::getFirstCycle() const
+{
+    return this->g_checkpoints.empty() ? this->g_cycle : this->g_checkpoints.front()._cycle;
+}
+
+void TimeTravel::setMemoryBudget(std::size_t memoryBudget)
+{
+    this->g_memoryBudget = memoryBudget;
+    this->trimCheckpoints();
+}
+std::size_t TimeTravel::getMemoryBudget() const
+{
+    return this->g_memoryBudget;
+}
+std::size_t TimeTravel::getMemoryUsage() const
+{
+    return this->g_memoryUsage;
+}
+
+void TimeTravel::setLatencyTarget(std::chrono::microseconds latency)
+{
+    this->g_latencyTarget = latency;
+}
+std::chrono::microseconds TimeTravel::getLatencyTarget() const
+{
+    return this->g_latencyTarget;
+}
+
+std::size_t TimeTravel::getCheckpointCount() const
+{
+    return this->g_checkpoints.size();
+}
+uint64_t TimeTravel::getInterval() const
+{
+    return this->g_interval;
+}
+
+void TimeTravel::takeCheckpoint()
+{
+    const codeg::MemoryModuleStore* previous = this->g_checkpoints.empty() ? nullptr : &this->g_checkpoints.back()._memory;
+
+    codeg::TimeTravelCheckpoint checkpoint;
+    checkpoint._cycle = this->g_cycle;
+
+    codeg::SnapshotWriter writer;
+    writer.setMemoryStore(&checkpoint._memory, previous);
+    this->g_motherboard.saveState(writer);
+    checkpoint._state = writer.takeData();
+    checkpoint._memoryUsage = checkpoint._state.size() + checkpoint._memory.getUnsharedSize(previous);
+
+    this->g_memoryUsage += checkpoint._memoryUsage;
+    this->g_checkpoints.push_back(std::move(checkpoint));
+
+    this->trimCheckpoints();
+}
+std::size_t TimeTravel::findCheckpoint(uint64_t cycle) const
+{
+    auto it = std::upper_bound(this->g_checkpoints.cbegin(), this->g_checkpoints.cend(), cycle,
+                               [](uint64_t value, const codeg::TimeTravelCheckpoint& checkpoint){
+        return value < checkpoint._cycle;
+    });
+    if (it == this->g_checkpoints.cbegin())
+    {
+        return NoCheckpoint;
+    }
+    return static_cast<std::size_t>(it - this->g_checkpoints.cbegin()) - 1;
+}
+void TimeTravel::restoreCheckpoint(const codeg::TimeTravelCheckpoint& checkpoint)
+{
+    codeg::SnapshotReader reader(checkpoint._state.data(), checkpoint._state.size());
+    reader.setMemoryStore(&checkpoint._memory);
+    this->g_motherboard.loadState(reader);
+    this->g_cycle = checkpoint._cycle;
+}
+bool TimeTravel::executeUntil(uint64_t cycle)
+{
+    while (this->g_cycle < cycle)
+    {
+        const codeg::RunResult result = this->g_engine.run(static_cast<std::size_t>(cycle - this->g_cycle), codeg::StopConditions{});
+        this->g_cycle += result._instructionCount;
+        if ( (result._reason != codeg::StopReason::STOP_BUDGET_EXHAUSTED) || (result._instructionCount == 0) )
+        {
+            break;
+        }
+    }
+    return this->g_cycle == cycle;
+}
+void TimeTravel::trimCheckpoints()
+{
+    while ( (this->g_memoryUsage > this->g_memoryBudget) && (this->g_checkpoints.size() > CG_TIMETRAVEL_MIN_CHECKPOINTS) )
+    {
+        //Remove the checkpoint that leave the smallest hole, the first and the last are always kept
+        std::size_t best = 1;
+        uint64_t bestGap = std::numeric_limits<uint64_t>::max();
+        for (std::size_t i=1; i+1<this->g_checkpoints.size(); ++i)
+        {
+            const uint64_t gap = this->g_checkpoints[i+1]._cycle - this->g_checkpoints[i-1]._cycle;
+            if (gap < bestGap)
+            {
+                bestGap = gap;
+                best = i;
+            }
+        }
+
+        //The next checkpoint now own the memory it shared with the removed one
+        codeg::TimeTravelCheckpoint& next = this->g_checkpoints[best+1];
+        const std::size_t nextUsage = next._state.size() + next._memory.getUnsharedSize(&this->g_checkpoints[best-1]._memory);
+
+        this->g_memoryUsage = this->g_memoryUsage - this->g_checkpoints[best]._memoryUsage - next._memoryUsage + nextUsage;
+        next._memoryUsage = nextUsage;
+        this->g_checkpoints.erase(this->g_checkpoints.begin() + static_cast<std::ptrdiff_t>(best));
+    }
+}
+void TimeTravel::updateInterval(std::size_t instructionCount, std::chrono::steady_clock::duration duration)
+{
+    const double seconds = std::chrono::duration<double>(duration).count();
+    if ( (instructionCount < CG_TIMETRAVEL_MIN_INTERVAL) || (seconds <= 0.0) )
+    {//Too short to be measured
+        return;
+    }
+
+    const double speed = static_cast<double>(instructionCount) / seconds;
+    this->g_speed = (this->g_speed == 0.0) ? speed : (this->g_speed*0.75 + speed*0.25);
+
+    const double interval = this->g_speed * std::chrono::duration<double>(this->g_latencyTarget).count();
+    this->g_interval = static_cast<uint64_t>( std::clamp(interval, static_cast<double>(CG_TIMETRAVEL_MIN_INTERVAL),
+                                                                   static_cast<double>(CG_TIMETRAVEL_MAX_INTERVAL)) );
+}
+
+}//end codeg
@@ -20,14 +20,30 @@
 #include <string>
 #include <limits>
 #include <filesystem>
+#include <functional>
+#include <algorithm>
+#include <sstream>
+#include <chrono>
+#include <iomanip>
+#include <iterator>
 
 #include "C_console.hpp"
 #include "C_error.hpp"
 #include "C_string.hpp"
+#include "C_snapshot.hpp"
+#include "C_inputLog.hpp"
 #include "memoryModule/C_MM1.hpp"
+#include "memoryModule/C_pagedMM1.hpp"
+#include "memoryModule/C_ROM1.hpp"
 #include "motherboard/C_GCM_5_1.hpp"
 #include "processor/C_ALUminium_1_1.hpp"
 #include "peripheral/C_uart.hpp"
+#include "engine/C_engine.hpp"
+#include "engine/C_timeTravel.hpp"
+#include "engine/C_profiler.hpp"
+#include "engine/C_dataProfiler.hpp"
+#include "engine/C_callGraph.hpp"
+#include "engine/C_boardExecutor.hpp"
 
 #include "CMakeConfig.hpp"
 
@@ -35,6 +51,18 @@
 #include "CLI/Formatter.hpp"
 #include "CLI/Config.hpp"
 
+//Exit codes of the batch mode
+#define CGS_EXIT_SUCCESS 0
+#define CGS_EXIT_BUDGET_EXHAUSTED 2
+#define CGS_EXIT_BREAKPOINT 3
+#define CGS_EXIT_WATCHPOINT 4
+#define CGS_EXIT_UNSYNC_TIMEOUT 5
+#define CGS_EXIT_PERIPHERAL_EVENT 6
+#define CGS_EXIT_SCRIPT_ERROR 7
+
+#define CGS_DEFAULT_MAX_INSTRUCTIONS 100000000
+#define CGS_DEFAULT_HISTORY_MEMORY 128 //MiB
+
 namespace fs = std::filesystem;
 
 void printVersion()
@@ -42,6 +70,190 @@ void printVersion()
     std::cout << "codeGSimulator created by Guillaume Guillet, version " << CGS_VERSION_MAJOR << "." << CGS_VERSION_MINOR << std::endl;
 }
 
+//An exhausted budget is only a failure if a program counter was expected
+int GetExitCode(codeg::StopReason reason, bool programCounterExpected)
+{
+    switch (reason)
+    {
+    case codeg::StopReason::STOP_BUDGET_EXHAUSTED:
+        return programCounterExpected ? CGS_EXIT_BUDGET_EXHAUSTED : CGS_EXIT_SUCCESS;
+    case codeg::StopReason::STOP_BREAKPOINT:
+        return CGS_EXIT_BREAKPOINT;
+    case codeg::StopReason::STOP_WATCHPOINT:
+        return CGS_EXIT_WATCHPOINT;
+    case codeg::StopReason::STOP_PC_REACHED:
+        return CGS_EXIT_SUCCESS;
+    case codeg::StopReason::STOP_UNSYNC_TIMEOUT:
+        return CGS_EXIT_UNSYNC_TIMEOUT;
+    case codeg::StopReason::STOP_PERIPHERAL_EVENT:
+        return CGS_EXIT_PERIPHERAL_EVENT;
+    }
+    return CGS_EXIT_SUCCESS;
+}
+
+//Seconds with the most readable unit, ex: "12.345 ms"
+std::string FormatDuration(double seconds)
+{
+    const char* unit = "s";
+    if (seconds < 1e-6)
+    {
+        seconds *= 1e9;
+        unit = "ns";
+    }
+    else if (seconds < 1e-3)
+    {
+        seconds *= 1e6;
+        unit = "us";
+    }
+    else if (seconds < 1.0)
+    {
+        seconds *= 1e3;
+        unit = "ms";
+    }
+
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(3) << seconds << ' ' << unit;
+    return stream.str();
+}
+
+//Source memory of a program file, mapped in a read-only ROM (up to 16 MiB) or copied in a writable 64k memory
+std::shared_ptr<codeg::MemoryModule> LoadProgram(const fs::path& path, bool map, std::size_t& dataSize)
+{
+    if (map)
+    {
+        auto memory = std::make_shared<codeg::ROM1>(path);
+        dataSize = memory->getMemorySize();
+        return memory;
+    }
+
+    auto memory = std::make_shared<codeg::MM1_64k>();
+
+    std::ifstream fileIn(path, std::ios::binary);
+    std::vector<uint8_t> buffer{std::istreambuf_iterator<char>(fileIn), std::istreambuf_iterator<char>()};
+    if (buffer.size() >= memory->getMemorySize())
+    {
+        throw codeg::Error("the file "+path.string()+" is too big for the 64k source memory, use --rom");
+    }
+
+    dataSize = buffer.size();
+    if ( !buffer.empty() )
+    {
+        memory->set(0, buffer.data(), buffer.size());
+    }
+    return memory;
+}
+
+//Options of the command line shared by every program of --programs
+struct BatchOptions
+{
+    bool _mapProgram{false};
+    std::string _engineType;
+    std::size_t _maxInstructions{CGS_DEFAULT_MAX_INSTRUCTIONS};
+    bool _stopAtProgramCounter{false};
+    codeg::MemoryAddress _programCounter{0};
+    double _boardClock{CG_GCM_5_1_DEFAULT_CLOCK_FREQUENCY};
+    std::string _uartInput;
+};
+
+//Simulate every program on its own board (same hardware as --in) with the BoardExecutor,
+//return the exit code of the first program that is not CGS_EXIT_SUCCESS
+int RunPrograms(const std::vector<fs::path>& paths, const BatchOptions& options)
+{
+    struct ProgramBoard
+    {
+        ProgramBoard(codeg::Console& output, std::size_t index) :
+                _console(output, "board "+std::to_string(index)+": ")
+        {}
+
+        codeg::Console _console;
+        codeg::GCM_5_1_SPS1 _motherboard;
+        std::ofstream _uartOutFile;
+        std::unique_ptr<codeg::ExecutionEngine> _engine;
+    };
+
+    codeg::BoardExecutor executor;
+    std::vector<std::unique_ptr<ProgramBoard> > boards;
+
+    codeg::StopConditions conditions;
+    conditions._stopAtProgramCounter = options._stopAtProgramCounter;
+    conditions._programCounter = options._programCounter;
+
+    for (std::size_t i=0; i<paths.size(); ++i)
+    {
+        auto& board = boards.emplace_back(std::make_unique<ProgramBoard>(*codeg::varConsole, i));
+        codeg::GCM_5_1_SPS1& motherboard = board->_motherboard;
+
+        fs::path uartOutPath = paths[i];
+        uartOutPath += ".uart";
+        board->_uartOutFile.open(uartOutPath, std::ios::binary);
+        if ( !board->_uartOutFile )
+        {
+            throw codeg::Error("can't write the file "+uartOutPath.string());
+        }
+
+        std::size_t dataSize = 0;
+        motherboard.setConsole(&board->_console);
+        motherboard.setClockFrequency(options._boardClock);
+        motherboard.memoryPlug(motherboard.getMemorySourceIndex(), LoadProgram(paths[i], options._mapProgram, dataSize));
+
+        motherboard._processor._alu = std::make_shared<codeg::Aluminium_1_1>();
+        motherboard._processor.memoryPlug(0, std::make_shared<codeg::MM1_16k>());
+        motherboard.memoryPlug(1, std::make_shared<codeg::MM1_16k>());
+
+        auto uartCard = std::make_shared<codeg::UART_peripheral_card_A_1_1>();
+        uartCard->setInputBuffer(options._uartInput);
+        uartCard->setOutputStream(&board->_uartOutFile);
+        motherboard.peripheralPlug(0, uartCard);
+
+        motherboard.updateDataSource();
+
+        board->_engine = codeg::CreateExecutionEngine(options._engineType, motherboard);
+        if (!board->_engine)
+        {
+            throw codeg::Error("unknown execution engine \""+options._engineType+"\"");
+        }
+        executor.addJob(*board->_engine, options._maxInstructions, conditions);
+
+        ConsoleInfo << "board " << i << ": " << paths[i] << " (" << dataSize << " bytes)" << std::endl;
+    }
+
+    ConsoleInfo << "running " << paths.size() << " programs with the \"" << options._engineType << "\" execution engine on "
+                << std::min(executor.getThreadCount(), paths.size()) << " threads ..." << std::endl;
+
+    const auto startTime = std::chrono::steady_clock::now();
+    executor.run();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    int exitCode = CGS_EXIT_SUCCESS;
+    uint64_t executedInstructions = 0;
+    for (std::size_t i=0; i<boards.size(); ++i)
+    {
+        const codeg::RunResult& result = executor.getJob(i)._result;
+        const codeg::GCM_5_1_SPS1& motherboard = boards[i]->_motherboard;
+        const int programExitCode = GetExitCode(result._reason, options._stopAtProgramCounter);
+
+        ConsoleInfo << "board " << i << ": stopped after " << result._instructionCount << " instructions : "
+                    << codeg::StopReasonToString(result._reason) << ", pc: " << codeg::ValueToHex(motherboard.getProgramCounter(), 8, true)
+                    << ", simulated time: " << FormatDuration(motherboard.getSimulatedTime())
+                    << ", exit code: " << programExitCode << std::endl;
+
+        if (exitCode == CGS_EXIT_SUCCESS)
+        {
+            exitCode = programExitCode;
+        }
+        //The speed only count what was really executed, the loop detector skip instructions without executing them
+        executedInstructions += result._instructionCount - result._skippedInstructionCount;
+    }
+
+    if (seconds > 0.0)
+    {//Every board run a different program, the instructions of all the boards are done in the same host time
+        ConsoleInfo << "total host: " << FormatDuration(seconds) << ", " << static_cast<uint64_t>(static_cast<double>(executedInstructions) / seconds)
+                    << " instructions/s for the " << boards.size() << " programs" << std::endl;
+    }
+    ConsoleInfo << "exit code: " << exitCode << std::endl;
+    return exitCode;
+}
+
 int main(int argc, char **argv)
 {
     if ( int err = codeg::ConsoleInit() )
@@ -50,11 +262,31 @@ int main(int argc, char **argv)
     }
 
     codeg::RegisterNewMemoryModuleType(std::make_unique<codeg::MemoryModuleClassType<codeg::MM1> >());
+    codeg::RegisterNewMemoryModuleType(std::make_unique<codeg::MemoryModuleClassType<codeg::PagedMM1> >());
+    codeg::RegisterNewMemoryModuleType(std::make_unique<codeg::MemoryModuleClassType<codeg::ROM1> >());
+    codeg::RegisterNewMemoryModuleType(std::make_unique<codeg::MemoryModuleClassType<codeg::SparseMM1> >());
     codeg::RegisterNewMotherboardType(std::make_unique<codeg::MotherboardClassType<codeg::GCM_5_1_SPS1> >());
 
     fs::path fileInPath;
+    fs::path snapshotInPath;
     fs::path fileLogOutPath;
     bool writeLogFile = true;
+    bool mapProgram = false;
+    std::string engineType = "threaded";
+
+    std::string runUntil;
+    std::size_t batchMaxInstructions = CGS_DEFAULT_MAX_INSTRUCTIONS;
+    fs::path uartInPath;
+    fs::path uartOutPath;
+    fs::path scriptPath;
+    std::size_t historyMemory = CGS_DEFAULT_HISTORY_MEMORY;
+    fs::path recordPath;
+    fs::path replayPath;
+    fs::path profilePath;
+    fs::path dataProfilePath;
+    fs::path callGraphPath;
+    double boardClock = CG_GCM_5_1_DEFAULT_CLOCK_FREQUENCY;
+    std::vector<fs::path> programPaths;
 
     CLI::App app{"A simulator specifically built for the homemade language codeG", "codeGSimulator"};
 
@@ -65,8 +297,29 @@ int main(int argc, char **argv)
 
     app.add_flag("!--noLog", writeLogFile, "Don't write a log file (default a log file is written)");
 
-    app.add_option("--in", fileInPath, "Set the input file to be read and simulated")->required(true);
+    app.add_option("--in", fileInPath, "Set the input file to be read and simulated");
+    app.add_flag("--rom", mapProgram, "Map the input file in a read-only ROM (up to 16 MiB) instead of copying it in a writable 64k memory, "
+                                      "writes to the source slot are ignored and the file must not be truncated while running");
+    app.add_option("--from-snapshot", snapshotInPath, "Restore the machine state from a snapshot file (after loading the input file if any)");
     app.add_option("--outLog", fileLogOutPath, "Set the output log file (default is the input path+.log)");
+    app.add_option("--engine", engineType, "Set the execution engine : clock, cached, threaded, static, block (predecoded basic blocks) "
+                                           "or native (x86-64 code generated for the basic blocks, block on other targets) (default is threaded)");
+
+    app.add_option("--run-until", runUntil, "Batch mode, execute until the program counter reach this address (exit code 0) or a stop condition");
+    CLI::Option* maxInstructionsOption = app.add_option("--max-instructions", batchMaxInstructions, "Batch mode, maximum number of instructions to execute (default is 100000000)");
+    app.add_option("--board-clock", boardClock, "Board clock frequency in Hz, used to convert the processor clock phases into simulated time (default is 1000000)");
+    app.add_option("--uart-in", uartInPath, "Set a file used as the UART input (default is \"test_hello\\n\")");
+    app.add_option("--uart-out", uartOutPath, "Set a file that receive every byte transmitted by the UART");
+    app.add_option("--script", scriptPath, "Batch mode, execute the console commands of this file (one per line, # for comments)");
+    app.add_option("--history-memory", historyMemory, "Memory budget in MiB of the checkpoints used by reverse execution, 0 to disable (default is 128)");
+    app.add_option("--record", recordPath, "Record every external input (UART input, memory plug/unplug, reset, restore) in this file");
+    app.add_option("--replay", replayPath, "Batch mode, replay the inputs recorded in this file (until the end of the recorded run by default)");
+    app.add_option("--profile", profilePath, "Profile every executed instruction, the counters are saved in this CSV file and a report is printed at the end");
+    app.add_option("--call-graph", callGraphPath, "Follow the calls and returns, the collapsed stacks (for flame graph tools) are saved in this file and a report is printed at the end");
+    app.add_option("--data-profile", dataProfilePath, "Profile every RAM and external memory access, the counters are saved in this CSV file and a report is printed at the end");
+    app.add_option("--programs", programPaths, "Batch mode, simulate every program file on its own board at the same time on every core (same hardware and options as --in), "
+                                               "each program has its own exit code and write its UART output in its path+.uart, the exit code is the first one that is not 0 "
+                                               "(can't be used with --in, --from-snapshot, --script, --uart-out, --profile, --data-profile, --call-graph, --record and --replay)");
 
     try
     {
@@ -77,24 +330,82 @@ int main(int argc, char **argv)
         return app.exit(e);
     }
 
-    if ( fileInPath.empty() )
+    uint64_t runUntilAddress = 0;
+    if ( !runUntil.empty() &&
+         (!codeg::StringToValue(runUntil, runUntilAddress) || (runUntilAddress > codeg::BusSPS1Masks[codeg::BUS_SPS1_BJMPSRC])) )
+    {
+        return app.exit(CLI::ValidationError("--run-until", "\""+runUntil+"\" is not a 24 bits address (decimal or 0x hexadecimal)"));
+    }
+    if ( !programPaths.empty() &&
+         (!fileInPath.empty() || !snapshotInPath.empty() || !scriptPath.empty() || !uartOutPath.empty() || !profilePath.empty() ||
+          !dataProfilePath.empty() || !callGraphPath.empty() || !recordPath.empty() || !replayPath.empty()) )
+    {
+        return app.exit(CLI::ValidationError("--programs", "can't be used with --in, --from-snapshot, --script, --uart-out, --profile, "
+                                                           "--data-profile, --call-graph, --record and --replay"));
+    }
+
+    if ( fileInPath.empty() && snapshotInPath.empty() && programPaths.empty() )
     {
         std::cout << "No input file !" << std::endl;
         return -1;
     }
     if (fileLogOutPath.empty() && writeLogFile )
     {
-        fileLogOutPath = fileInPath;
+        fileLogOutPath = !fileInPath.empty() ? fileInPath : (!snapshotInPath.empty() ? snapshotInPath : programPaths.front());
         fileLogOutPath += ".log";
     }
 
+    //Batch mode when there is something to do without the user
+    const bool batchMode = !runUntil.empty() || (maxInstructionsOption->count() > 0) || !scriptPath.empty() || !replayPath.empty();
+
     ///Opening files
-    std::ifstream fileIn(fileInPath, std::ios::binary);
-    if ( !fileIn )
+    if ( !fileInPath.empty() && !std::ifstream(fileInPath, std::ios::binary) )
     {
         std::cout << "Can't read the file " << fileInPath << std::endl;
         return -1;
     }
+    for (const fs::path& programPath : programPaths)
+    {
+        if ( !std::ifstream(programPath, std::ios::binary) )
+        {
+            std::cout << "Can't read the file " << programPath << std::endl;
+            return -1;
+        }
+    }
+
+    std::string uartInput = "test_hello\n";
+    if ( !uartInPath.empty() )
+    {
+        std::ifstream uartInFile(uartInPath, std::ios::binary);
+        if ( !uartInFile )
+        {
+            std::cout << "Can't read the file " << uartInPath << std::endl;
+            return -1;
+        }
+        uartInput.assign(std::istreambuf_iterator<char>(uartInFile), std::istreambuf_iterator<char>());
+    }
+
+    std::ofstream uartOutFile;
+    if ( !uartOutPath.empty() )
+    {
+        uartOutFile.open(uartOutPath, std::ios::binary);
+        if ( !uartOutFile )
+        {
+            std::cout << "Can't write the file " << uartOutPath << std::endl;
+            return -1;
+        }
+    }
+
+    std::ifstream scriptFile;
+    if ( !scriptPath.empty() )
+    {
+        scriptFile.open(scriptPath);
+        if ( !scriptFile )
+        {
+            std::cout << "Can't read the file " << scriptPath << std::endl;
+            return -1;
+        }
+    }
 
     codeg::varConsole = new codeg::Console();
     if (writeLogFile)
@@ -102,15 +413,49 @@ int main(int argc, char **argv)
         if ( !codeg::varConsole->logOpen(fileLogOutPath) )
         {
             std::cout << "Can't write the file " << fileLogOutPath << std::endl;
+            delete codeg::varConsole;
             return -1;
         }
     }
 
     std::cout << std::endl;
 
+    if ( !programPaths.empty() )
+    {
+        int programsExitCode = CGS_EXIT_SUCCESS;
+        try
+        {
+            BatchOptions options;
+            options._mapProgram = mapProgram;
+            options._engineType = engineType;
+            options._maxInstructions = batchMaxInstructions;
+            options._stopAtProgramCounter = !runUntil.empty();
+            options._programCounter = static_cast<codeg::MemoryAddress>(runUntilAddress);
+            options._boardClock = boardClock;
+            options._uartInput = uartInput;
+
+            programsExitCode = RunPrograms(programPaths, options);
+        }
+        catch (const codeg::Error& e)
+        {
+            ConsoleError << "error : " <<  e.what() << std::endl;
+            programsExitCode = -1;
+        }
+        catch (const std::exception& e)
+        {
+            ConsoleFatal << "unknown exception : " << e.what() << std::endl;
+            programsExitCode = -1;
+        }
+
+        codeg::varConsole->logClose();
+        delete codeg::varConsole;
+        return programsExitCode;
+    }
+
     std::string stringLine;
 
     bool running = true;
+    int exitCode = CGS_EXIT_SUCCESS;
 
     struct Command
     {
@@ -124,29 +469,49 @@ int main(int argc, char **argv)
 
     std::vector<std::shared_ptr<codeg::MemoryModule> > unpluggedMemories;
 
+    //Instructions executed since the start, used to stamp the recorded inputs
+    uint64_t cycle = 0;
+    const bool recording = !recordPath.empty();
+    codeg::InputLog recordLog;
+    auto saveRecord = [&](){
+        if (recording)
+        {
+            recordLog.setEndCycle(cycle);
+            if ( !recordLog.saveToFile(recordPath) )
+            {
+                ConsoleError << "Can't write the file " << recordPath << std::endl;
+            }
+        }
+    };
+
     try
     {
-        ConsoleInfo << "Reading the file ..." << std::endl;
-
-        fileIn.seekg(0, std::ifstream::end);
-        auto fileSize = static_cast<std::streamsize>(fileIn.tellg());
-        fileIn.seekg(0, std::ifstream::beg);
-
-        std::unique_ptr<uint8_t[]> buffer{new uint8_t[fileSize]};
-        if ( !fileIn.read(reinterpret_cast<char*>(buffer.get()), fileSize) )
+        codeg::InputLog replayLog;
+        std::size_t replayIndex = 0;
+        if ( !replayPath.empty() )
         {
-            ConsoleFatal << "Can't read data from the file " << fileInPath << std::endl;
-            return -1;
+            replayLog.loadFromFile(replayPath);
+            ConsoleInfo << "Replaying " << replayLog.getEvents().size() << " inputs recorded over "
+                        << replayLog.getEndCycle() << " instructions" << std::endl;
         }
 
-        ConsoleInfo << "Data size : " << fileSize << " bytes" << std::endl;
-
-        ConsoleInfo << "Creating memory module size for the source ..." << std::endl;
-        std::shared_ptr<codeg::MemoryModule> memory = std::make_shared<codeg::MM1_64k>();
-        memory->set(0, buffer.get(), fileSize);
+        std::shared_ptr<codeg::MemoryModule> memory;
+        if ( !fileInPath.empty() )
+        {
+            ConsoleInfo << (mapProgram ? "Mapping the file in a ROM for the source ..." : "Reading the file ...") << std::endl;
+            std::size_t dataSize = 0;
+            memory = LoadProgram(fileInPath, mapProgram, dataSize);
+            ConsoleInfo << "Data size : " << dataSize << " bytes" << std::endl;
+        }
+        else
+        {
+            ConsoleInfo << "Creating memory module size for the source ..." << std::endl;
+            memory = std::make_shared<codeg::MM1_64k>();
+        }
 
         ConsoleInfo << "Creating the motherboard and plug the memory module ..." << std::endl;
         codeg::GCM_5_1_SPS1 motherboard;
+        motherboard.setClockFrequency(boardClock);
         motherboard.memoryPlug(motherboard.getMemorySourceIndex(), memory);
 
         motherboard._processor._alu = std::make_shared<codeg::Aluminium_1_1>();
@@ -154,11 +519,303 @@ int main(int argc, char **argv)
         motherboard.memoryPlug(1, std::make_shared<codeg::MM1_16k>());
 
         std::shared_ptr<codeg::UART_peripheral_card_A_1_1> uartCard = std::make_shared<codeg::UART_peripheral_card_A_1_1>();
-        uartCard->setInputBuffer("test_hello\n");
+        uartCard->setInputBuffer(std::move(uartInput));
+        if ( uartOutFile.is_open() )
+        {
+            uartCard->setOutputStream(&uartOutFile);
+        }
         motherboard.peripheralPlug(0, uartCard);
 
         motherboard.updateDataSource();
 
+        //The initial state is recorded so the replay only need the same program (a replayed log already start with it)
+        const bool recordInitialState = recording && replayPath.empty();
+        if (recordInitialState)
+        {
+            recordLog.add({0, codeg::InputEventType::EVENT_UART_INPUT, 0, uartCard->getInputBuffer()});
+        }
+
+        if ( !snapshotInPath.empty() )
+        {
+            ConsoleInfo << "Restoring the snapshot " << snapshotInPath << " ..." << std::endl;
+            const auto snapshot = codeg::MapSnapshotFile(snapshotInPath);
+            motherboard.loadSnapshotData(snapshot->getData(), snapshot->getSize());
+            if (recordInitialState)
+            {
+                recordLog.add({0, codeg::InputEventType::EVENT_SNAPSHOT, 0,
+                               std::string{reinterpret_cast<const char*>(snapshot->getData()), snapshot->getSize()}});
+            }
+        }
+
+        std::unique_ptr<codeg::ExecutionEngine> engine = codeg::CreateExecutionEngine(engineType, motherboard);
+        if (!engine)
+        {
+            throw codeg::Error("unknown execution engine \""+engineType+"\"");
+        }
+        ConsoleInfo << "Using the \"" << engine->getType() << "\" execution engine" << std::endl;
+
+        codeg::BreakpointSet breakpoints;
+
+        std::unique_ptr<codeg::TimeTravel> timeTravel;
+        if (historyMemory > 0)
+        {
+            timeTravel = std::make_unique<codeg::TimeTravel>(motherboard, *engine, historyMemory*1024*1024);
+        }
+        //Must be called after every change of the machine that is not an execution
+        auto resetHistory = [&](){
+            if (timeTravel)
+            {
+                timeTravel->reset();
+            }
+        };
+        //Executing again the history must not write again into the UART output file
+        auto withoutUartOutput = [&](auto function){
+            uartCard->setOutputStream(nullptr);
+            auto result = function();
+            if ( uartOutFile.is_open() )
+            {
+                uartCard->setOutputStream(&uartOutFile);
+            }
+            return result;
+        };
+
+        //External inputs that are not console commands, they are recorded and clear the history
+        auto setUartInput = [&](std::size_t slot, const std::string& input){
+            const codeg::PeripheralSlot* peripheralSlot = motherboard.getPeripheralSlot(slot);
+            auto uart = std::dynamic_pointer_cast<codeg::UART_peripheral_card_A_1_1>(peripheralSlot ? peripheralSlot->_peripheral : nullptr);
+            if (!uart)
+            {
+                throw codeg::Error("no UART in the peripheral slot "+std::to_string(slot));
+            }
+            uart->setInputBuffer(input);
+            resetHistory();
+            if (recording)
+            {
+                recordLog.add({cycle, codeg::InputEventType::EVENT_UART_INPUT, slot, input});
+            }
+        };
+        auto restoreSnapshot = [&](const uint8_t* snapshot, std::size_t size){
+            try
+            {
+                motherboard.loadSnapshotData(snapshot, size);
+            }
+            catch (const codeg::Error&)
+            {//A failed restore can leave a partially restored machine
+                resetHistory();
+                throw;
+            }
+            resetHistory();
+            if (recording)
+            {
+                recordLog.add({cycle, codeg::InputEventType::EVENT_SNAPSHOT, 0, std::string{reinterpret_cast<const char*>(snapshot), size}});
+            }
+        };
+
+        //Console commands that change the machine, they are recorded as inputs and clear the history
+        //(the history can't undo them, so a rewind can never go before a recorded input)
+        const std::vector<std::string> inputCommands = {"reset", "unplug_mem", "plug_mem", "new_mem", "erase_mem"};
+        std::function<bool(std::string)> executeCommand;
+
+        //Apply the replayed inputs of the current cycle
+        auto replayInputs = [&](){
+            const std::vector<codeg::InputEvent>& events = replayLog.getEvents();
+            while ( (replayIndex < events.size()) && (events[replayIndex]._cycle <= cycle) )
+            {
+                const codeg::InputEvent& event = events[replayIndex++];
+                switch (event._type)
+                {
+                case codeg::InputEventType::EVENT_COMMAND:
+                    if ( !executeCommand(event._data) )
+                    {
+                        throw codeg::Error("replay: the command \""+event._data+"\" failed");
+                    }
+                    break;
+                case codeg::InputEventType::EVENT_UART_INPUT:
+                    setUartInput(static_cast<std::size_t>(event._target), event._data);
+                    break;
+                case codeg::InputEventType::EVENT_SNAPSHOT:
+                    restoreSnapshot(reinterpret_cast<const uint8_t*>(event._data.data()), event._data.size());
+                    break;
+                case codeg::InputEventType::EVENT_END:
+                    break;
+                }
+            }
+        };
+
+        //Guest execution profiler, only used by the runs (not by the reverse execution)
+        codeg::ExecutionProfiler profiler;
+        bool profiling = !profilePath.empty();
+        auto printLines = [](std::stringstream& stream){
+            std::string line;
+            while ( std::getline(stream, line) )
+            {
+                ConsoleInfo << line << std::endl;
+            }
+        };
+        auto printProfileReport = [&](std::size_t top){
+            std::stringstream report;
+            profiler.writeReport(report, motherboard, top);
+            printLines(report);
+        };
+
+        //Data access profiler, same as the guest execution profiler
+        codeg::DataAccessProfiler dataProfiler;
+        bool dataProfiling = !dataProfilePath.empty();
+        auto printDataProfileReport = [&](std::size_t top){
+            std::stringstream report;
+            dataProfiler.writeReport(report, motherboard._processor, motherboard, top);
+            printLines(report);
+        };
+
+        //Call graph profiler, same as the guest execution profiler
+        codeg::CallGraphProfiler callGraph;
+        bool callGraphProfiling = !callGraphPath.empty();
+        auto printCallGraphReport = [&](std::size_t top){
+            std::stringstream report;
+            callGraph.writeReport(report, top);
+            printLines(report);
+        };
+
+        //Host time spent in the runs, to compare the simulator speed with the real board
+        struct HostTiming
+        {
+            uint64_t _instructions{0};
+            uint64_t _phases{0};
+            uint64_t _skippedInstructions{0};
+            uint64_t _skippedPhases{0};
+            std::chrono::steady_clock::duration _duration{0};
+
+            HostTiming& operator+=(const HostTiming& r)
+            {
+                this->_instructions += r._instructions;
+                this->_phases += r._phases;
+                this->_skippedInstructions += r._skippedInstructions;
+                this->_skippedPhases += r._skippedPhases;
+                this->_duration += r._duration;
+                return *this;
+            }
+        };
+        HostTiming totalTiming;
+        HostTiming lastRunTiming;
+        auto printHostSpeed = [&](const char* label, const HostTiming& timing){
+            const double seconds = std::chrono::duration<double>(timing._duration).count();
+            if ( (timing._instructions == 0) || !(seconds > 0.0) )
+            {
+                return;
+            }
+            //The speed only count what was really executed, the loop detector skip instructions without executing them
+            const double executedInstructions = static_cast<double>(timing._instructions - timing._skippedInstructions);
+            const double frequency = static_cast<double>(timing._phases - timing._skippedPhases) / seconds;
+            ConsoleInfo << label << ": " << FormatDuration(seconds) << ", " << static_cast<uint64_t>(executedInstructions / seconds)
+                        << " instructions/s, " << frequency/1e6 << " MHz effective ("
+                        << frequency / motherboard.getClockFrequency() << "x real time)" << std::endl;
+            if (timing._skippedInstructions != 0)
+            {
+                const double simulatedFrequency = static_cast<double>(timing._phases) / seconds;
+                ConsoleInfo << label << ": " << timing._skippedInstructions << " instructions fast-forwarded, "
+                            << simulatedFrequency / motherboard.getClockFrequency() << "x real time with them" << std::endl;
+            }
+        };
+        auto printTiming = [&](){
+            ConsoleInfo << "simulated time: " << FormatDuration(motherboard.getSimulatedTime()) << " ("
+                        << motherboard._processor.getPhaseCount() << " clock phases at " << motherboard.getClockFrequency()/1e6 << " MHz)" << std::endl;
+            printHostSpeed("total host", totalTiming);
+        };
+
+        //Every run is done here, the stop reason of the last one give the exit code of the batch mode
+        bool programCounterExpected = false;
+        auto runEngine = [&](std::size_t max, const codeg::StopConditions& runConditions){
+            const auto startTime = std::chrono::steady_clock::now();
+            const uint64_t startPhases = motherboard._processor.getPhaseCount();
+
+            codeg::StopConditions conditions = runConditions;
+            conditions._profiler = profiling ? &profiler : nullptr;
+            conditions._dataProfiler = dataProfiling ? &dataProfiler : nullptr;
+            conditions._callGraph = callGraphProfiling ? &callGraph : nullptr;
+
+            codeg::RunResult result;
+            const bool newConditionHit = (conditions._breakpoints != nullptr) &&
+                                         conditions._breakpoints->checkNewConditions(motherboard.getProgramCounter(), motherboard._processor);
+            if (newConditionHit)
+            {//Already true when added
+                result._reason = codeg::StopReason::STOP_BREAKPOINT;
+            }
+            while (!newConditionHit)
+            {//Stop at every replayed input
+                replayInputs();
+
+                std::size_t budget = max - result._instructionCount;
+                if ( replayIndex < replayLog.getEvents().size() )
+                {
+                    budget = static_cast<std::size_t>( std::min<uint64_t>(budget, replayLog.getEvents()[replayIndex]._cycle - cycle) );
+                }
+
+                const codeg::RunResult partResult = timeTravel ? timeTravel->run(budget, conditions) : engine->run(budget, conditions);
+                cycle += partResult._instructionCount;
+                result._instructionCount += partResult._instructionCount;
+                result._skippedInstructionCount += partResult._skippedInstructionCount;
+                result._skippedPhaseCount += partResult._skippedPhaseCount;
+                result._reason = partResult._reason;
+
+                if ( (partResult._reason != codeg::StopReason::STOP_BUDGET_EXHAUSTED) || (partResult._instructionCount == 0) ||
+                     (result._instructionCount >= max) )
+                {
+                    break;
+                }
+            }
+            replayInputs();
+
+            lastRunTiming._instructions = result._instructionCount;
+            lastRunTiming._phases = motherboard._processor.getPhaseCount() - startPhases;
+            lastRunTiming._skippedInstructions = result._skippedInstructionCount;
+            lastRunTiming._skippedPhases = result._skippedPhaseCount;
+            lastRunTiming._duration = std::chrono::steady_clock::now() - startTime;
+            totalTiming += lastRunTiming;
+
+            programCounterExpected = conditions._stopAtProgramCounter;
+            exitCode = GetExitCode(result._reason, programCounterExpected);
+            return result;
+        };
+        //Move in the history and keep the cycle, the UART output file is not written again
+        auto travel = [&](auto function){
+            const uint64_t historyCycle = timeTravel->getCycle();
+            auto result = withoutUartOutput(function);
+            cycle = cycle - historyCycle + timeTravel->getCycle();
+            lastRunTiming = HostTiming{}; //Not a forward run
+            return result;
+        };
+
+        auto printRunResult = [&](const codeg::RunResult& result){
+            if (result._reason == codeg::StopReason::STOP_WATCHPOINT)
+            {
+                const codeg::WatchpointHit& hit = breakpoints.getLastHit();
+                ConsoleInfo << "watchpoint " << hit._index << " hit : "
+                            << ((hit._access & codeg::WatchpointAccess::WATCH_WRITE) ? "write" : "read")
+                            << " at " << codeg::ValueToHex(hit._address, 4, true) << std::endl;
+            }
+            else if (result._reason == codeg::StopReason::STOP_BREAKPOINT)
+            {
+                const std::size_t index = breakpoints.getLastCondition();
+                if (index == CG_BREAKPOINT_NO_CONDITION)
+                {
+                    ConsoleInfo << "breakpoint hit" << std::endl;
+                }
+                else
+                {
+                    ConsoleInfo << "condition " << index << " hit : " << breakpoints.getConditions()[index].getExpression() << std::endl;
+                }
+            }
+            ConsoleInfo << "stopped after " << result._instructionCount << " instructions : "
+                        << codeg::StopReasonToString(result._reason) << std::endl;
+            ConsoleInfo << "pc: "<< motherboard.getProgramCounter()
+                        <<" ("<< codeg::ValueToHex(motherboard.getProgramCounter(), 8, true) <<")"
+                        << std::endl;
+            ConsoleInfo << "cycle: " << cycle << std::endl;
+            ConsoleInfo << "simulated time: " << FormatDuration(motherboard.getSimulatedTime()) << " ("
+                        << motherboard._processor.getPhaseCount() << " clock phases)" << std::endl;
+            printHostSpeed("host", lastRunTiming);
+        };
+
         ConsoleInfo << "ok !" << std::endl;
 
         std::vector<Command> commands = {
@@ -172,6 +829,39 @@ int main(int argc, char **argv)
                             << codeg::ValueToHex(motherboard.getProgramCounter(), 8, true) << ")" << std::endl;
                 return true;
             }},
+            {"snapshot", "snapshot [file]", "save the complete machine state in a file", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if ( !motherboard.saveSnapshot(args[0]) )
+                {
+                    ConsoleError << "can't write the file " << args[0] << std::endl;
+                    return false;
+                }
+                ConsoleInfo << "snapshot saved in " << args[0] << std::endl;
+                return true;
+            }},
+            {"restore", "restore [file]", "restore the machine state from a snapshot file", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                try
+                {
+                    const auto snapshot = codeg::MapSnapshotFile(args[0]);
+                    restoreSnapshot(snapshot->getData(), snapshot->getSize());
+                }
+                catch (const codeg::Error& e)
+                {
+                    ConsoleError << e.what() << std::endl;
+                    return false;
+                }
+                ConsoleInfo << "pc: "<< motherboard.getProgramCounter() <<" ("
+                            << codeg::ValueToHex(motherboard.getProgramCounter(), 8, true) << ")" << std::endl;
+                return true;
+            }},
+            {"uart_input", "uart_input [text...]", "add a line to the input buffer of the uart card", 1,64, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                std::string input = uartCard->getInputBuffer();
+                for (std::size_t i=0; i<args.size(); ++i)
+                {
+                    input += (i == 0) ? args[i] : ' '+args[i];
+                }
+                setUartInput(0, input+'\n');
+                return true;
+            }},
             {"flushUart", "flushUart", "clear the output buffer of the uart card and print the result", 0,0, [&]([[maybe_unused]] const std::vector<std::string>& args){
                 if (uartCard->getOutputBuffer().empty())
                 {
@@ -465,69 +1155,472 @@ int main(int argc, char **argv)
                 }
                 return true;
             }},
-            {"execute", "execute [cycle]", "execute a number of clock cycle (clock until sync)", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
-                std::size_t clockCycle = std::strtoul(args[0].c_str(), nullptr, 0);
+            {"execute", "execute [instructions]", "execute a number of instructions (clock until sync)", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                std::size_t instructionCount = std::strtoull(args[0].c_str(), nullptr, 0);
 
-                for (std::size_t i=0; i<clockCycle; ++i)
-                {
-                    if ( !motherboard._processor.clockUntilSync(20) )
-                    {
-                        ConsoleWarning << "max iteration reached !" << std::endl;
-                        break;
-                    }
-                }
-                ConsoleInfo << "pc: "<< motherboard.getProgramCounter()
-                            <<" ("<< codeg::ValueToHex(motherboard.getProgramCounter(), 8, true) <<")"
-                            << std::endl;
+                codeg::StopConditions conditions;
+                conditions._breakpoints = &breakpoints;
+
+                printRunResult( runEngine(instructionCount, conditions) );
                 return true;
             }},
-            {"goto", "goto [address]", "execute a number of clock cycle (clock until sync) until the address is reached (or max iterations)", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
-                codeg::MemoryAddress memoryAddress = std::strtoul(args[0].c_str(), nullptr, 0);
-                bool reached = false;
+            {"goto", "goto [address] ([max instructions])", "execute instructions until the address is reached (or max instructions, default is 100000000)", 1,2, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                codeg::StopConditions conditions;
+                conditions._stopAtProgramCounter = true;
+                conditions._programCounter = std::strtoul(args[0].c_str(), nullptr, 0);
+                conditions._breakpoints = &breakpoints;
 
-                for (std::size_t i=0; i<5000; ++i)
+                std::size_t maxInstructions = CGS_DEFAULT_MAX_INSTRUCTIONS;
+                if (args.size() == 2)
                 {
-                    if (motherboard.getProgramCounter() == memoryAddress)
-                    {
-                        ConsoleInfo << "memory reached !" << std::endl;
-                        reached = true;
-                        break;
-                    }
+                    maxInstructions = std::strtoull(args[1].c_str(), nullptr, 0);
+                }
 
-                    if ( !motherboard._processor.clockUntilSync(20) )
-                    {
-                        ConsoleWarning << "clock cycle: max iteration reached !" << std::endl;
-                        break;
-                    }
+                const codeg::RunResult result = runEngine(maxInstructions, conditions);
+                if (result._reason == codeg::StopReason::STOP_PC_REACHED)
+                {
+                    ConsoleInfo << "memory reached after " << result._instructionCount << " instructions !" << std::endl;
                 }
-                if (!reached)
+                else
                 {
-                    ConsoleError << "max iteration reached !" << std::endl;
-                    ConsoleInfo << "pc: "<< motherboard.getProgramCounter()
-                                <<" ("<< codeg::ValueToHex(motherboard.getProgramCounter(), 8, true) <<")"
-                                << std::endl;
+                    printRunResult(result);
                 }
                 return true;
-            }}
-        };
+            }},
+            {"wait_event", "wait_event ([max instructions])", "execute instructions until a peripheral change its state (or max instructions, default is 100000000)", 0,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                codeg::StopConditions conditions;
+                conditions._stopOnPeripheralEvent = true;
+                conditions._breakpoints = &breakpoints;
 
-        ConsoleInfo << "Waiting user input" << std::endl;
+                std::size_t maxInstructions = CGS_DEFAULT_MAX_INSTRUCTIONS;
+                if (args.size() == 1)
+                {
+                    maxInstructions = std::strtoull(args[0].c_str(), nullptr, 0);
+                }
 
-        std::string commandLine;
-        std::string commandName;
-        std::vector<std::string> commandArgs;
-        do
-        {
-            std::cout << ">";
-            std::getline(std::cin, commandLine);
+                printRunResult( runEngine(maxInstructions, conditions) );
+                return true;
+            }},
+            {"continue", "continue ([max instructions])", "execute instructions until a breakpoint/watchpoint (or max instructions, default is 100000000)", 0,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                codeg::StopConditions conditions;
+                conditions._breakpoints = &breakpoints;
+
+                std::size_t maxInstructions = CGS_DEFAULT_MAX_INSTRUCTIONS;
+                if (args.size() == 1)
+                {
+                    maxInstructions = std::strtoull(args[0].c_str(), nullptr, 0);
+                }
+
+                printRunResult( runEngine(maxInstructions, conditions) );
+                return true;
+            }},
+            {"break", "break [address]", "add a breakpoint at the program counter address", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                codeg::MemoryAddress address = std::strtoul(args[0].c_str(), nullptr, 0);
+
+                if ( !breakpoints.addBreakpoint(address) )
+                {
+                    ConsoleError << "can't add a breakpoint at " << codeg::ValueToHex(address, 6, true) << " (already set or out of range)" << std::endl;
+                    return false;
+                }
+                ConsoleInfo << "breakpoint added at " << codeg::ValueToHex(address, 6, true) << std::endl;
+                return true;
+            }},
+            {"delete", "delete [address]", "remove the breakpoint at the program counter address", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                codeg::MemoryAddress address = std::strtoul(args[0].c_str(), nullptr, 0);
+
+                if ( !breakpoints.removeBreakpoint(address) )
+                {
+                    ConsoleError << "no breakpoint at " << codeg::ValueToHex(address, 6, true) << std::endl;
+                    return false;
+                }
+                ConsoleInfo << "breakpoint removed at " << codeg::ValueToHex(address, 6, true) << std::endl;
+                return true;
+            }},
+            {"condition", "condition [expression]", "add a conditional breakpoint (ex: PC == 0x40 && BREAD2 & 0x02 && RAM[0x0001] > 3)", 1,64, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                std::string expression = args[0];
+                for (std::size_t i=1; i<args.size(); ++i)
+                {
+                    expression += ' ' + args[i];
+                }
+
+                try
+                {
+                    const std::size_t index = breakpoints.addCondition(expression);
+                    const codeg::Condition& condition = breakpoints.getConditions()[index];
+
+                    std::string trigger = "after every instruction";
+                    if (condition.getTrigger() == codeg::ConditionTrigger::TRIGGER_PROGRAM_COUNTER)
+                    {
+                        trigger = "before the instruction at " + codeg::ValueToHex(condition.getTriggerValue(), 6, true);
+                    }
+                    else if (condition.getTrigger() == codeg::ConditionTrigger::TRIGGER_OPCODE)
+                    {
+                        trigger = "after the opcode " + codeg::ValueToHex(condition.getTriggerValue(), 2, true);
+                    }
+                    ConsoleInfo << "condition added at index " << index << ", checked " << trigger << std::endl;
+                }
+                catch (const codeg::Error& e)
+                {
+                    ConsoleError << e.what() << std::endl;
+                    return false;
+                }
+                return true;
+            }},
+            {"uncondition", "uncondition [index]", "remove a conditional breakpoint", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                std::size_t index = std::strtoul(args[0].c_str(), nullptr, 0);
+
+                if ( !breakpoints.removeCondition(index) )
+                {
+                    ConsoleError << "condition " << index << " doesn't exist" << std::endl;
+                    return false;
+                }
+                ConsoleInfo << "condition " << index << " removed" << std::endl;
+                return true;
+            }},
+            {"watch", R"(watch ["m"/"p"] [slot] [start address] ([end address]) (["r"/"w"/"rw"]))", "add a read/write watchpoint on a motherboard/processor memory slot", 3,5, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                codeg::Watchpoint watchpoint;
+
+                if (args[0] == "m")
+                {
+                    watchpoint._target = codeg::WatchpointTarget::TARGET_MOTHERBOARD_SLOT;
+                }
+                else if (args[0] == "p")
+                {
+                    watchpoint._target = codeg::WatchpointTarget::TARGET_PROCESSOR_SLOT;
+                }
+                else
+                {
+                    ConsoleError << R"(please put "m" (motherboard) or "p" (processor))" << std::endl;
+                    return false;
+                }
+
+                watchpoint._slot = std::strtoul(args[1].c_str(), nullptr, 0);
+                watchpoint._startAddress = std::strtoul(args[2].c_str(), nullptr, 0);
+                watchpoint._endAddress = watchpoint._startAddress;
+                if (args.size() >= 4)
+                {
+                    watchpoint._endAddress = std::strtoul(args[3].c_str(), nullptr, 0);
+                }
+                if (args.size() == 5)
+                {
+                    if (args[4] == "r")
+                    {
+                        watchpoint._access = codeg::WatchpointAccess::WATCH_READ;
+                    }
+                    else if (args[4] == "w")
+                    {
+                        watchpoint._access = codeg::WatchpointAccess::WATCH_WRITE;
+                    }
+                    else if (args[4] != "rw")
+                    {
+                        ConsoleError << R"(please put "r", "w" or "rw")" << std::endl;
+                        return false;
+                    }
+                }
+
+                ConsoleInfo << "watchpoint added at index " << breakpoints.addWatchpoint(watchpoint) << std::endl;
+                return true;
+            }},
+            {"unwatch", "unwatch [index]", "remove a watchpoint", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                std::size_t index = std::strtoul(args[0].c_str(), nullptr, 0);
 
+                if ( !breakpoints.removeWatchpoint(index) )
+                {
+                    ConsoleError << "watchpoint " << index << " doesn't exist" << std::endl;
+                    return false;
+                }
+                ConsoleInfo << "watchpoint " << index << " removed" << std::endl;
+                return true;
+            }},
+            {"breakpoints", "breakpoints", "list the breakpoints, the conditions and the watchpoints", 0,0, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                for (codeg::MemoryAddress address : breakpoints.getBreakpoints())
+                {
+                    ConsoleInfo << "\tbreakpoint " << codeg::ValueToHex(address, 6, true) << std::endl;
+                }
+                const std::vector<codeg::Condition>& breakConditions = breakpoints.getConditions();
+                for (std::size_t i=0; i<breakConditions.size(); ++i)
+                {
+                    ConsoleInfo << "\t[" << i << "] condition " << breakConditions[i].getExpression() << std::endl;
+                }
+                const std::vector<codeg::Watchpoint>& watchpoints = breakpoints.getWatchpoints();
+                for (std::size_t i=0; i<watchpoints.size(); ++i)
+                {
+                    const codeg::Watchpoint& watchpoint = watchpoints[i];
+                    ConsoleInfo << "\t[" << i << "] watchpoint "
+                                << ((watchpoint._target == codeg::WatchpointTarget::TARGET_MOTHERBOARD_SLOT) ? "m" : "p")
+                                << " slot " << watchpoint._slot
+                                << " from " << codeg::ValueToHex(watchpoint._startAddress, 4, true)
+                                << " to " << codeg::ValueToHex(watchpoint._endAddress, 4, true)
+                                << ((watchpoint._access & codeg::WatchpointAccess::WATCH_READ) ? " r" : " ")
+                                << ((watchpoint._access & codeg::WatchpointAccess::WATCH_WRITE) ? "w" : "") << std::endl;
+                }
+                return true;
+            }},
+            {"step_back", "step_back ([instructions])", "go back in the execution history (default is 1 instruction)", 0,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if (!timeTravel)
+                {
+                    ConsoleError << "the execution history is disabled" << std::endl;
+                    return false;
+                }
+                const uint64_t count = args.empty() ? 1 : std::strtoull(args[0].c_str(), nullptr, 0);
+                const uint64_t historyStart = cycle - timeTravel->getCycle();
+                if ( !travel([&](){ return timeTravel->stepBack(count); }) )
+                {
+                    ConsoleError << "can't go back before the cycle " << historyStart+timeTravel->getFirstCycle() << std::endl;
+                    return false;
+                }
+                ConsoleInfo << "pc: "<< motherboard.getProgramCounter() <<" ("
+                            << codeg::ValueToHex(motherboard.getProgramCounter(), 8, true) << ")" << std::endl;
+                ConsoleInfo << "cycle: " << cycle << std::endl;
+                return true;
+            }},
+            {"reverse_continue", "reverse_continue", "go back to the last breakpoint/watchpoint hit (or the beginning of the history)", 0,0, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if (!timeTravel)
+                {
+                    ConsoleError << "the execution history is disabled" << std::endl;
+                    return false;
+                }
+                codeg::StopConditions conditions;
+                conditions._breakpoints = &breakpoints;
+
+                printRunResult( travel([&](){ return timeTravel->reverseContinue(conditions); }) );
+                return true;
+            }},
+            {"goto_cycle", "goto_cycle [cycle]", "go to the state after a number of instructions since the start", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if (!timeTravel)
+                {
+                    ConsoleError << "the execution history is disabled" << std::endl;
+                    return false;
+                }
+                //The history begin at the last change of the machine
+                const uint64_t historyStart = cycle - timeTravel->getCycle();
+                const uint64_t targetCycle = std::strtoull(args[0].c_str(), nullptr, 0);
+                bool reached = false;
+                if (targetCycle >= historyStart)
+                {
+                    reached = (targetCycle < cycle) ?
+                              travel([&](){ return timeTravel->gotoCycle(targetCycle-historyStart); }) :
+                              timeTravel->gotoCycle(targetCycle-historyStart);
+                    cycle = historyStart + timeTravel->getCycle();
+                }
+                ConsoleInfo << "pc: "<< motherboard.getProgramCounter() <<" ("
+                            << codeg::ValueToHex(motherboard.getProgramCounter(), 8, true) << ")" << std::endl;
+                ConsoleInfo << "cycle: " << cycle << std::endl;
+                if (!reached)
+                {
+                    ConsoleError << "can't reach the cycle " << targetCycle << " (first cycle: " << historyStart+timeTravel->getFirstCycle() << ")" << std::endl;
+                    return false;
+                }
+                return true;
+            }},
+            {"profile", "profile [on|off|clear]", "enable/disable the guest execution profiler or clear its counters", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if (args[0] == "on")
+                {
+                    profiling = true;
+                }
+                else if (args[0] == "off")
+                {
+                    profiling = false;
+                }
+                else if (args[0] == "clear")
+                {
+                    profiler.clear();
+                }
+                else
+                {
+                    return false;
+                }
+                ConsoleInfo << "profiler: " << (profiling ? "on" : "off") << ", " << profiler.getInstructionCount() << " instructions" << std::endl;
+                return true;
+            }},
+            {"profile_report", "profile_report ([top])", "print the hot spots (default is 20) and every counter of the profiler", 0,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                printProfileReport(args.empty() ? CG_PROFILER_DEFAULT_TOP : std::strtoul(args[0].c_str(), nullptr, 0));
+                return true;
+            }},
+            {"profile_csv", "profile_csv [file]", "save the counters of every executed address in a CSV file", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if ( !profiler.saveCsv(args[0], motherboard) )
+                {
+                    ConsoleError << "can't write the file " << args[0] << std::endl;
+                    return false;
+                }
+                ConsoleInfo << "profile saved in " << args[0] << std::endl;
+                return true;
+            }},
+            {"data_profile", "data_profile [on|off|clear]", "enable/disable the data access profiler or clear its counters", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if (args[0] == "on")
+                {
+                    dataProfiling = true;
+                }
+                else if (args[0] == "off")
+                {
+                    dataProfiling = false;
+                }
+                else if (args[0] == "clear")
+                {
+                    dataProfiler.clear();
+                }
+                else
+                {
+                    return false;
+                }
+                ConsoleInfo << "data profiler: " << (dataProfiling ? "on" : "off") << ", "
+                            << dataProfiler.getReadCount() << " reads, " << dataProfiler.getWriteCount() << " writes" << std::endl;
+                return true;
+            }},
+            {"data_report", "data_report ([top])", "print the hottest addresses and the never accessed ranges (default is 10) of every accessed memory slot", 0,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                printDataProfileReport(args.empty() ? CG_DATAPROFILER_DEFAULT_TOP : std::strtoul(args[0].c_str(), nullptr, 0));
+                return true;
+            }},
+            {"data_heatmap", R"(data_heatmap ["m"/"p"] [slot] ([start address] [end address]) (["r"/"w"/"rw"]))", "print a heatmap of the accesses on a motherboard/processor memory slot (default is the whole memory)", 2,5, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                codeg::WatchpointTarget target;
+                if (args[0] == "m")
+                {
+                    target = codeg::WatchpointTarget::TARGET_MOTHERBOARD_SLOT;
+                }
+                else if (args[0] == "p")
+                {
+                    target = codeg::WatchpointTarget::TARGET_PROCESSOR_SLOT;
+                }
+                else
+                {
+                    ConsoleError << R"(please put "m" (motherboard) or "p" (processor))" << std::endl;
+                    return false;
+                }
+
+                const std::size_t slotIndex = std::strtoul(args[1].c_str(), nullptr, 0);
+                const codeg::MemoryModuleSlotCapable& slotCapable = (target == codeg::WatchpointTarget::TARGET_PROCESSOR_SLOT) ?
+                        static_cast<const codeg::MemoryModuleSlotCapable&>(motherboard._processor) : motherboard;
+                const codeg::MemoryModuleSlot* slot = slotCapable.getMemorySlot(slotIndex);
+
+                codeg::MemorySize size = dataProfiler.getAccessedSize(target, slotIndex);
+                if ( (slot != nullptr) && slot->_mem )
+                {
+                    size = std::max(size, slot->_mem->getMemorySize());
+                }
+                codeg::MemoryAddress startAddress = 0;
+                codeg::MemoryAddress endAddress = (size == 0) ? 0 : size-1;
+                if (args.size() >= 4)
+                {
+                    startAddress = std::strtoul(args[2].c_str(), nullptr, 0);
+                    endAddress = std::strtoul(args[3].c_str(), nullptr, 0);
+                }
+                else if (args.size() == 3)
+                {
+                    return false;
+                }
+
+                uint8_t access = codeg::WatchpointAccess::WATCH_READ | codeg::WatchpointAccess::WATCH_WRITE;
+                if (args.size() == 5)
+                {
+                    if (args[4] == "r")
+                    {
+                        access = codeg::WatchpointAccess::WATCH_READ;
+                    }
+                    else if (args[4] == "w")
+                    {
+                        access = codeg::WatchpointAccess::WATCH_WRITE;
+                    }
+                    else if (args[4] != "rw")
+                    {
+                        ConsoleError << R"(please put "r", "w" or "rw")" << std::endl;
+                        return false;
+                    }
+                }
+
+                std::stringstream heatmap;
+                dataProfiler.writeHeatmap(heatmap, target, slotIndex, startAddress, endAddress, access);
+                printLines(heatmap);
+                return true;
+            }},
+            {"data_csv", "data_csv [file]", "save the read/write counters of every accessed address in a CSV file", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if ( !dataProfiler.saveCsv(args[0]) )
+                {
+                    ConsoleError << "can't write the file " << args[0] << std::endl;
+                    return false;
+                }
+                ConsoleInfo << "data profile saved in " << args[0] << std::endl;
+                return true;
+            }},
+            {"call_graph", "call_graph [on|off|clear]", "enable/disable the call graph profiler or clear it", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if (args[0] == "on")
+                {
+                    callGraphProfiling = true;
+                }
+                else if (args[0] == "off")
+                {
+                    callGraphProfiling = false;
+                }
+                else if (args[0] == "clear")
+                {
+                    callGraph.clear();
+                }
+                else
+                {
+                    return false;
+                }
+                ConsoleInfo << "call graph: " << (callGraphProfiling ? "on" : "off") << ", " << callGraph.getCallCount() << " calls, depth "
+                            << callGraph.getDepth() << std::endl;
+                return true;
+            }},
+            {"call_graph_report", "call_graph_report ([top])", "print the functions with their inclusive/exclusive instructions and the calls (default is 20)", 0,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                printCallGraphReport(args.empty() ? CG_CALLGRAPH_DEFAULT_TOP : std::strtoul(args[0].c_str(), nullptr, 0));
+                return true;
+            }},
+            {"call_graph_stacks", "call_graph_stacks [file]", "save the collapsed stacks of the call graph (for flame graph tools) in a file", 1,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if ( !callGraph.saveCollapsedStacks(args[0]) )
+                {
+                    ConsoleError << "can't write the file " << args[0] << std::endl;
+                    return false;
+                }
+                ConsoleInfo << "collapsed stacks saved in " << args[0] << std::endl;
+                return true;
+            }},
+            {"timing", "timing", "print the simulated time of the board and the host speed of every run since the start", 0,0, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                ConsoleInfo << "cycle: " << cycle << std::endl;
+                printTiming();
+                return true;
+            }},
+            {"board_clock", "board_clock ([frequency])", "print or set the board clock frequency in Hz", 0,1, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if (!args.empty())
+                {
+                    const double frequency = std::strtod(args[0].c_str(), nullptr);
+                    if ( !(frequency > 0.0) )
+                    {
+                        ConsoleError << "the clock frequency must be positive" << std::endl;
+                        return false;
+                    }
+                    motherboard.setClockFrequency(frequency);
+                }
+                ConsoleInfo << "board clock: " << motherboard.getClockFrequency() << " Hz" << std::endl;
+                return true;
+            }},
+            {"history", "history", "print information about the execution history", 0,0, [&]([[maybe_unused]] const std::vector<std::string>& args){
+                if (!timeTravel)
+                {
+                    ConsoleError << "the execution history is disabled" << std::endl;
+                    return false;
+                }
+                ConsoleInfo << "cycle: " << cycle << " (first cycle: " << cycle-timeTravel->getCycle()+timeTravel->getFirstCycle() << ")" << std::endl;
+                ConsoleInfo << "checkpoints: " << timeTravel->getCheckpointCount()
+                            << " every " << timeTravel->getInterval() << " instructions" << std::endl;
+                ConsoleInfo << "memory: " << timeTravel->getMemoryUsage()/1024 << "/" << timeTravel->getMemoryBudget()/1024 << " KiB" << std::endl;
+                return true;
+            }}
+        };
+
+        //Return false if the command is unknown or failed
+        executeCommand = [&](std::string commandLine){
             commandLine = codeg::RemoveExtraSpace(commandLine);
 
+            //Local as a replayed command can be executed during a run command
+            std::string commandName;
+            std::vector<std::string> commandArgs;
+
             codeg::Split(commandLine, commandArgs, ' ');
 
             if (commandArgs.empty())
             {
-                continue;
+                return true;
             }
 
             commandName = std::move(commandArgs.front());
@@ -535,59 +1628,158 @@ int main(int argc, char **argv)
 
             ConsoleInfo << "user command: \"" << commandName << "\"" << std::endl;
 
-            bool knownCommand = false;
-
             if (commandName == "help")
             {
-                knownCommand = true;
-
                 for (auto& command : commands)
                 {
                     ConsoleInfo << '\t' << command._name << ", " << command._usage << " <- " << command._description << std::endl;
                 }
+                return true;
             }
-            else
+
+            for (auto& command: commands)
             {
-                for (auto& command: commands)
+                if (command._name == commandName)
                 {
-                    if (command._name == commandName)
+                    if (commandArgs.size() < command._minArguments ||
+                        commandArgs.size() > command._maxArguments)
                     {
-                        knownCommand = true;
-
-                        if (commandArgs.size() < command._minArguments ||
-                            commandArgs.size() > command._maxArguments)
+                        ConsoleError << "bad arguments size: " << command._minArguments << " >= "
+                                     << commandArgs.size() << " <= " << command._maxArguments << std::endl;
+                        ConsoleError << "usage: " << command._usage << std::endl;
+                        return false;
+                    }
+                    try
+                    {
+                        if (!command._func(commandArgs))
                         {
-                            ConsoleError << "bad arguments size: " << command._minArguments << " >= "
-                                         << commandArgs.size() << " <= " << command._maxArguments << std::endl;
                             ConsoleError << "usage: " << command._usage << std::endl;
+                            return false;
                         }
-                        else if (!command._func(commandArgs))
+                        if ( std::find(inputCommands.cbegin(), inputCommands.cend(), commandName) != inputCommands.cend() )
                         {
-                            ConsoleError << "usage: " << command._usage << std::endl;
+                            resetHistory();
+                            if (recording)
+                            {
+                                recordLog.add({cycle, codeg::InputEventType::EVENT_COMMAND, 0, commandLine});
+                            }
                         }
-                        break;
                     }
+                    catch (const codeg::Error& e)
+                    {//A failed command must not end the session
+                        ConsoleError << "error : " << e.what() << std::endl;
+                        return false;
+                    }
+                    return true;
                 }
             }
-            if (!knownCommand)
+
+            ConsoleWarning << "unknown command" << std::endl;
+            return false;
+        };
+
+        std::string commandLine;
+        if (batchMode)
+        {
+            std::size_t lineNumber = 0;
+            while ( running && std::getline(scriptFile, commandLine) )
             {
-                ConsoleWarning << "unknown command" << std::endl;
+                ++lineNumber;
+                if ( commandLine.empty() || (commandLine.front() == '#') )
+                {
+                    continue;
+                }
+                if ( !executeCommand(commandLine) )
+                {
+                    ConsoleError << "script error at line " << lineNumber << " of " << scriptPath << std::endl;
+                    exitCode = CGS_EXIT_SCRIPT_ERROR;
+                    break;
+                }
             }
-        } while (running);
+
+            //An "exit" in the script end the session without the final run
+            if ( running && (exitCode != CGS_EXIT_SCRIPT_ERROR) &&
+                 (!runUntil.empty() || (maxInstructionsOption->count() > 0) || !replayPath.empty()) )
+            {
+                //By default a replay stop where the recorded run stopped
+                if ( !replayPath.empty() && runUntil.empty() && (maxInstructionsOption->count() == 0) )
+                {
+                    batchMaxInstructions = (replayLog.getEndCycle() > cycle) ? static_cast<std::size_t>(replayLog.getEndCycle()-cycle) : 0;
+                }
+
+                codeg::StopConditions conditions;
+                conditions._breakpoints = &breakpoints;
+                if ( !runUntil.empty() )
+                {
+                    conditions._stopAtProgramCounter = true;
+                    conditions._programCounter = static_cast<codeg::MemoryAddress>(runUntilAddress);
+                }
+
+                printRunResult( runEngine(batchMaxInstructions, conditions) );
+            }
+
+            printTiming();
+            ConsoleInfo << "exit code: " << exitCode << std::endl;
+        }
+        else
+        {
+            ConsoleInfo << "Waiting user input" << std::endl;
+
+            do
+            {
+                std::cout << ">";
+                if ( !std::getline(std::cin, commandLine) )
+                {//End of the input
+                    break;
+                }
+
+                executeCommand(commandLine);
+            } while (running);
+
+            //The exit code is only meaningful in batch mode
+            exitCode = CGS_EXIT_SUCCESS;
+        }
+
+        if ( !profilePath.empty() )
+        {
+            printProfileReport(CG_PROFILER_DEFAULT_TOP);
+            if ( !profiler.saveCsv(profilePath, motherboard) )
+            {
+                ConsoleError << "Can't write the file " << profilePath << std::endl;
+            }
+        }
+        if ( !dataProfilePath.empty() )
+        {
+            printDataProfileReport(CG_DATAPROFILER_DEFAULT_TOP);
+            if ( !dataProfiler.saveCsv(dataProfilePath) )
+            {
+                ConsoleError << "Can't write the file " << dataProfilePath << std::endl;
+            }
+        }
+        if ( !callGraphPath.empty() )
+        {
+            printCallGraphReport(CG_CALLGRAPH_DEFAULT_TOP);
+            if ( !callGraph.saveCollapsedStacks(callGraphPath) )
+            {
+                ConsoleError << "Can't write the file " << callGraphPath << std::endl;
+            }
+        }
     }
     catch (const codeg::Error& e)
     {
         ConsoleError << "error : " <<  e.what() << std::endl;
-        return -1;
+        exitCode = -1;
     }
     catch (const std::exception& e)
     {
         ConsoleFatal << "unknown exception : " << e.what() << std::endl;
-        return -1;
+        exitCode = -1;
     }
 
+    saveRecord();
+
     codeg::varConsole->logClose();
     delete codeg::varConsole;
 
-    return 0;
+    return exitCode;
 }
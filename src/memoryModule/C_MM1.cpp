@@ -15,6 +15,7 @@
 /////////////////////////////////////////////////////////////////////////////////
 
 #include "memoryModule/C_MM1.hpp"
+#include "C_snapshot.hpp"
 
 namespace codeg
 {
@@ -26,15 +27,6 @@ MM1::MM1(codeg::MemorySize memorySize) :
 {
 }
 
-bool MM1::set(codeg::MemoryAddress address, uint8_t data)
-{
-    if (address < this->g_data.size())
-    {
-        this->g_data[address] = data;
-        return true;
-    }
-    return false;
-}
 bool MM1::set(codeg::MemoryAddress address, uint8_t* data, codeg::MemorySize dataSize)
 {
     if (dataSize == 0)
@@ -48,15 +40,7 @@ bool MM1::set(codeg::MemoryAddress address, uint8_t* data, codeg::MemorySize dat
         {
             this->g_data[address+i] = data[i];
         }
-        return true;
-    }
-    return false;
-}
-bool MM1::get(codeg::MemoryAddress address, uint8_t& data) const
-{
-    if (address < this->g_data.size())
-    {
-        data = this->g_data[address];
+        ++this->_g_modificationCount;
         return true;
     }
     return false;
@@ -84,6 +68,31 @@ std::string MM1::getType() const
     return "MM1";
 }
 
+std::shared_ptr<codeg::MemoryModule> MM1::fork() const
+{
+    return std::make_shared<codeg::MM1>(*this);
+}
+
+void MM1::saveState(codeg::SnapshotWriter& writer) const
+{
+    writer.write<uint64_t>(this->g_data.size());
+    writer.align();
+    writer.writeBytes(this->g_data.data(), this->g_data.size());
+}
+void MM1::loadState(codeg::SnapshotReader& reader)
+{
+    const auto size = reader.read<uint64_t>();
+    if (size != this->g_data.size())
+    {
+        throw codeg::Error("snapshot: the memory size doesn't match");
+    }
+    reader.align();
+    std::memcpy(this->g_data.data(), reader.readBytes(size), size);
+
+    //Invalidate the data derived from the previous content
+    ++this->_g_modificationCount;
+}
+
 ///MM1_xk
 MM1_64k::MM1_64k() :
         codeg::MM1(1 << 16)
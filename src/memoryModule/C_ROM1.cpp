@@ -0,0 +1,288 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "memoryModule/C_ROM1.hpp"
+#include "C_snapshot.hpp"
+#include "C_error.hpp"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define CG_ROM1_MMAP
+#endif
+
+namespace codeg
+{
+
+namespace
+{
+
+class BufferContent : public codeg::ROMContent
+{
+public:
+    explicit BufferContent(std::vector<uint8_t> data) :
+            g_data(std::move(data))
+    {}
+    ~BufferContent() override = default;
+
+    [[nodiscard]] const uint8_t* getData() const override
+    {
+        return this->g_data.data();
+    }
+    [[nodiscard]] codeg::MemorySize getSize() const override
+    {
+        return this->g_data.size();
+    }
+
+private:
+    std::vector<uint8_t> g_data;
+};
+
+#if defined(_WIN32) || defined(CG_ROM1_MMAP)
+class MappedFileContent : public codeg::ROMContent
+{
+public:
+    MappedFileContent(const std::filesystem::path& path, codeg::MemorySize maxSize)
+    {
+    #ifdef _WIN32
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw codeg::Error("rom: can't open the file "+path.string());
+        }
+        LARGE_INTEGER fileSize;
+        if ( !GetFileSizeEx(file, &fileSize) )
+        {
+            CloseHandle(file);
+            throw codeg::Error("rom: can't read the size of the file "+path.string());
+        }
+        this->g_size = static_cast<codeg::MemorySize>(fileSize.QuadPart);
+        this->checkSize(path, maxSize);
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr)
+        {
+            throw codeg::Error("rom: can't map the file "+path.string());
+        }
+        this->g_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(mapping); //The view keep the mapping alive
+    #else
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            throw codeg::Error("rom: can't open the file "+path.string());
+        }
+        struct stat fileStat{};
+        if (fstat(file, &fileStat) != 0)
+        {
+            close(file);
+            throw codeg::Error("rom: can't read the size of the file "+path.string());
+        }
+        this->g_size = static_cast<codeg::MemorySize>(fileStat.st_size);
+        this->checkSize(path, maxSize);
+
+        void* data = mmap(nullptr, this->g_size, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file); //The mapping keep the file alive
+        this->g_data = (data == MAP_FAILED) ? nullptr : static_cast<const uint8_t*>(data);
+    #endif
+        if (this->g_data == nullptr)
+        {
+            throw codeg::Error("rom: can't map the file "+path.string());
+        }
+    }
+    ~MappedFileContent() override
+    {
+    #ifdef _WIN32
+        UnmapViewOfFile(this->g_data);
+    #else
+        munmap(const_cast<uint8_t*>(this->g_data), this->g_size);
+    #endif
+    }
+
+    [[nodiscard]] const uint8_t* getData() const override
+    {
+        return this->g_data;
+    }
+    [[nodiscard]] codeg::MemorySize getSize() const override
+    {
+        return this->g_size;
+    }
+
+private:
+    void checkSize(const std::filesystem::path& path, codeg::MemorySize maxSize) const
+    {//An empty file can't be mapped, MapFileContent don't map them
+        if ( (this->g_size == 0) || (this->g_size > maxSize) )
+        {
+            throw codeg::Error("rom: bad size for the file "+path.string()+" ("+std::to_string(this->g_size)+" bytes)");
+        }
+    }
+
+    const uint8_t* g_data{nullptr};
+    codeg::MemorySize g_size{0};
+};
+#else
+std::shared_ptr<const codeg::ROMContent> ReadFileContent(const std::filesystem::path& path, codeg::MemorySize maxSize)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw codeg::Error("rom: can't open the file "+path.string());
+    }
+    std::vector<uint8_t> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if (data.size() > maxSize)
+    {
+        throw codeg::Error("rom: bad size for the file "+path.string()+" ("+std::to_string(data.size())+" bytes)");
+    }
+    return std::make_shared<BufferContent>(std::move(data));
+}
+#endif
+
+//Every ROM of the same file share the same mapping while one of them is alive
+std::shared_ptr<const codeg::ROMContent> OpenFileContent(const std::filesystem::path& path)
+{
+    static std::mutex mutex;
+    static std::map<std::filesystem::path, std::weak_ptr<const codeg::ROMContent> > openedFiles;
+
+    std::error_code error;
+    std::filesystem::path canonicalPath = std::filesystem::canonical(path, error);
+    if (error)
+    {
+        throw codeg::Error("rom: can't open the file "+path.string());
+    }
+
+    std::scoped_lock lock(mutex);
+
+    std::weak_ptr<const codeg::ROMContent>& openedFile = openedFiles[canonicalPath];
+    std::shared_ptr<const codeg::ROMContent> content = openedFile.lock();
+    if (!content)
+    {
+        content = codeg::MapFileContent(canonicalPath, CG_ROM1_MAX_SIZE);
+        openedFile = content;
+    }
+    return content;
+}
+
+}//end
+
+std::shared_ptr<const codeg::ROMContent> MapFileContent(const std::filesystem::path& path, codeg::MemorySize maxSize)
+{
+#if defined(_WIN32) || defined(CG_ROM1_MMAP)
+    std::error_code error;
+    if (std::filesystem::file_size(path, error) == 0)
+    {
+        if (error)
+        {
+            throw codeg::Error("rom: can't read the size of the file "+path.string());
+        }
+        return std::make_shared<BufferContent>(std::vector<uint8_t>{});
+    }
+    return std::make_shared<MappedFileContent>(path, maxSize);
+#else
+    return ReadFileContent(path, maxSize);
+#endif
+}
+
+ROM1::ROM1(codeg::MemorySize memorySize) :
+        codeg::MemoryModule(memorySize),
+        g_content(std::make_shared<BufferContent>(std::vector<uint8_t>(memorySize, 0))),
+        g_data(g_content->getData())
+{
+}
+ROM1::ROM1(const std::filesystem::path& path) :
+        codeg::MemoryModule(0),
+        g_content(OpenFileContent(path)),
+        g_data(g_content->getData())
+{
+    this->_g_memorySize = this->g_content->getSize();
+}
+
+bool ROM1::set([[maybe_unused]] codeg::MemoryAddress address, [[maybe_unused]] uint8_t* data, [[maybe_unused]] codeg::MemorySize dataSize)
+{
+    return false;
+}
+bool ROM1::get(codeg::MemoryAddress startAddress, codeg::MemorySize addressCount, uint8_t* data, codeg::MemorySize dataSize) const
+{
+    if ((dataSize == 0) || (addressCount == 0) || (dataSize<addressCount))
+    {
+        return false;
+    }
+
+    if ( (startAddress < this->_g_memorySize) && (startAddress+addressCount < this->_g_memorySize) )
+    {
+        std::memcpy(data, this->g_data+startAddress, addressCount);
+        return true;
+    }
+    return false;
+}
+
+std::string ROM1::getType() const
+{
+    return "ROM1";
+}
+bool ROM1::isSlotCompatible(const std::string& slotType) const
+{
+    return (slotType == "MM1") || (slotType == this->getType());
+}
+
+std::shared_ptr<codeg::MemoryModule> ROM1::fork() const
+{
+    return std::make_shared<codeg::ROM1>(*this);
+}
+
+void ROM1::saveState(codeg::SnapshotWriter& writer) const
+{
+    writer.write<uint64_t>(this->_g_memorySize);
+    writer.align();
+    writer.writeBytes(this->g_data, this->_g_memorySize);
+}
+void ROM1::loadState(codeg::SnapshotReader& reader)
+{
+    const auto size = reader.read<uint64_t>();
+    if (size != this->_g_memorySize)
+    {
+        throw codeg::Error("snapshot: the memory size doesn't match");
+    }
+    reader.align();
+    const uint8_t* data = reader.readBytes(size);
+
+    if ( (size != 0) && (std::memcmp(data, this->g_data, size) != 0) )
+    {//Not the same program, the ROM is no more shared
+        this->g_content = std::make_shared<BufferContent>(std::vector<uint8_t>(data, data+size));
+        this->g_data = this->g_content->getData();
+        ++this->_g_modificationCount; //The instructions decoded from the previous program are outdated
+    }
+}
+
+bool ROM1::isMapped() const
+{
+    return dynamic_cast<const BufferContent*>(this->g_content.get()) == nullptr;
+}
+
+}//end codeg
@@ -0,0 +1,166 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include "memoryModule/C_pagedMM1.hpp"
+#include "C_snapshot.hpp"
+#include <algorithm>
+
+namespace codeg
+{
+
+template<std::size_t TPageSize>
+BasicPagedMM1<TPageSize>::BasicPagedMM1(codeg::MemorySize memorySize) :
+        codeg::MemoryModule(memorySize),
+        g_pages((memorySize+TPageSize-1) / TPageSize)
+{
+}
+
+//Same bounds as MM1 so the modules can be swapped
+template<std::size_t TPageSize>
+bool BasicPagedMM1<TPageSize>::set(codeg::MemoryAddress address, uint8_t* data, codeg::MemorySize dataSize)
+{
+    if (dataSize == 0)
+    {
+        return false;
+    }
+
+    if ( (address < this->_g_memorySize) && (address+dataSize < this->_g_memorySize) )
+    {
+        for (codeg::MemorySize i=0; i<dataSize; ++i)
+        {
+            this->getWritablePage(address+i)[(address+i) % TPageSize] = data[i];
+        }
+        ++this->_g_modificationCount;
+        return true;
+    }
+    return false;
+}
+template<std::size_t TPageSize>
+bool BasicPagedMM1<TPageSize>::get(codeg::MemoryAddress startAddress, codeg::MemorySize addressCount, uint8_t* data, codeg::MemorySize dataSize) const
+{
+    if ((dataSize == 0) || (addressCount == 0) || (dataSize<addressCount))
+    {
+        return false;
+    }
+
+    if ( (startAddress < this->_g_memorySize) && (startAddress+addressCount < this->_g_memorySize) )
+    {
+        for (codeg::MemorySize i=0; i<addressCount; ++i)
+        {
+            this->get(startAddress+i, data[i]);
+        }
+        return true;
+    }
+    return false;
+}
+
+template<>
+std::string BasicPagedMM1<CG_PAGEDMM1_PAGE_SIZE>::getType() const
+{
+    return "MM1_PAGED";
+}
+template<>
+std::string BasicPagedMM1<CG_SPARSEMM1_PAGE_SIZE>::getType() const
+{
+    return "MM1_SPARSE";
+}
+template<std::size_t TPageSize>
+bool BasicPagedMM1<TPageSize>::isSlotCompatible(const std::string& slotType) const
+{
+    return (slotType == "MM1") || (slotType == this->getType());
+}
+
+template<std::size_t TPageSize>
+std::shared_ptr<codeg::MemoryModule> BasicPagedMM1<TPageSize>::fork() const
+{
+    return std::make_shared<codeg::BasicPagedMM1<TPageSize> >(*this);
+}
+
+template<std::size_t TPageSize>
+void BasicPagedMM1<TPageSize>::saveState(codeg::SnapshotWriter& writer) const
+{
+    writer.write<uint64_t>(this->_g_memorySize);
+    writer.write<uint64_t>(TPageSize);
+    writer.write<uint64_t>(this->getAllocatedPageCount());
+    for (std::size_t i=0; i<this->g_pages.size(); ++i)
+    {
+        if (this->g_pages[i])
+        {
+            writer.write<uint64_t>(i);
+            writer.align();
+            writer.writeBytes(this->g_pages[i]->data(), TPageSize);
+        }
+    }
+}
+template<std::size_t TPageSize>
+void BasicPagedMM1<TPageSize>::loadState(codeg::SnapshotReader& reader)
+{
+    const auto size = reader.read<uint64_t>();
+    if (size != this->_g_memorySize)
+    {
+        throw codeg::Error("snapshot: the memory size doesn't match");
+    }
+    if (reader.read<uint64_t>() != TPageSize)
+    {
+        throw codeg::Error("snapshot: the page size doesn't match");
+    }
+
+    const auto pageCount = reader.read<uint64_t>();
+    if (pageCount > this->g_pages.size())
+    {
+        throw codeg::Error("snapshot: bad page count");
+    }
+
+    std::vector<std::shared_ptr<Page> > pages(this->g_pages.size());
+    for (uint64_t i=0; i<pageCount; ++i)
+    {
+        const auto index = reader.read<uint64_t>();
+        if ( (index >= pages.size()) || pages[index] )
+        {
+            throw codeg::Error("snapshot: bad page index");
+        }
+        reader.align();
+        const uint8_t* data = reader.readBytes(TPageSize);
+
+        pages[index] = std::make_shared<Page>();
+        std::copy(data, data+TPageSize, pages[index]->begin());
+    }
+    //The pages shared with forks are kept by them
+    this->g_pages = std::move(pages);
+
+    ++this->_g_modificationCount;
+}
+
+template<std::size_t TPageSize>
+std::size_t BasicPagedMM1<TPageSize>::getAllocatedPageCount() const
+{
+    return static_cast<std::size_t>(std::count_if(this->g_pages.cbegin(), this->g_pages.cend(), [](const std::shared_ptr<Page>& page){
+        return page != nullptr;
+    }));
+}
+template<std::size_t TPageSize>
+std::size_t BasicPagedMM1<TPageSize>::getOwnedPageCount() const
+{
+    return static_cast<std::size_t>(std::count_if(this->g_pages.cbegin(), this->g_pages.cend(), [](const std::shared_ptr<Page>& page){
+        return page && (page.use_count() == 1);
+    }));
+}
+
+template class codeg::BasicPagedMM1<CG_PAGEDMM1_PAGE_SIZE>;
+template class codeg::BasicPagedMM1<CG_SPARSEMM1_PAGE_SIZE>;
+
+}//end codeg
@@ -15,6 +15,8 @@
 /////////////////////////////////////////////////////////////////////////////////
 
 #include "memoryModule/memoryModules.hpp"
+#include "C_snapshot.hpp"
+#include <mutex>
 #include <unordered_map>
 
 namespace codeg
@@ -24,11 +26,14 @@ namespace
 {
 
 std::unordered_map<std::string, std::unique_ptr<MemoryModuleClassTypeBase> > gData;
+std::mutex gDataMutex; //Snapshots restored on several threads can create modules at the same time
 
 }//end
 
 void RegisterNewMemoryModuleType(std::unique_ptr<MemoryModuleClassTypeBase>&& classType)
 {
+    std::scoped_lock<std::mutex> lock(gDataMutex);
+
     auto it = gData.find(classType->getType());
     if (it == gData.end())
     {
@@ -38,6 +43,8 @@ void RegisterNewMemoryModuleType(std::unique_ptr<MemoryModuleClassTypeBase>&& cl
 }
 MemoryModule* GetNewMemoryModule(const std::string& type, codeg::MemorySize memorySize)
 {
+    std::scoped_lock<std::mutex> lock(gDataMutex);
+
     auto it = gData.find(type);
     if (it != gData.end())
     {
@@ -52,4 +59,147 @@ MemoryModule* GetNewMemoryModule(const std::string& type, codeg::MemorySize memo
     return nullptr;
 }
 
+///MemoryModuleStore
+
+void MemoryModuleStore::save(const std::shared_ptr<codeg::MemoryModule>& memoryModule, const codeg::MemoryModuleStore* previous)
+{
+    const std::size_t index = this->g_entries.size();
+    const uint64_t modificationCount = memoryModule->getModificationCount();
+
+    if ( (previous != nullptr) && (index < previous->g_entries.size()) )
+    {
+        const Entry& entry = previous->g_entries[index];
+        if ( (entry._source.lock() == memoryModule) && (entry._modificationCount == modificationCount) )
+        {
+            this->g_entries.push_back(entry);
+            return;
+        }
+    }
+    this->g_entries.push_back({memoryModule, modificationCount, memoryModule->fork()});
+}
+void MemoryModuleStore::load(std::size_t index, std::shared_ptr<codeg::MemoryModule>& memoryModule) const
+{
+    if (index >= this->g_entries.size())
+    {
+        throw codeg::Error("snapshot: the memory module count doesn't match");
+    }
+
+    const Entry& entry = this->g_entries[index];
+    if ( (entry._source.lock() != memoryModule) || (memoryModule->getModificationCount() != entry._modificationCount) )
+    {
+        memoryModule = entry._image->fork();
+    }
+}
+std::size_t MemoryModuleStore::getUnsharedSize(const codeg::MemoryModuleStore* previous) const
+{
+    std::size_t size = 0;
+    for (std::size_t i=0; i<this->g_entries.size(); ++i)
+    {
+        const Entry& entry = this->g_entries[i];
+        if ( entry._image->isReadOnly() )
+        {//The content is shared with the plugged module
+            continue;
+        }
+        if ( (previous == nullptr) || (i >= previous->g_entries.size()) || (previous->g_entries[i]._image != entry._image) )
+        {
+            size += entry._image->getMemorySize();
+        }
+    }
+    return size;
+}
+
+///MemoryModuleSlotCapable
+
+void MemoryModuleSlotCapable::saveMemorySlots(codeg::SnapshotWriter& writer) const
+{
+    writer.write<uint64_t>(this->_g_memorySlots.size());
+    writer.write<uint64_t>(this->_g_memorySource);
+
+    for (const auto& slot : this->_g_memorySlots)
+    {
+        writer.write<uint8_t>(slot._mem ? 1 : 0);
+        if (slot._mem)
+        {
+            writer.writeString(slot._mem->getType());
+            if ( writer.hasMemoryStore() )
+            {
+                writer.saveMemoryModule(slot._mem);
+            }
+            else
+            {
+                slot._mem->saveState(writer);
+            }
+        }
+    }
+}
+void MemoryModuleSlotCapable::loadMemorySlots(codeg::SnapshotReader& reader)
+{
+    if (reader.read<uint64_t>() != this->_g_memorySlots.size())
+    {
+        throw codeg::Error("snapshot: the memory slot count doesn't match");
+    }
+    const auto memorySource = reader.read<uint64_t>();
+
+    for (auto& slot : this->_g_memorySlots)
+    {
+        if (reader.read<uint8_t>() == 0)
+        {
+            slot._mem.reset();
+            UpdateMemorySpans(slot);
+            continue;
+        }
+
+        const std::string type = reader.readString();
+
+        if ( reader.hasMemoryStore() )
+        {//Same machine, the module is only replaced if it changed
+            reader.loadMemoryModule(slot._mem);
+            UpdateMemorySpans(slot);
+            continue;
+        }
+
+        //Peek the size, every memory module start its state with it
+        codeg::SnapshotReader sizeReader = reader;
+        const auto size = sizeReader.read<uint64_t>();
+
+        if ( !slot._mem || (slot._mem->getType() != type) || (slot._mem->getMemorySize() != size) )
+        {
+            slot._mem.reset( codeg::GetNewMemoryModule(type, size) );
+            UpdateMemorySpans(slot);
+            if (!slot._mem)
+            {
+                throw codeg::Error("snapshot: can't create the memory module \""+type+"\"");
+            }
+            if ( !slot._mem->isSlotCompatible(slot._slotType) )
+            {
+                throw codeg::Error("snapshot: the memory module type \""+type+"\" can't be plugged in this slot");
+            }
+        }
+        slot._mem->loadState(reader);
+        UpdateMemorySpans(slot);
+    }
+
+    //The source is selected once its module is restored
+    if ( (memorySource != this->_g_memorySource) && !this->setMemorySource(memorySource) )
+    {
+        throw codeg::Error("snapshot: bad memory source");
+    }
+}
+
+void MemoryModuleSlotCapable::forkMemorySlots(const codeg::MemoryModuleSlotCapable& parent)
+{
+    if (parent._g_memorySlots.size() != this->_g_memorySlots.size())
+    {
+        throw codeg::Error("fork: the memory slot count doesn't match");
+    }
+
+    for (std::size_t i=0; i<this->_g_memorySlots.size(); ++i)
+    {
+        const auto& parentMemory = parent._g_memorySlots[i]._mem;
+        this->_g_memorySlots[i]._mem = parentMemory ? parentMemory->fork() : nullptr;
+        UpdateMemorySpans(this->_g_memorySlots[i]);
+    }
+    this->_g_memorySource = parent._g_memorySource;
+}
+
 }//end codeg
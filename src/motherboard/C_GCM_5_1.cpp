@@ -15,6 +15,8 @@
 /////////////////////////////////////////////////////////////////////////////////
 
 #include "motherboard/C_GCM_5_1.hpp"
+#include "C_codeg.hpp"
+#include "C_snapshot.hpp"
 
 namespace codeg
 {
@@ -31,17 +33,16 @@ GCM_5_1_SPS1::GCM_5_1_SPS1()
     this->_g_memorySlots.push_back( {nullptr, "MM1", 3, true, true} );
     this->_g_memorySlots.push_back( {nullptr, "MM1", 3, true, true} );
 
-    this->_processor._signals.get(CG_PROC_SPS1_SIGNAL_ADDSRC_CLK).attach([&](bool val){codeg::GCM_5_1_SPS1::signal_ADDSRC_CLK(val);});
-    this->_processor._signals.get(CG_PROC_SPS1_SIGNAL_JMPSRC_CLK).attach([&](bool val){codeg::GCM_5_1_SPS1::signal_JMPSRC_CLK(val);});
-    this->_processor._signals.get(CG_PROC_SPS1_SIGNAL_PERIPHERAL_CLK).attach([&](bool val){codeg::GCM_5_1_SPS1::signal_PERIPHERAL_CLK(val);});
-    this->_processor._signals.get(CG_PROC_SPS1_SIGNAL_SELECTING_RBEXT1).attach([&](bool val){codeg::GCM_5_1_SPS1::signal_SELECTING_RBEXT1(val);});
-    this->_processor._signals.get(CG_PROC_SPS1_SIGNAL_SELECTING_RBEXT2).attach([&](bool val){codeg::GCM_5_1_SPS1::signal_SELECTING_RBEXT2(val);});
+    this->_processor._signals.get(codeg::SIGNAL_SPS1_ADDSRC_CLK).attach<GCM_5_1_SPS1, &GCM_5_1_SPS1::signal_ADDSRC_CLK>(this);
+    this->_processor._signals.get(codeg::SIGNAL_SPS1_JMPSRC_CLK).attach<GCM_5_1_SPS1, &GCM_5_1_SPS1::signal_JMPSRC_CLK>(this);
+    this->_processor._signals.get(codeg::SIGNAL_SPS1_PERIPHERAL_CLK).attach<GCM_5_1_SPS1, &GCM_5_1_SPS1::signal_PERIPHERAL_CLK>(this);
+    this->_processor._signals.get(codeg::SIGNAL_SPS1_SELECTING_RBEXT1).attach<GCM_5_1_SPS1, &GCM_5_1_SPS1::signal_SELECTING_RBEXT1>(this);
+    this->_processor._signals.get(codeg::SIGNAL_SPS1_SELECTING_RBEXT2).attach<GCM_5_1_SPS1, &GCM_5_1_SPS1::signal_SELECTING_RBEXT2>(this);
 }
 
 void GCM_5_1_SPS1::softReset()
 {
     this->setProgramCounter(0);
-    this->updateDataSource();
 
     this->_processor.softReset();
 }
@@ -56,53 +57,154 @@ void GCM_5_1_SPS1::hardReset()
 
 uint8_t GCM_5_1_SPS1::updateDataSource()
 {
-    uint8_t memData = 0;
-    this->getMemorySourceSlot()->_mem->get(this->getProgramCounter(), memData);
-    this->_processor._busses.get(CG_PROC_SPS1_BUS_BDATASRC).set(memData);
+    const uint8_t memData = this->getMemorySourceSlot()->read(this->_g_programCounter);
+    this->_processor._busses.get(codeg::BUS_SPS1_BDATASRC).set(memData);
     return memData;
 }
 
-std::string GCM_5_1_SPS1::getType()
+bool GCM_5_1_SPS1::step()
 {
-    return "GCM_5_1_SPS1";
+    const codeg::MemoryModuleSlot* sourceSlot = this->getMemorySourceSlot();
+    if ( !this->_processor.isSync() || (sourceSlot == nullptr) || !sourceSlot->_mem )
+    {
+        return this->_processor.clockUntilSync(20);
+    }
+
+    //Copied as executing the instruction can change the source memory
+    const codeg::DecodedInstruction decoded = this->g_instructionCache.get(sourceSlot->_mem, this->_g_programCounter);
+
+    //ADDSRC_CLK done by the processor after reading the instruction
+    ++this->_g_programCounter;
+
+    this->_processor.executeDecoded(decoded);
+
+    if ( decoded._opcode != codeg::CodegBinaryRev1::OPCODE_JMPSRC_CLK )
+    {//The jump instruction inhibit a clock to the next address
+        if ( decoded._bus == codeg::CodegBinaryRev1Busses::READABLE_SOURCE )
+        {
+            ++this->_g_programCounter;
+        }
+    }
+
+    this->updateDataSource();
+    return true;
 }
 
-void GCM_5_1_SPS1::signal_ADDSRC_CLK(bool val)
+void GCM_5_1_SPS1::saveState(codeg::SnapshotWriter& writer) const
 {
-    if (val)
+    codeg::Motherboard::saveState(writer);
+
+    writer.beginSection(codeg::SNAPSHOT_TAG_PROCESSOR);
+    this->_processor.saveState(writer);
+    writer.endSection();
+
+    writer.beginSection(codeg::SNAPSHOT_TAG_ALU);
+    writer.write<uint8_t>(this->_processor._alu ? 1 : 0);
+    if (this->_processor._alu)
     {
-        this->setProgramCounter( this->_g_programCounter+1 );
-        this->updateDataSource();
+        this->_processor._alu->saveState(writer);
     }
+    writer.endSection();
+
+    writer.beginSection(codeg::SNAPSHOT_TAG_PROCESSOR_MEMORY);
+    this->_processor.saveMemorySlots(writer);
+    writer.endSection();
 }
-void GCM_5_1_SPS1::signal_JMPSRC_CLK(bool val)
+void GCM_5_1_SPS1::loadState(codeg::SnapshotReader& reader)
 {
-    if (val)
-    {
-        this->setProgramCounter(this->_processor._busses.get(CG_PROC_SPS1_BUS_BJMPSRC).get());
-        this->updateDataSource();
+    codeg::Motherboard::loadState(reader);
+
+    reader.openSection(codeg::SNAPSHOT_TAG_PROCESSOR);
+    this->_processor.loadState(reader);
+    reader.closeSection();
+
+    reader.openSection(codeg::SNAPSHOT_TAG_ALU);
+    if (reader.read<uint8_t>() != 0)
+    {//The ALU can't be created, it must already be plugged
+        if (!this->_processor._alu)
+        {
+            throw codeg::Error("snapshot: no ALU to restore");
+        }
+        this->_processor._alu->loadState(reader);
     }
+    reader.closeSection();
+
+    reader.openSection(codeg::SNAPSHOT_TAG_PROCESSOR_MEMORY);
+    this->_processor.loadMemorySlots(reader);
+    reader.closeSection();
+
+    //Release the replaced memory modules kept by the cache
+    this->g_instructionCache.clear();
 }
-void GCM_5_1_SPS1::signal_PERIPHERAL_CLK([[maybe_unused]] bool val)
+
+void GCM_5_1_SPS1::fork(const codeg::Motherboard& parent)
 {
-    if (val)
+    codeg::Motherboard::fork(parent);
+
+    const auto* board = dynamic_cast<const codeg::GCM_5_1_SPS1*>(&parent);
+    if (board == nullptr)
     {
-        this->peripheralUpdateAll(this->_processor._busses.get(CG_PROC_SPS1_BUS_BPCS).get(), *this, this->_processor._busses, this->_processor._signals);
+        throw codeg::Error("fork: the motherboard type doesn't match");
     }
+
+    codeg::CopySnapshotState(board->_processor, this->_processor);
+
+    if (board->_processor._alu)
+    {//The ALU can't be created, it must already be plugged
+        if (!this->_processor._alu)
+        {
+            throw codeg::Error("fork: no ALU to copy into");
+        }
+        codeg::CopySnapshotState(*board->_processor._alu, *this->_processor._alu);
+    }
+
+    this->_processor.forkMemorySlots(board->_processor);
+
+    //Release the replaced memory modules kept by the cache
+    this->g_instructionCache.clear();
 }
-void GCM_5_1_SPS1::signal_SELECTING_RBEXT1([[maybe_unused]] bool val)
+
+std::string GCM_5_1_SPS1::getType() const
 {
-    if (val)
-    {
-        this->_processor._busses.get(CG_PROC_SPS1_BUS_NUMBER) = this->_processor._busses.get(CG_PROC_SPS1_BUS_BWRITE1);
-    }
+    return "GCM_5_1_SPS1";
 }
-void GCM_5_1_SPS1::signal_SELECTING_RBEXT2([[maybe_unused]] bool val)
+
+void GCM_5_1_SPS1::setClockFrequency(double frequency)
 {
-    if (val)
+    if ( !(frequency > 0.0) )
     {
-        this->_processor._busses.get(CG_PROC_SPS1_BUS_NUMBER) = this->_processor._busses.get(CG_PROC_SPS1_BUS_BWRITE2);
+        throw codeg::Error("the clock frequency must be positive");
     }
+    this->g_clockFrequency = frequency;
+}
+double GCM_5_1_SPS1::getClockFrequency() const
+{
+    return this->g_clockFrequency;
+}
+double GCM_5_1_SPS1::getSimulatedTime() const
+{
+    return static_cast<double>(this->_processor.getPhaseCount()) / this->g_clockFrequency;
+}
+
+void GCM_5_1_SPS1::signal_ADDSRC_CLK()
+{
+    this->setProgramCounter( this->_g_programCounter+1 );
+}
+void GCM_5_1_SPS1::signal_JMPSRC_CLK()
+{
+    this->setProgramCounter(this->_processor._busses.get(codeg::BUS_SPS1_BJMPSRC).get());
+}
+void GCM_5_1_SPS1::signal_PERIPHERAL_CLK()
+{
+    this->peripheralUpdateAll(this->_processor._busses.get(codeg::BUS_SPS1_BPCS).get(), *this, this->_processor._busses, this->_processor._signals);
+}
+void GCM_5_1_SPS1::signal_SELECTING_RBEXT1()
+{
+    this->_processor._busses.get(codeg::BUS_SPS1_NUMBER) = this->_processor._busses.get(codeg::BUS_SPS1_BWRITE1);
+}
+void GCM_5_1_SPS1::signal_SELECTING_RBEXT2()
+{
+    this->_processor._busses.get(codeg::BUS_SPS1_NUMBER) = this->_processor._busses.get(codeg::BUS_SPS1_BWRITE2);
 }
 
 ///MemoryController
@@ -111,11 +213,14 @@ void MemoryController::update(codeg::Motherboard& motherboard, codeg::BusMap& bu
 {
     if ( this->isSelected() )
     {
-        uint8_t bwrite1 = busses.get(CG_PROC_SPS1_BUS_BWRITE1).get();
-        uint8_t bwrite2 = busses.get(CG_PROC_SPS1_BUS_BWRITE2).get();
+        uint8_t bwrite1 = busses.get(codeg::BUS_SPS1_BWRITE1).get();
+        uint8_t bwrite2 = busses.get(codeg::BUS_SPS1_BWRITE2).get();
 
-        if (signals.get(CG_PROC_SPS1_SIGNAL_PERIPHERAL_CLK).getValue())
+        if (signals.get(codeg::SIGNAL_SPS1_PERIPHERAL_CLK).getValue())
         {
+            const uint32_t lastAddress = this->g_address;
+            const bool lastFlags[4] = {this->g_writeFlag, this->g_addressClock0Flag, this->g_addressClock1Flag, this->g_addressClock2Flag};
+
             if (bwrite1 & CG_PERIPHERAL_MEMORY_CONTROLLER_ADDRESS0_MASK)
             {
                 if (!this->g_addressClock0Flag)
@@ -164,10 +269,11 @@ void MemoryController::update(codeg::Motherboard& motherboard, codeg::BusMap& bu
                         (bwrite1&CG_PERIPHERAL_MEMORY_CONTROLLER_OE_MASK) )
                     {
                         std::size_t index = 1-motherboard.getMemorySourceIndex();
-                        std::shared_ptr<codeg::MemoryModule> mem = motherboard.getMemorySlot(index)->_mem;
-                        if (mem)
+                        const codeg::MemoryModuleSlot* slot = motherboard.getMemorySlot(index);
+                        if (slot->_mem)
                         {
-                            mem->set(this->g_address, bwrite2);
+                            slot->write(this->g_address, bwrite2);
+                            motherboard.reportMemoryAccess(index, this->g_address, true);
                         }
                     }
                 }
@@ -176,28 +282,35 @@ void MemoryController::update(codeg::Motherboard& motherboard, codeg::BusMap& bu
             {
                 this->g_writeFlag = false;
             }
+
+            if ( (lastAddress != this->g_address) ||
+                 (lastFlags[0] != this->g_writeFlag) || (lastFlags[1] != this->g_addressClock0Flag) ||
+                 (lastFlags[2] != this->g_addressClock1Flag) || (lastFlags[3] != this->g_addressClock2Flag) )
+            {//Writing to the memory is tracked by the memory module
+                ++this->_g_changeCount;
+            }
         }
 
         if ((bwrite1&CG_PERIPHERAL_MEMORY_CONTROLLER_CE_MASK) &&
             !(bwrite1&CG_PERIPHERAL_MEMORY_CONTROLLER_OE_MASK) )
         {
             std::size_t index = 1-motherboard.getMemorySourceIndex();
-            std::shared_ptr<codeg::MemoryModule> mem = motherboard.getMemorySlot(index)->_mem;
-            if (mem)
+            const codeg::MemoryModuleSlot* slot = motherboard.getMemorySlot(index);
+            if (slot->_mem)
             {
-                uint8_t data = 0;
-                mem->get(this->g_address, data);
+                const uint8_t data = slot->read(this->g_address);
+                motherboard.reportMemoryAccess(index, this->g_address, false);
 
-                busses.get(CG_PROC_SPS1_BUS_BREAD1).set(data);
+                busses.get(codeg::BUS_SPS1_BREAD1).set(data);
             }
             else
             {
-                busses.get(CG_PROC_SPS1_BUS_BREAD1).set(0);
+                busses.get(codeg::BUS_SPS1_BREAD1).set(0);
             }
         }
         else
         {
-            busses.get(CG_PROC_SPS1_BUS_BREAD1).set(0);
+            busses.get(codeg::BUS_SPS1_BREAD1).set(0);
         }
     }
 }
@@ -207,15 +320,38 @@ codeg::PeripheralType MemoryController::getType() const
     return codeg::PeripheralType::TYPE_HARDWARE;
 }
 
+bool MemoryController::isChangeTracked() const
+{
+    return true;
+}
+
+void MemoryController::saveState(codeg::SnapshotWriter& writer) const
+{
+    writer.write(this->g_writeFlag);
+    writer.write(this->g_addressClock0Flag);
+    writer.write(this->g_addressClock1Flag);
+    writer.write(this->g_addressClock2Flag);
+    writer.write(this->g_address);
+}
+void MemoryController::loadState(codeg::SnapshotReader& reader)
+{
+    reader.read(this->g_writeFlag);
+    reader.read(this->g_addressClock0Flag);
+    reader.read(this->g_addressClock1Flag);
+    reader.read(this->g_addressClock2Flag);
+    reader.read(this->g_address);
+    ++this->_g_changeCount;
+}
+
 ///MemorySourceSwitch
 
 void MemorySourceSwitch::update(codeg::Motherboard& motherboard, codeg::BusMap& busses, codeg::SignalMap& signals)
 {
     if ( this->isSelected() )
     {
-        uint8_t bwrite1 = busses.get(CG_PROC_SPS1_BUS_BWRITE1).get();
+        uint8_t bwrite1 = busses.get(codeg::BUS_SPS1_BWRITE1).get();
 
-        if (signals.get(CG_PROC_SPS1_SIGNAL_PERIPHERAL_CLK).getValue())
+        if (signals.get(codeg::SIGNAL_SPS1_PERIPHERAL_CLK).getValue())
         {
             if (bwrite1 & CG_PERIPHERAL_MEMORY_SOURCESWITCH_MASK)
             {
@@ -235,4 +371,9 @@ codeg::PeripheralType MemorySourceSwitch::getType() const
     return codeg::PeripheralType::TYPE_HARDWARE;
 }
 
+bool MemorySourceSwitch::isChangeTracked() const
+{//No internal state, the memory source and the program counter are part of the motherboard state
+    return true;
+}
+
 }//end codeg
@@ -15,6 +15,10 @@
 /////////////////////////////////////////////////////////////////////////////////
 
 #include "motherboard/motherboards.hpp"
+#include "C_snapshot.hpp"
+#include "C_console.hpp"
+#include "memoryModule/C_ROM1.hpp"
+#include <mutex>
 #include <unordered_map>
 
 namespace codeg
@@ -24,11 +28,138 @@ namespace
 {
 
 std::unordered_map<std::string, std::unique_ptr<MotherboardClassTypeBase> > gData;
+std::mutex gDataMutex;
 
 }//end
 
+///Motherboard
+
+bool Motherboard::saveSnapshot(const std::filesystem::path& path) const
+{
+    codeg::SnapshotWriter writer;
+
+    this->saveState(writer);
+
+    writer.beginSection(codeg::SNAPSHOT_TAG_END);
+    writer.endSection();
+
+    return writer.saveToFile(path);
+}
+void Motherboard::loadSnapshot(const std::filesystem::path& path)
+{
+    //Memory images are copied directly from the mapped file
+    const auto content = codeg::MapSnapshotFile(path);
+    this->loadSnapshotData(content->getData(), content->getSize());
+}
+void Motherboard::loadSnapshotData(const uint8_t* data, std::size_t size)
+{
+    codeg::SnapshotReader reader(data, size);
+
+    this->loadState(reader);
+
+    reader.openSection(codeg::SNAPSHOT_TAG_END);
+    reader.closeSection();
+}
+
+void Motherboard::saveState(codeg::SnapshotWriter& writer) const
+{
+    writer.beginSection(codeg::SNAPSHOT_TAG_MOTHERBOARD);
+    writer.writeString(this->getType());
+    writer.write<uint64_t>(this->_g_programCounter);
+    writer.endSection();
+
+    writer.beginSection(codeg::SNAPSHOT_TAG_MEMORY);
+    this->saveMemorySlots(writer);
+    writer.endSection();
+
+    writer.beginSection(codeg::SNAPSHOT_TAG_PERIPHERAL);
+    writer.write<uint64_t>(this->_g_peripheralSlots.size());
+    for (const auto& slot : this->_g_peripheralSlots)
+    {
+        writer.write<uint8_t>(slot._peripheral ? 1 : 0);
+        if (slot._peripheral)
+        {
+            writer.write(slot._peripheral->isSelected());
+            slot._peripheral->saveState(writer);
+        }
+    }
+    writer.endSection();
+}
+void Motherboard::loadState(codeg::SnapshotReader& reader)
+{
+    reader.openSection(codeg::SNAPSHOT_TAG_MOTHERBOARD);
+    if (reader.readString() != this->getType())
+    {
+        throw codeg::Error("snapshot: the motherboard type doesn't match");
+    }
+    this->_g_programCounter = reader.read<uint64_t>();
+    reader.closeSection();
+
+    reader.openSection(codeg::SNAPSHOT_TAG_MEMORY);
+    this->loadMemorySlots(reader);
+    reader.closeSection();
+
+    //Peripherals can't be created, the same ones must already be plugged
+    reader.openSection(codeg::SNAPSHOT_TAG_PERIPHERAL);
+    if (reader.read<uint64_t>() != this->_g_peripheralSlots.size())
+    {
+        throw codeg::Error("snapshot: the peripheral slot count doesn't match");
+    }
+    for (std::size_t i=0; i<this->_g_peripheralSlots.size(); ++i)
+    {
+        const auto& peripheral = this->_g_peripheralSlots[i]._peripheral;
+        if ( (reader.read<uint8_t>() != 0) != static_cast<bool>(peripheral) )
+        {
+            throw codeg::Error("snapshot: the peripheral slot "+std::to_string(i)+" doesn't match");
+        }
+        if (peripheral)
+        {
+            peripheral->select(reader.read<bool>());
+            peripheral->loadState(reader);
+        }
+    }
+    reader.closeSection();
+}
+
+codeg::Console& Motherboard::getConsole() const
+{
+    return (this->g_console != nullptr) ? *this->g_console : *codeg::varConsole;
+}
+
+void Motherboard::fork(const codeg::Motherboard& parent)
+{
+    if (parent.getType() != this->getType())
+    {
+        throw codeg::Error("fork: the motherboard type doesn't match");
+    }
+    this->_g_programCounter = parent._g_programCounter;
+
+    this->forkMemorySlots(parent);
+
+    if (parent._g_peripheralSlots.size() != this->_g_peripheralSlots.size())
+    {
+        throw codeg::Error("fork: the peripheral slot count doesn't match");
+    }
+    for (std::size_t i=0; i<this->_g_peripheralSlots.size(); ++i)
+    {
+        const auto& parentPeripheral = parent._g_peripheralSlots[i]._peripheral;
+        const auto& peripheral = this->_g_peripheralSlots[i]._peripheral;
+        if ( static_cast<bool>(parentPeripheral) != static_cast<bool>(peripheral) )
+        {
+            throw codeg::Error("fork: the peripheral slot "+std::to_string(i)+" doesn't match");
+        }
+        if (peripheral)
+        {
+            peripheral->select(parentPeripheral->isSelected());
+            codeg::CopySnapshotState(*parentPeripheral, *peripheral);
+        }
+    }
+}
+
 void RegisterNewMotherboardType(std::unique_ptr<MotherboardClassTypeBase>&& classType)
 {
+    std::scoped_lock<std::mutex> lock(gDataMutex);
+
     auto it = gData.find(classType->getType());
     if (it == gData.end())
     {
@@ -38,6 +169,8 @@ void RegisterNewMotherboardType(std::unique_ptr<MotherboardClassTypeBase>&& clas
 }
 Motherboard* GetNewMotherboard(const std::string& type)
 {
+    std::scoped_lock<std::mutex> lock(gDataMutex);
+
     auto it = gData.find(type);
     if (it != gData.end())
     {
@@ -47,6 +180,8 @@ Motherboard* GetNewMotherboard(const std::string& type)
 }
 std::size_t GetMotherboardTypeSize()
 {
+    std::scoped_lock<std::mutex> lock(gDataMutex);
+
     return gData.size();
 }
 
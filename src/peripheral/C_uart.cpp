@@ -15,47 +15,60 @@
 /////////////////////////////////////////////////////////////////////////////////
 
 #include "peripheral/C_uart.hpp"
+#include "motherboard/motherboards.hpp"
 #include "processor/C_GP8B_5_1.hpp"
 #include "C_console.hpp"
 #include "C_string.hpp"
+#include "C_snapshot.hpp"
 
 namespace codeg
 {
 
-void UART_peripheral_card_A_1_1::update([[maybe_unused]] codeg::Motherboard& motherboard, codeg::BusMap& busses, codeg::SignalMap& signals)
+void UART_peripheral_card_A_1_1::update(codeg::Motherboard& motherboard, codeg::BusMap& busses, codeg::SignalMap& signals)
 {
     if ( this->isSelected() )
     {
-        uint8_t bwrite1 = busses.get(CG_PROC_SPS1_BUS_BWRITE1).get();
-        uint8_t bwrite2 = busses.get(CG_PROC_SPS1_BUS_BWRITE2).get();
+        uint8_t bwrite1 = busses.get(codeg::BUS_SPS1_BWRITE1).get();
+        uint8_t bwrite2 = busses.get(codeg::BUS_SPS1_BWRITE2).get();
 
-        if ( signals.get(CG_PROC_SPS1_SIGNAL_PERIPHERAL_CLK).getValue() )
+        if ( signals.get(codeg::SIGNAL_SPS1_PERIPHERAL_CLK).getValue() )
         {
             if (bwrite2 & CG_PERIPHERAL_UART_RST_RX_FLAG_MASK)
             {
                 if (this->g_inputBuffer.empty())
                 {
+                    this->_g_changeCount += this->g_rxFlag ? 1 : 0;
                     this->g_rxFlag = false;
                 }
                 else
                 {
                     this->g_inputBuffer.erase(0, 1);
                     this->g_rxFlag = !this->g_inputBuffer.empty();
+                    ++this->_g_changeCount;
                 }
             }
             if (bwrite2 & CG_PERIPHERAL_UART_RST_TX_FLAG_MASK)
             {
+                this->_g_changeCount += this->g_txFlag ? 1 : 0;
                 this->g_txFlag = false;
             }
             if (bwrite2 & CG_PERIPHERAL_UART_APPLY_TX_DATA_MASK)
             {
+                this->_g_changeCount += (this->g_txData != bwrite1) ? 1 : 0;
                 this->g_txData = bwrite1;
             }
             if (bwrite2 & CG_PERIPHERAL_UART_TRANSMIT_MASK)
             {
+                ++this->_g_changeCount;
+
+                if (this->g_outputStream != nullptr)
+                {
+                    this->g_outputStream->put( static_cast<char>(this->g_txData) );
+                }
+
                 if ( static_cast<char>(this->g_txData) == '\n' )
                 {
-                    ConsoleInfo << "uart: receiving \""<< codeg::ReplaceNonPrintableAsciiChar(this->g_outputBuffer) <<"\"" << std::endl;
+                    motherboard.getConsole() << codeg::ConsoleOutputType::OUTPUT_INFO << "uart: receiving \""<< codeg::ReplaceNonPrintableAsciiChar(this->g_outputBuffer) <<"\"" << std::endl;
                     this->g_outputBuffer.clear();
                 }
                 else
@@ -63,7 +76,7 @@ void UART_peripheral_card_A_1_1::update([[maybe_unused]] codeg::Motherboard& mot
                     this->g_outputBuffer.push_back( static_cast<char>(this->g_txData) );
                     if (this->g_outputBuffer.size() >= 20)
                     {
-                        ConsoleInfo << "uart: (overflow) receiving \""<< codeg::ReplaceNonPrintableAsciiChar(this->g_outputBuffer) <<"\"" << std::endl;
+                        motherboard.getConsole() << codeg::ConsoleOutputType::OUTPUT_INFO << "uart: (overflow) receiving \""<< codeg::ReplaceNonPrintableAsciiChar(this->g_outputBuffer) <<"\"" << std::endl;
                         this->g_outputBuffer.clear();
                     }
                 }
@@ -74,14 +87,14 @@ void UART_peripheral_card_A_1_1::update([[maybe_unused]] codeg::Motherboard& mot
 
         if (this->g_inputBuffer.empty())
         {
-            busses.get(CG_PROC_SPS1_BUS_BREAD1).set(0);
+            busses.get(codeg::BUS_SPS1_BREAD1).set(0);
         }
         else
         {
-            busses.get(CG_PROC_SPS1_BUS_BREAD1).set( this->g_inputBuffer.front() );
+            busses.get(codeg::BUS_SPS1_BREAD1).set( this->g_inputBuffer.front() );
         }
 
-        busses.get(CG_PROC_SPS1_BUS_BREAD2).set((this->g_rxFlag ? 0x01 : 0x00) | (this->g_txFlag ? 0x02 : 0x00));
+        busses.get(codeg::BUS_SPS1_BREAD2).set((this->g_rxFlag ? 0x01 : 0x00) | (this->g_txFlag ? 0x02 : 0x00));
     }
 }
 
@@ -90,6 +103,11 @@ codeg::PeripheralType UART_peripheral_card_A_1_1::getType() const
     return codeg::PeripheralType::TYPE_PP1;
 }
 
+bool UART_peripheral_card_A_1_1::isChangeTracked() const
+{
+    return true;
+}
+
 const std::string& UART_peripheral_card_A_1_1::getInputBuffer() const
 {
     return this->g_inputBuffer;
@@ -98,15 +116,40 @@ void UART_peripheral_card_A_1_1::setInputBuffer(std::string input)
 {
     this->g_inputBuffer = std::move(input);
     this->g_rxFlag = !this->g_inputBuffer.empty();
+    ++this->_g_changeCount;
 }
 
 void UART_peripheral_card_A_1_1::clearOutputBuffer()
 {
     this->g_outputBuffer.clear();
+    ++this->_g_changeCount;
 }
 const std::string& UART_peripheral_card_A_1_1::getOutputBuffer() const
 {
     return this->g_outputBuffer;
 }
 
+void UART_peripheral_card_A_1_1::setOutputStream(std::ostream* stream)
+{
+    this->g_outputStream = stream;
+}
+
+void UART_peripheral_card_A_1_1::saveState(codeg::SnapshotWriter& writer) const
+{
+    writer.writeString(this->g_inputBuffer);
+    writer.writeString(this->g_outputBuffer);
+    writer.write(this->g_txData);
+    writer.write(this->g_rxFlag);
+    writer.write(this->g_txFlag);
+}
+void UART_peripheral_card_A_1_1::loadState(codeg::SnapshotReader& reader)
+{
+    this->g_inputBuffer = reader.readString();
+    this->g_outputBuffer = reader.readString();
+    reader.read(this->g_txData);
+    reader.read(this->g_rxFlag);
+    reader.read(this->g_txFlag);
+    ++this->_g_changeCount;
+}
+
 }//end codeg
@@ -15,152 +15,257 @@
 /////////////////////////////////////////////////////////////////////////////////
 
 #include "processor/C_ALUminium_1_1.hpp"
+#include "C_snapshot.hpp"
 
 namespace codeg
 {
 
-void Aluminium_1_1::setOperationLeft(uint8_t val)
+namespace
 {
-    switch (static_cast<codeg::AluminiumOperations_1_1>(this->g_operation))
+
+constexpr uint8_t ReverseBits(uint8_t val)
+{
+    uint8_t result = 0;
+    for (uint8_t i=0; i<8; ++i)
     {
-    case ALU_1_1_OP_AOPL:
-    case ALU_1_1_OP_AOPR:
-        this->g_accumulatorLeft = val;
-        break;
-    case ALU_1_1_OP_OPAL:
-    case ALU_1_1_OP_OPAR:
-    default:
-        this->g_operationLeft = val;
-        break;
+        result |= static_cast<uint8_t>(((val>>i)&0x01) << (7-i));
     }
-    this->updateResult();
-}
-void Aluminium_1_1::setOperation(uint8_t val)
-{
-    this->g_operation = val;
-    this->updateResult();
+    return result;
 }
-void Aluminium_1_1::setOperationRight(uint8_t val)
+
+constexpr std::array<uint8_t, 256> MakeReverseTable()
 {
-    switch (static_cast<codeg::AluminiumOperations_1_1>(this->g_operation))
+    std::array<uint8_t, 256> table{};
+    for (std::size_t i=0; i<table.size(); ++i)
     {
-    case ALU_1_1_OP_AOPL:
-    case ALU_1_1_OP_AOPR:
-        this->g_accumulatorRight = val;
-        break;
-    case ALU_1_1_OP_OPAL:
-    case ALU_1_1_OP_OPAR:
-    default:
-        this->g_operationRight = val;
-        break;
+        table[i] = ReverseBits(static_cast<uint8_t>(i));
     }
-    this->updateResult();
+    return table;
 }
 
-void Aluminium_1_1::updateResult()
+constexpr std::array<uint8_t, 256> ReverseTable = MakeReverseTable();
+
+}//end
+
+const char* AluminiumOperationToString(uint8_t operation)
 {
-    switch (static_cast<codeg::AluminiumOperations_1_1>(this->g_operation))
+    switch (operation)
     {
     case ALU_1_1_OP_ADDITION:
-        this->_g_result = this->g_operationLeft + this->g_operationRight;
-        break;
+        return "ADDITION";
     case ALU_1_1_OP_SUBTRACTION:
-        this->_g_result = this->g_operationLeft - this->g_operationRight;
-        break;
+        return "SUBTRACTION";
     case ALU_1_1_OP_AND_BITWISE:
-        this->_g_result = this->g_operationLeft & this->g_operationRight;
-        break;
+        return "AND_BITWISE";
     case ALU_1_1_OP_OR_BITWISE:
-        this->_g_result = this->g_operationLeft | this->g_operationRight;
-        break;
+        return "OR_BITWISE";
     case ALU_1_1_OP_XOR_BITWISE:
-        this->_g_result = this->g_operationLeft ^ this->g_operationRight;
-        break;
+        return "XOR_BITWISE";
     case ALU_1_1_OP_INV_BITWISE:
-        this->_g_result = ~this->g_operationLeft;
-        break;
+        return "INV_BITWISE";
     case ALU_1_1_OP_AND_LOGICAL:
-        this->_g_result = this->g_operationLeft && this->g_operationRight ? 1 : 0;
-        break;
+        return "AND_LOGICAL";
     case ALU_1_1_OP_OR_LOGICAL:
-        this->_g_result = this->g_operationLeft || this->g_operationRight ? 1 : 0;
-        break;
+        return "OR_LOGICAL";
     case ALU_1_1_OP_XOR_LOGICAL:
-        this->_g_result = (this->g_operationLeft>0 ? 1 : 0) ^ (this->g_operationRight>0 ? 1 : 0);
-        break;
+        return "XOR_LOGICAL";
     case ALU_1_1_OP_INV_LOGICAL:
-        this->_g_result = this->g_operationLeft ? 0 : 1;
-        break;
+        return "INV_LOGICAL";
     case ALU_1_1_OP_SHIFT_LEFT:
-        this->_g_result = this->g_operationLeft << this->g_operationRight;
-        break;
+        return "SHIFT_LEFT";
     case ALU_1_1_OP_SHIFT_RIGHT:
-        this->_g_result = this->g_operationLeft >> this->g_operationRight;
-        break;
+        return "SHIFT_RIGHT";
     case ALU_1_1_OP_STRICT_BIGGER:
-        this->_g_result = this->g_operationLeft > this->g_operationRight ? 1 : 0;
-        break;
+        return "STRICT_BIGGER";
     case ALU_1_1_OP_STRICT_SMALLER:
-        this->_g_result = this->g_operationLeft < this->g_operationRight ? 1 : 0;
-        break;
+        return "STRICT_SMALLER";
     case ALU_1_1_OP_BIGGER:
-        this->_g_result = this->g_operationLeft >= this->g_operationRight ? 1 : 0;
-        break;
+        return "BIGGER";
     case ALU_1_1_OP_SMALLER:
-        this->_g_result = this->g_operationLeft <= this->g_operationRight ? 1 : 0;
-        break;
+        return "SMALLER";
     case ALU_1_1_OP_EQUAL:
-        this->_g_result = this->g_operationLeft == this->g_operationRight ? 1 : 0;
-        break;
+        return "EQUAL";
     case ALU_1_1_OP_MULTIPLICATION:
-        this->_g_result = this->g_operationLeft * this->g_operationRight;
-        break;
+        return "MULTIPLICATION";
     case ALU_1_1_OP_2COMPLEMENT:
-        this->_g_result = (~this->g_operationLeft)+1;
-        break;
+        return "2COMPLEMENT";
     case ALU_1_1_OP_ROTATE:
-    {
-        uint32_t x = this->g_operationLeft;
-        x = ((x & 0x55555555) << 1) | ((x & 0xAAAAAAAA) >> 1);
-        x = ((x & 0x33333333) << 2) | ((x & 0xCCCCCCCC) >> 2);
-        x = ((x & 0x0F0F0F0F) << 4) | ((x & 0xF0F0F0F0) >> 4);
-        x = ((x & 0x00FF00FF) << 8) | ((x & 0xFF00FF00) >> 8);
-        x = ((x & 0x0000FFFF) << 16) | ((x & 0xFFFF0000) >> 16);
-        this->_g_result = x >> (32 - 8);
-    }
-        break;
+        return "ROTATE";
     case ALU_1_1_OP_ROTATE_LEFT:
-        this->_g_result = this->g_operationLeft;
-
-        for (uint8_t i=0; i<this->g_operationRight; ++i)
-        {
-            this->_g_result = ((this->_g_result & 0x80) ? 0x01 : 0x00) | (this->_g_result << 1);
-        }
-        break;
+        return "ROTATE_LEFT";
     case ALU_1_1_OP_ROTATE_RIGHT:
-        this->_g_result = this->g_operationLeft;
-
-        for (uint8_t i=0; i<this->g_operationRight; ++i)
-        {
-            this->_g_result = ((this->_g_result & 0x01) ? 0x80 : 0x00) | (this->_g_result >> 1);
-        }
-        break;
+        return "ROTATE_RIGHT";
     case ALU_1_1_OP_AOPL:
-        this->_g_result = this->g_operationLeft;
-        break;
+        return "AOPL";
     case ALU_1_1_OP_AOPR:
-        this->_g_result = this->g_operationRight;
-        break;
+        return "AOPR";
     case ALU_1_1_OP_OPAL:
-        this->_g_result = this->g_accumulatorLeft;
-        break;
+        return "OPAL";
     case ALU_1_1_OP_OPAR:
-        this->_g_result = this->g_accumulatorRight;
-        break;
+        return "OPAR";
     default:
-        this->_g_result = 0x00;
-        break;
+        return "UNKNOWN";
+    }
+}
+
+Aluminium_1_1::Aluminium_1_1() :
+        g_kernel(getKernels()[ALU_1_1_OP_ADDITION])
+{
+}
+
+void Aluminium_1_1::setOperation(uint8_t val)
+{
+    this->g_operation = val;
+    this->g_writeAccumulator = (val == ALU_1_1_OP_AOPL) || (val == ALU_1_1_OP_AOPR);
+    this->g_kernel = getKernels()[val];
+    this->g_dirty = true;
+}
+
+void Aluminium_1_1::saveState(codeg::SnapshotWriter& writer) const
+{//The result is deduced from the other registers
+    writer.write(this->g_accumulatorLeft);
+    writer.write(this->g_accumulatorRight);
+    writer.write(this->g_operationLeft);
+    writer.write(this->g_operationRight);
+    writer.write(this->g_operation);
+}
+void Aluminium_1_1::loadState(codeg::SnapshotReader& reader)
+{
+    reader.read(this->g_accumulatorLeft);
+    reader.read(this->g_accumulatorRight);
+    reader.read(this->g_operationLeft);
+    reader.read(this->g_operationRight);
+    this->setOperation(reader.read<uint8_t>());
+}
+
+template<uint8_t TOperation>
+uint8_t Aluminium_1_1::kernel(const codeg::Aluminium_1_1& alu)
+{
+    const unsigned int left = alu.g_operationLeft;
+    const unsigned int right = alu.g_operationRight;
+
+    if constexpr (TOperation == ALU_1_1_OP_ADDITION)
+    {
+        return static_cast<uint8_t>(left + right);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_SUBTRACTION)
+    {
+        return static_cast<uint8_t>(left - right);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_AND_BITWISE)
+    {
+        return static_cast<uint8_t>(left & right);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_OR_BITWISE)
+    {
+        return static_cast<uint8_t>(left | right);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_XOR_BITWISE)
+    {
+        return static_cast<uint8_t>(left ^ right);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_INV_BITWISE)
+    {
+        return static_cast<uint8_t>(~left);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_AND_LOGICAL)
+    {
+        return static_cast<uint8_t>((left != 0) & (right != 0));
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_OR_LOGICAL)
+    {
+        return static_cast<uint8_t>((left != 0) | (right != 0));
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_XOR_LOGICAL)
+    {
+        return static_cast<uint8_t>((left != 0) ^ (right != 0));
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_INV_LOGICAL)
+    {
+        return static_cast<uint8_t>(left == 0);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_SHIFT_LEFT)
+    {//Shifting by 8 or more always give 0
+        return (right < 8) ? static_cast<uint8_t>(left << right) : 0;
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_SHIFT_RIGHT)
+    {
+        return (right < 8) ? static_cast<uint8_t>(left >> right) : 0;
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_STRICT_BIGGER)
+    {
+        return static_cast<uint8_t>(left > right);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_STRICT_SMALLER)
+    {
+        return static_cast<uint8_t>(left < right);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_BIGGER)
+    {
+        return static_cast<uint8_t>(left >= right);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_SMALLER)
+    {
+        return static_cast<uint8_t>(left <= right);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_EQUAL)
+    {
+        return static_cast<uint8_t>(left == right);
     }
+    else if constexpr (TOperation == ALU_1_1_OP_MULTIPLICATION)
+    {
+        return static_cast<uint8_t>(left * right);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_2COMPLEMENT)
+    {
+        return static_cast<uint8_t>(~left + 1);
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_ROTATE)
+    {//Bits order is reversed
+        return ReverseTable[left];
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_ROTATE_LEFT)
+    {
+        const unsigned int count = right & 0x07;
+        return static_cast<uint8_t>((left << count) | (left >> ((8-count) & 0x07)));
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_ROTATE_RIGHT)
+    {
+        const unsigned int count = right & 0x07;
+        return static_cast<uint8_t>((left >> count) | (left << ((8-count) & 0x07)));
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_AOPL)
+    {
+        return alu.g_operationLeft;
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_AOPR)
+    {
+        return alu.g_operationRight;
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_OPAL)
+    {
+        return alu.g_accumulatorLeft;
+    }
+    else if constexpr (TOperation == ALU_1_1_OP_OPAR)
+    {
+        return alu.g_accumulatorRight;
+    }
+    else
+    {//Unknown operation
+        return 0x00;
+    }
+}
+
+template<std::size_t... TIndex>
+constexpr std::array<Aluminium_1_1::Kernel, 256> Aluminium_1_1::makeKernelTable([[maybe_unused]] std::index_sequence<TIndex...> indexes)
+{
+    return {{&Aluminium_1_1::kernel<static_cast<uint8_t>(TIndex)>...}};
+}
+
+const std::array<Aluminium_1_1::Kernel, 256>& Aluminium_1_1::getKernels()
+{
+    static constexpr std::array<Kernel, 256> kernels = makeKernelTable(std::make_index_sequence<256>{});
+    return kernels;
 }
 
 }//end codeg
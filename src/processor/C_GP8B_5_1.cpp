@@ -16,6 +16,7 @@
 
 #include "processor/C_GP8B_5_1.hpp"
 #include "C_codeg.hpp"
+#include "C_snapshot.hpp"
 
 namespace codeg
 {
@@ -27,28 +28,29 @@ GP8B_5_1::GP8B_5_1()
 
 void GP8B_5_1::clock()
 {
+    ++this->g_phaseCount;
+
     switch (this->g_stat)
     {
     case Stats::STAT_SYNC_BIT:
         this->g_stat = Stats::STAT_INSTRUCTION_SET;
         break;
     case Stats::STAT_INSTRUCTION_SET:
-        this->g_instruction = this->_busses.get(CG_PROC_SPS1_BUS_BDATASRC).get();
-        this->_signals.get(CG_PROC_SPS1_SIGNAL_ADDSRC_CLK).call(true);
-        this->_signals.get(CG_PROC_SPS1_SIGNAL_ADDSRC_CLK).call(false);
+        this->g_instruction = this->_busses.get(codeg::BUS_SPS1_BDATASRC).get();
+        this->_signals.get(codeg::SIGNAL_SPS1_ADDSRC_CLK).pulse();
         this->computeArgument();
 
         this->g_stat = Stats::STAT_EXECUTION;
         break;
     case Stats::STAT_EXECUTION:
         this->executeInstruction();
+        this->g_phaseCount += getInstructionPhases(this->g_instruction, this->g_arguments) - CG_GP8B_5_1_INSTRUCTION_PHASES;
 
         if ( static_cast<codeg::CodegBinaryRev1>(this->g_instruction&CG_CODEGBINARYREV1_OPCODE_MASK) != codeg::CodegBinaryRev1::OPCODE_JMPSRC_CLK )
         {//The jump instruction inhibit a clock to the next address
             if ( static_cast<codeg::CodegBinaryRev1Busses>(this->g_instruction&CG_CODEGBINARYREV1_BUSSES_MASK) == codeg::CodegBinaryRev1Busses::READABLE_SOURCE)
             {//There is no argument if the selected bus is not source !
-                this->_signals.get(CG_PROC_SPS1_SIGNAL_ADDSRC_CLK).call(true);
-                this->_signals.get(CG_PROC_SPS1_SIGNAL_ADDSRC_CLK).call(false);
+                this->_signals.get(codeg::SIGNAL_SPS1_ADDSRC_CLK).pulse();
             }
         }
 
@@ -71,18 +73,73 @@ bool GP8B_5_1::isSync() const
     return this->g_stat == Stats::STAT_SYNC_BIT;
 }
 
+void GP8B_5_1::saveState(codeg::SnapshotWriter& writer) const
+{//Signals are only high during a pulse, they don't have a state
+    writer.write<uint64_t>(this->_busses.getSize());
+    for (const auto& bus : this->_busses)
+    {
+        writer.write<uint64_t>(bus.second.get());
+    }
+
+    writer.write(static_cast<uint8_t>(this->g_stat));
+    writer.write(this->g_instruction);
+    writer.write(this->g_arguments);
+    writer.write(this->g_ramAddress);
+    writer.write(this->g_phaseCount);
+}
+void GP8B_5_1::loadState(codeg::SnapshotReader& reader)
+{
+    if (reader.read<uint64_t>() != this->_busses.getSize())
+    {
+        throw codeg::Error("snapshot: the bus count doesn't match");
+    }
+    for (codeg::BusIndex i=0; i<this->_busses.getSize(); ++i)
+    {
+        this->_busses.get(i).set(reader.read<uint64_t>());
+    }
+
+    const auto stat = reader.read<uint8_t>();
+    if (stat > static_cast<uint8_t>(Stats::STAT_EXECUTION))
+    {
+        throw codeg::Error("snapshot: bad processor state");
+    }
+    this->g_stat = static_cast<Stats>(stat);
+    reader.read(this->g_instruction);
+    reader.read(this->g_arguments);
+    reader.read(this->g_ramAddress);
+    reader.read(this->g_phaseCount);
+}
+
+void GP8B_5_1::executeDecoded(const codeg::DecodedInstruction& decoded)
+{
+    this->g_instruction = decoded._instruction;
+
+    if (decoded._bus == codeg::CodegBinaryRev1Busses::READABLE_SOURCE)
+    {
+        this->g_arguments = decoded._immediate;
+        this->_busses.get(codeg::BUS_SPS1_NUMBER).set(this->g_arguments);
+    }
+    else
+    {
+        this->computeArgument();
+    }
+
+    this->g_phaseCount += getInstructionPhases(decoded._instruction, this->g_arguments);
+    this->executeInstruction();
+}
+
 void GP8B_5_1::executeInstruction()
 {
     switch( static_cast<codeg::CodegBinaryRev1>(this->g_instruction&CG_CODEGBINARYREV1_OPCODE_MASK) )
     {
     case CodegBinaryRev1::OPCODE_BWRITE1_CLK:
-        this->_busses.get(CG_PROC_SPS1_BUS_BWRITE1).set(this->g_arguments);
+        this->_busses.get(codeg::BUS_SPS1_BWRITE1).set(this->g_arguments);
         break;
     case CodegBinaryRev1::OPCODE_BWRITE2_CLK:
-        this->_busses.get(CG_PROC_SPS1_BUS_BWRITE2).set(this->g_arguments);
+        this->_busses.get(codeg::BUS_SPS1_BWRITE2).set(this->g_arguments);
         break;
     case CodegBinaryRev1::OPCODE_BPCS_CLK:
-        this->_busses.get(CG_PROC_SPS1_BUS_BPCS).set(this->g_arguments);
+        this->_busses.get(codeg::BUS_SPS1_BPCS).set(this->g_arguments);
         break;
     case CodegBinaryRev1::OPCODE_OPLEFT_CLK:
         this->_alu->setOperationLeft(this->g_arguments);
@@ -94,36 +151,34 @@ void GP8B_5_1::executeInstruction()
         this->_alu->setOperation(this->g_arguments);
         break;
     case CodegBinaryRev1::OPCODE_PERIPHERAL_CLK:
-        this->_signals.get(CG_PROC_SPS1_SIGNAL_PERIPHERAL_CLK).call(true);
-        this->_signals.get(CG_PROC_SPS1_SIGNAL_PERIPHERAL_CLK).call(false);
+        this->_signals.get(codeg::SIGNAL_SPS1_PERIPHERAL_CLK).pulse();
         break;
     case CodegBinaryRev1::OPCODE_BJMPSRC1_CLK:
     {
-        uint32_t x = this->_busses.get(CG_PROC_SPS1_BUS_BJMPSRC).get();
+        uint32_t x = this->_busses.get(codeg::BUS_SPS1_BJMPSRC).get();
         x &=~ 0x000000FF;
         x |= static_cast<uint32_t>(this->g_arguments);
-        this->_busses.get(CG_PROC_SPS1_BUS_BJMPSRC).set(x);
+        this->_busses.get(codeg::BUS_SPS1_BJMPSRC).set(x);
     }
         break;
     case CodegBinaryRev1::OPCODE_BJMPSRC2_CLK:
     {
-        uint32_t x = this->_busses.get(CG_PROC_SPS1_BUS_BJMPSRC).get();
+        uint32_t x = this->_busses.get(codeg::BUS_SPS1_BJMPSRC).get();
         x &=~ 0x0000FF00;
         x |= static_cast<uint32_t>(this->g_arguments)<<8;
-        this->_busses.get(CG_PROC_SPS1_BUS_BJMPSRC).set(x);
+        this->_busses.get(codeg::BUS_SPS1_BJMPSRC).set(x);
     }
         break;
     case CodegBinaryRev1::OPCODE_BJMPSRC3_CLK:
     {
-        uint32_t x = this->_busses.get(CG_PROC_SPS1_BUS_BJMPSRC).get();
+        uint32_t x = this->_busses.get(codeg::BUS_SPS1_BJMPSRC).get();
         x &=~ 0x00FF0000;
         x |= static_cast<uint32_t>(this->g_arguments)<<16;
-        this->_busses.get(CG_PROC_SPS1_BUS_BJMPSRC).set(x);
+        this->_busses.get(codeg::BUS_SPS1_BJMPSRC).set(x);
     }
         break;
     case CodegBinaryRev1::OPCODE_JMPSRC_CLK:
-        this->_signals.get(CG_PROC_SPS1_SIGNAL_JMPSRC_CLK).call(true);
-        this->_signals.get(CG_PROC_SPS1_SIGNAL_JMPSRC_CLK).call(false);
+        this->_signals.get(codeg::SIGNAL_SPS1_JMPSRC_CLK).pulse();
         break;
     case CodegBinaryRev1::OPCODE_BRAMADD1_CLK:
         this->g_ramAddress &=~ 0x00FF;
@@ -136,22 +191,17 @@ void GP8B_5_1::executeInstruction()
     case CodegBinaryRev1::OPCODE_IF:
         if (this->g_arguments)
         {
-            this->_signals.get(CG_PROC_SPS1_SIGNAL_ADDSRC_CLK).call(true);
-            this->_signals.get(CG_PROC_SPS1_SIGNAL_ADDSRC_CLK).call(false);
+            this->_signals.get(codeg::SIGNAL_SPS1_ADDSRC_CLK).pulse();
         }
         break;
     case CodegBinaryRev1::OPCODE_IFNOT:
         if (!this->g_arguments)
         {
-            this->_signals.get(CG_PROC_SPS1_SIGNAL_ADDSRC_CLK).call(true);
-            this->_signals.get(CG_PROC_SPS1_SIGNAL_ADDSRC_CLK).call(false);
+            this->_signals.get(codeg::SIGNAL_SPS1_ADDSRC_CLK).pulse();
         }
         break;
     case CodegBinaryRev1::OPCODE_RAMW:
-        if ( this->getMemorySlot(0)->_mem )
-        {
-            this->getMemorySlot(0)->_mem->set(this->g_ramAddress, this->g_arguments);
-        }
+        this->_g_memorySlots[0].write(this->g_ramAddress, this->g_arguments);
         break;
     case CodegBinaryRev1::OPCODE_SPI_CLK:
     case CodegBinaryRev1::OPCODE_BCFG_SPI_CLK:
@@ -166,49 +216,37 @@ void GP8B_5_1::computeArgument()
     switch( static_cast<codeg::CodegBinaryRev1Busses>(this->g_instruction&CG_CODEGBINARYREV1_BUSSES_MASK) )
     {
     case CodegBinaryRev1Busses::READABLE_SOURCE:
-        this->g_arguments = this->_busses.get(CG_PROC_SPS1_BUS_BDATASRC).get();
+        this->g_arguments = this->_busses.get(codeg::BUS_SPS1_BDATASRC).get();
         break;
     case CodegBinaryRev1Busses::READABLE_BREAD1:
-        this->g_arguments = this->_busses.get(CG_PROC_SPS1_BUS_BREAD1).get();
+        this->g_arguments = this->_busses.get(codeg::BUS_SPS1_BREAD1).get();
         break;
     case CodegBinaryRev1Busses::READABLE_BREAD2:
-        this->g_arguments = this->_busses.get(CG_PROC_SPS1_BUS_BREAD2).get();
+        this->g_arguments = this->_busses.get(codeg::BUS_SPS1_BREAD2).get();
         break;
     case CodegBinaryRev1Busses::READABLE_RESULT:
         this->g_arguments = this->_alu->getResult();
         break;
     case CodegBinaryRev1Busses::READABLE_RAM:
-        if (this->getMemorySlot(0)->_mem)
-        {
-            if ( !this->getMemorySlot(0)->_mem->get(this->g_ramAddress, this->g_arguments) )
-            {
-                this->g_arguments = 0;
-            }
-        }
-        else
-        {
-            this->g_arguments = 0;
-        }
+        this->g_arguments = this->_g_memorySlots[0].read(this->g_ramAddress);
         break;
     case CodegBinaryRev1Busses::READABLE_SPI:
         this->g_arguments = 0; ///TODO: implement an spi emulation
         break;
     case CodegBinaryRev1Busses::READABLE_EXT1:
-        this->_signals.get(CG_PROC_SPS1_SIGNAL_SELECTING_RBEXT1).call(true);
-        this->_signals.get(CG_PROC_SPS1_SIGNAL_SELECTING_RBEXT1).call(false);
-        this->g_arguments = this->_busses.get(CG_PROC_SPS1_BUS_NUMBER).get();
+        this->_signals.get(codeg::SIGNAL_SPS1_SELECTING_RBEXT1).pulse();
+        this->g_arguments = this->_busses.get(codeg::BUS_SPS1_NUMBER).get();
         break;
     case CodegBinaryRev1Busses::READABLE_EXT2:
-        this->_signals.get(CG_PROC_SPS1_SIGNAL_SELECTING_RBEXT2).call(true);
-        this->_signals.get(CG_PROC_SPS1_SIGNAL_SELECTING_RBEXT2).call(false);
-        this->g_arguments = this->_busses.get(CG_PROC_SPS1_BUS_NUMBER).get();
+        this->_signals.get(codeg::SIGNAL_SPS1_SELECTING_RBEXT2).pulse();
+        this->g_arguments = this->_busses.get(codeg::BUS_SPS1_NUMBER).get();
         break;
     default:
         this->g_arguments = 0;
         break;
     }
 
-    this->_busses.get(CG_PROC_SPS1_BUS_NUMBER).set(this->g_arguments);
+    this->_busses.get(codeg::BUS_SPS1_NUMBER).set(this->g_arguments);
 }
 
 }//end codeg
@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "processor/C_instructionCache.hpp"
+#include "C_string.hpp"
+
+namespace codeg
+{
+
+codeg::DecodedInstruction DecodeInstruction(const codeg::MemoryModule& memory, codeg::MemoryAddress address)
+{
+    codeg::DecodedInstruction decoded;
+
+    //An out of range read give 0, like the motherboard data source
+    memory.get(address, decoded._instruction);
+
+    decoded._opcode = static_cast<codeg::CodegBinaryRev1>(decoded._instruction&CG_CODEGBINARYREV1_OPCODE_MASK);
+    decoded._bus = static_cast<codeg::CodegBinaryRev1Busses>(decoded._instruction&CG_CODEGBINARYREV1_BUSSES_MASK);
+    decoded._nextAddress = address+1;
+
+    if (decoded._bus == codeg::CodegBinaryRev1Busses::READABLE_SOURCE)
+    {//The argument is the next byte
+        memory.get(address+1, decoded._immediate);
+        decoded._nextAddress = address+2;
+    }
+
+    decoded._valid = true;
+    return decoded;
+}
+
+std::string DisassembleInstruction(const codeg::DecodedInstruction& decoded)
+{
+    std::string result = "[" + codeg::ValueToHex(decoded._instruction, 2) + "] " +
+                         codeg::OpcodeToString(decoded._opcode) + " <" + codeg::BusToString(decoded._bus) + ">";
+    if (decoded._bus == codeg::CodegBinaryRev1Busses::READABLE_SOURCE)
+    {
+        result += " [" + codeg::ValueToHex(decoded._immediate, 2) + "]";
+    }
+    return result;
+}
+
+const codeg::DecodedInstruction& InstructionCache::get(const std::shared_ptr<codeg::MemoryModule>& memory, codeg::MemoryAddress address)
+{
+    if ( (memory.get() != this->g_memory.get()) || (memory->getModificationCount() != this->g_modificationCount) )
+    {
+        this->clear();
+        this->g_memory = memory;
+        this->g_modificationCount = memory->getModificationCount();
+        this->g_pages.resize( (memory->getMemorySize()+CG_INSTRUCTIONCACHE_PAGE_SIZE-1) / CG_INSTRUCTIONCACHE_PAGE_SIZE );
+    }
+
+    std::size_t pageIndex = address / CG_INSTRUCTIONCACHE_PAGE_SIZE;
+    if (pageIndex >= this->g_pages.size())
+    {
+        this->g_outOfRange = codeg::DecodeInstruction(*memory, address);
+        return this->g_outOfRange;
+    }
+
+    std::unique_ptr<Page>& page = this->g_pages[pageIndex];
+    if (!page)
+    {
+        page = std::make_unique<Page>();
+    }
+
+    codeg::DecodedInstruction& decoded = (*page)[address % CG_INSTRUCTIONCACHE_PAGE_SIZE];
+    if (!decoded._valid)
+    {
+        decoded = codeg::DecodeInstruction(*memory, address);
+    }
+    return decoded;
+}
+
+void InstructionCache::clear()
+{
+    this->g_pages.clear();
+    this->g_memory.reset();
+    this->g_modificationCount = 0;
+}
+
+}//end codeg
@@ -0,0 +1,257 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include <iostream>
+#include "processor/C_ALUminium_1_1.hpp"
+
+//Exhaustive check of Aluminium_1_1 against the previous switch based implementation
+
+namespace
+{
+
+//The previous implementation, the result is computed on every write
+class ReferenceAlu
+{
+public:
+    void setOperationLeft(uint8_t val)
+    {
+        if (this->isAccumulatorWrite())
+        {
+            this->g_accumulatorLeft = val;
+        }
+        else
+        {
+            this->g_operationLeft = val;
+        }
+        this->updateResult();
+    }
+    void setOperation(uint8_t val)
+    {
+        this->g_operation = val;
+        this->updateResult();
+    }
+    void setOperationRight(uint8_t val)
+    {
+        if (this->isAccumulatorWrite())
+        {
+            this->g_accumulatorRight = val;
+        }
+        else
+        {
+            this->g_operationRight = val;
+        }
+        this->updateResult();
+    }
+
+    [[nodiscard]] uint8_t getResult() const
+    {
+        return this->g_result;
+    }
+
+private:
+    [[nodiscard]] bool isAccumulatorWrite() const
+    {
+        return (this->g_operation == codeg::ALU_1_1_OP_AOPL) || (this->g_operation == codeg::ALU_1_1_OP_AOPR);
+    }
+
+    void updateResult()
+    {
+        const uint8_t left = this->g_operationLeft;
+        const uint8_t right = this->g_operationRight;
+
+        switch (this->g_operation)
+        {
+        case codeg::ALU_1_1_OP_ADDITION:
+            this->g_result = left + right;
+            break;
+        case codeg::ALU_1_1_OP_SUBTRACTION:
+            this->g_result = left - right;
+            break;
+        case codeg::ALU_1_1_OP_AND_BITWISE:
+            this->g_result = left & right;
+            break;
+        case codeg::ALU_1_1_OP_OR_BITWISE:
+            this->g_result = left | right;
+            break;
+        case codeg::ALU_1_1_OP_XOR_BITWISE:
+            this->g_result = left ^ right;
+            break;
+        case codeg::ALU_1_1_OP_INV_BITWISE:
+            this->g_result = ~left;
+            break;
+        case codeg::ALU_1_1_OP_AND_LOGICAL:
+            this->g_result = left && right ? 1 : 0;
+            break;
+        case codeg::ALU_1_1_OP_OR_LOGICAL:
+            this->g_result = left || right ? 1 : 0;
+            break;
+        case codeg::ALU_1_1_OP_XOR_LOGICAL:
+            this->g_result = (left>0 ? 1 : 0) ^ (right>0 ? 1 : 0);
+            break;
+        case codeg::ALU_1_1_OP_INV_LOGICAL:
+            this->g_result = left ? 0 : 1;
+            break;
+        case codeg::ALU_1_1_OP_SHIFT_LEFT:
+            //The previous implementation was undefined for 32 and more, shifting 8 or more is now defined as 0
+            this->g_result = (right < 8) ? (left << right) : 0;
+            break;
+        case codeg::ALU_1_1_OP_SHIFT_RIGHT:
+            this->g_result = (right < 8) ? (left >> right) : 0;
+            break;
+        case codeg::ALU_1_1_OP_STRICT_BIGGER:
+            this->g_result = left > right ? 1 : 0;
+            break;
+        case codeg::ALU_1_1_OP_STRICT_SMALLER:
+            this->g_result = left < right ? 1 : 0;
+            break;
+        case codeg::ALU_1_1_OP_BIGGER:
+            this->g_result = left >= right ? 1 : 0;
+            break;
+        case codeg::ALU_1_1_OP_SMALLER:
+            this->g_result = left <= right ? 1 : 0;
+            break;
+        case codeg::ALU_1_1_OP_EQUAL:
+            this->g_result = left == right ? 1 : 0;
+            break;
+        case codeg::ALU_1_1_OP_MULTIPLICATION:
+            this->g_result = left * right;
+            break;
+        case codeg::ALU_1_1_OP_2COMPLEMENT:
+            this->g_result = (~left)+1;
+            break;
+        case codeg::ALU_1_1_OP_ROTATE:
+        {
+            uint32_t x = left;
+            x = ((x & 0x55555555) << 1) | ((x & 0xAAAAAAAA) >> 1);
+            x = ((x & 0x33333333) << 2) | ((x & 0xCCCCCCCC) >> 2);
+            x = ((x & 0x0F0F0F0F) << 4) | ((x & 0xF0F0F0F0) >> 4);
+            x = ((x & 0x00FF00FF) << 8) | ((x & 0xFF00FF00) >> 8);
+            x = ((x & 0x0000FFFF) << 16) | ((x & 0xFFFF0000) >> 16);
+            this->g_result = x >> (32 - 8);
+        }
+            break;
+        case codeg::ALU_1_1_OP_ROTATE_LEFT:
+            this->g_result = left;
+            for (uint8_t i=0; i<right; ++i)
+            {
+                this->g_result = ((this->g_result & 0x80) ? 0x01 : 0x00) | (this->g_result << 1);
+            }
+            break;
+        case codeg::ALU_1_1_OP_ROTATE_RIGHT:
+            this->g_result = left;
+            for (uint8_t i=0; i<right; ++i)
+            {
+                this->g_result = ((this->g_result & 0x01) ? 0x80 : 0x00) | (this->g_result >> 1);
+            }
+            break;
+        case codeg::ALU_1_1_OP_AOPL:
+            this->g_result = left;
+            break;
+        case codeg::ALU_1_1_OP_AOPR:
+            this->g_result = right;
+            break;
+        case codeg::ALU_1_1_OP_OPAL:
+            this->g_result = this->g_accumulatorLeft;
+            break;
+        case codeg::ALU_1_1_OP_OPAR:
+            this->g_result = this->g_accumulatorRight;
+            break;
+        default:
+            this->g_result = 0x00;
+            break;
+        }
+    }
+
+    uint8_t g_accumulatorLeft{0};
+    uint8_t g_accumulatorRight{0};
+    uint8_t g_operationLeft{0};
+    uint8_t g_operationRight{0};
+    uint8_t g_operation{0};
+    uint8_t g_result{0};
+};
+
+std::size_t errorCount = 0;
+
+void Check(const codeg::Aluminium_1_1& alu, const ReferenceAlu& reference, const char* step, unsigned int operation, unsigned int a, unsigned int b)
+{
+    const uint8_t result = alu.getResult();
+    if ( (result != reference.getResult()) && (++errorCount <= 20) )
+    {
+        std::cout << "mismatch after " << step << " : " << codeg::AluminiumOperationToString(static_cast<uint8_t>(operation))
+                  << " (" << operation << ") a=" << a << " b=" << b << " result=" << static_cast<unsigned int>(result)
+                  << " expected=" << static_cast<unsigned int>(reference.getResult()) << std::endl;
+    }
+}
+
+}//end
+
+int main()
+{
+    codeg::Aluminium_1_1 alu;
+    ReferenceAlu reference;
+
+    //Every operation with every operands, the result is read after each write like the processor can do
+    for (unsigned int operation=0; operation<256; ++operation)
+    {
+        for (unsigned int a=0; a<256; ++a)
+        {
+            for (unsigned int b=0; b<256; ++b)
+            {
+                alu.setOperation(static_cast<uint8_t>(operation));
+                reference.setOperation(static_cast<uint8_t>(operation));
+                Check(alu, reference, "operation", operation, a, b);
+
+                alu.setOperationLeft(static_cast<uint8_t>(a));
+                reference.setOperationLeft(static_cast<uint8_t>(a));
+                alu.setOperationRight(static_cast<uint8_t>(b));
+                reference.setOperationRight(static_cast<uint8_t>(b));
+                Check(alu, reference, "operands", operation, a, b);
+            }
+        }
+    }
+
+    //Every accumulator values, written with AOPL/AOPR and read back with OPAL/OPAR
+    for (unsigned int a=0; a<256; ++a)
+    {
+        for (unsigned int b=0; b<256; ++b)
+        {
+            const unsigned int writeOperation = ((a+b)&0x01) ? codeg::ALU_1_1_OP_AOPL : codeg::ALU_1_1_OP_AOPR;
+            alu.setOperation(static_cast<uint8_t>(writeOperation));
+            reference.setOperation(static_cast<uint8_t>(writeOperation));
+            alu.setOperationLeft(static_cast<uint8_t>(a));
+            reference.setOperationLeft(static_cast<uint8_t>(a));
+            alu.setOperationRight(static_cast<uint8_t>(b));
+            reference.setOperationRight(static_cast<uint8_t>(b));
+            Check(alu, reference, "accumulator write", writeOperation, a, b);
+
+            for (unsigned int readOperation : {codeg::ALU_1_1_OP_OPAL, codeg::ALU_1_1_OP_OPAR, codeg::ALU_1_1_OP_ADDITION})
+            {
+                alu.setOperation(static_cast<uint8_t>(readOperation));
+                reference.setOperation(static_cast<uint8_t>(readOperation));
+                Check(alu, reference, "accumulator read", readOperation, a, b);
+            }
+        }
+    }
+
+    if (errorCount != 0)
+    {
+        std::cout << errorCount << " mismatches" << std::endl;
+        return 1;
+    }
+    std::cout << "no mismatch" << std::endl;
+    return 0;
+}
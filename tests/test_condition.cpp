@@ -0,0 +1,218 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include "engine/C_breakpoints.hpp"
+#include "engine/C_condition.hpp"
+#include "engine/C_engine.hpp"
+#include "memoryModule/C_MM1.hpp"
+#include "motherboard/C_GCM_5_1.hpp"
+#include "processor/C_ALUminium_1_1.hpp"
+
+//Parser and evaluator checks of the breakpoint conditions
+
+namespace
+{
+
+std::size_t errorCount = 0;
+
+void Fail(const std::string& expression, const std::string& message)
+{
+    ++errorCount;
+    std::cout << "\"" << expression << "\" : " << message << std::endl;
+}
+
+void CheckValue(const codeg::GP8B_5_1& processor, const std::string& expression, bool expected, codeg::MemoryAddress pc=0)
+{
+    try
+    {
+        const codeg::Condition condition(expression);
+        if (condition.evaluate(processor, pc) != expected)
+        {
+            Fail(expression, expected ? "expected true" : "expected false");
+        }
+    }
+    catch (const codeg::Error& e)
+    {
+        Fail(expression, std::string{"unexpected error "} + e.what());
+    }
+}
+
+void CheckError(const std::string& expression)
+{
+    try
+    {
+        const codeg::Condition condition(expression);
+        Fail(expression, "expected an error");
+    }
+    catch (const codeg::Error&)
+    {
+    }
+}
+
+void CheckTrigger(const std::string& expression, codeg::ConditionTrigger trigger, uint32_t value, bool ramOnly)
+{
+    const codeg::Condition condition(expression);
+    if ( (condition.getTrigger() != trigger) ||
+         ((trigger != codeg::ConditionTrigger::TRIGGER_EVERY_INSTRUCTION) && (condition.getTriggerValue() != value)) )
+    {
+        Fail(expression, "bad trigger");
+    }
+    if (condition.isRamOnly() != ramOnly)
+    {
+        Fail(expression, ramOnly ? "expected RAM only" : "expected not RAM only");
+    }
+}
+
+//Every engine must stop on the same instruction, even the ones that keep the program counter local during a run
+void CheckEngines(const std::string& expression, std::size_t expectedCount, codeg::MemoryAddress expectedPc)
+{
+    const char* engines[] = {"clock", "cached", "threaded", "static", "block", "native"};
+
+    for (const char* engineType : engines)
+    {
+        //0x20 everywhere and 0x21 at the address 10
+        auto memory = std::make_shared<codeg::MM1_64k>();
+        for (codeg::MemoryAddress i=0; i<64; ++i)
+        {
+            memory->set(i, (i == 10) ? 0x21 : 0x20);
+        }
+
+        codeg::GCM_5_1_SPS1 board;
+        board._processor._alu = std::make_shared<codeg::Aluminium_1_1>();
+        board._processor.memoryPlug(0, std::make_shared<codeg::MM1_16k>());
+        board.memoryPlug(0, memory);
+        board.updateDataSource();
+
+        codeg::BreakpointSet breakpoints;
+        breakpoints.addCondition(expression);
+        codeg::StopConditions conditions;
+        conditions._breakpoints = &breakpoints;
+
+        const codeg::RunResult result = codeg::CreateExecutionEngine(engineType, board)->run(50, conditions);
+        if ( (result._reason != codeg::StopReason::STOP_BREAKPOINT) || (result._instructionCount != expectedCount) ||
+             (board.getProgramCounter() != expectedPc) )
+        {
+            Fail(expression, std::string{engineType}+" engine stopped after "+std::to_string(result._instructionCount)+
+                             " instructions at "+std::to_string(board.getProgramCounter()));
+        }
+    }
+}
+
+}//end
+
+int main()
+{
+    codeg::GP8B_5_1 processor;
+    auto ram = std::make_shared<codeg::MM1_16k>();
+    processor.memoryPlug(0, ram);
+
+    ram->set(0x0000, 7);
+    ram->set(0x0001, 5);
+    processor.setRamAddress(0x0001);
+    processor._busses.get(codeg::BUS_SPS1_BREAD2).set(0x02);
+    processor._busses.get(codeg::BUS_SPS1_BJMPSRC).set(0x0001);
+
+    //Numbers, a leading 0 is decimal
+    CheckValue(processor, "010 == 10", true);
+    CheckValue(processor, "010 == 8", false);
+    CheckValue(processor, "08 == 8", true);
+    CheckValue(processor, "0x10 == 16", true);
+    CheckValue(processor, "0X1f == 31", true);
+    CheckValue(processor, "18446744073709551615 == ~0", true);
+    CheckError("0x");
+    CheckError("12abc");
+    CheckError("0x1G");
+    CheckError("18446744073709551616");
+
+    //Operators and precedence
+    CheckValue(processor, "1 + 2 == 3 && 4 > 3", true);
+    CheckValue(processor, "1 | 2 == 2", true); //"|" is lower than "=="
+    CheckValue(processor, "(1 | 2) == 2", false);
+    CheckValue(processor, "!0 && ~0 != 0 && -1 == ~0", true);
+    CheckValue(processor, "3 - 1 - 1 == 1", true);
+    CheckValue(processor, "0 || 0", false);
+    CheckError("1 +");
+    CheckError("(1");
+    CheckError("1 == 1)");
+    CheckError("UNKNOWN == 1");
+
+    //Operands
+    CheckValue(processor, "PC == 0x40", true, 0x40);
+    CheckValue(processor, "PC == 0x40", false, 0x41);
+    CheckValue(processor, "BREAD2 & 0x02", true);
+    CheckValue(processor, "RAM[0x0001] > 3", true);
+    CheckValue(processor, "RAM[RAMADDRESS] == 5", true);
+    CheckValue(processor, "PC == 0x40 && BREAD2 & 0x02 && RAM[0x0001] > 3", true, 0x40);
+
+    //RAM addresses are 16 bits, a dynamic address out of range read 0 (no wrap to RAM[0])
+    CheckError("RAM[0x10000] == 0");
+    CheckValue(processor, "RAM[BJMPSRC + 0xFFFF] == 0", true);
+    CheckValue(processor, "RAM[BJMPSRC - 1] == 7", true);
+
+    //Nesting
+    CheckValue(processor, std::string(32, '(') + "1" + std::string(32, ')'), true);
+    CheckError(std::string(100000, '(') + "1" + std::string(100000, ')'));
+    CheckError(std::string(100000, '!') + "1");
+    CheckError("RAM[" + std::string(100, '(') + "1" + std::string(100, ')') + "]");
+    //Stack size
+    std::string deep = "PC";
+    for (std::size_t i=0; i<CG_CONDITION_STACK_SIZE; ++i)
+    {
+        deep = "PC + (" + deep + ")";
+    }
+    CheckError(deep);
+
+    //Triggers
+    CheckTrigger("PC == 0x40 && BREAD2", codeg::ConditionTrigger::TRIGGER_PROGRAM_COUNTER, 0x40, false);
+    CheckTrigger("OPCODE == RAMW", codeg::ConditionTrigger::TRIGGER_OPCODE, 0x12, false);
+    CheckTrigger("RAM[1] == 5", codeg::ConditionTrigger::TRIGGER_OPCODE, 0x12, true);
+    CheckTrigger("RAM[RAMADDRESS] == 5", codeg::ConditionTrigger::TRIGGER_EVERY_INSTRUCTION, 0, false);
+    CheckTrigger("BREAD2 == 1", codeg::ConditionTrigger::TRIGGER_EVERY_INSTRUCTION, 0, false);
+
+    //A RAM only condition already true when added stop once
+    codeg::BreakpointSet breakpoints;
+    breakpoints.addCondition("RAM[1] == 6");
+    if ( breakpoints.checkNewConditions(0, processor) )
+    {
+        Fail("RAM[1] == 6", "a false new condition stopped");
+    }
+    const std::size_t index = breakpoints.addCondition("RAM[1] == 5");
+    if ( !breakpoints.checkNewConditions(0, processor) || (breakpoints.getLastCondition() != index) )
+    {
+        Fail("RAM[1] == 5", "a true new condition didn't stop");
+    }
+    if ( breakpoints.checkNewConditions(0, processor) )
+    {
+        Fail("RAM[1] == 5", "a new condition stopped twice");
+    }
+
+    //BDATASRC is the source memory at the program counter
+    CheckEngines("BDATASRC == 0x21", 10, 10);
+    CheckEngines("PC == 10 && BDATASRC == 0x21", 10, 10);
+    CheckEngines("OPCODE == 0 && BDATASRC == 0x21", 10, 10);
+
+    if (errorCount != 0)
+    {
+        std::cout << errorCount << " errors" << std::endl;
+        return 1;
+    }
+    std::cout << "no error" << std::endl;
+    return 0;
+}
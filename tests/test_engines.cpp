@@ -0,0 +1,148 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "C_console.hpp"
+#include "C_snapshot.hpp"
+#include "engine/C_engine.hpp"
+#include "memoryModule/C_MM1.hpp"
+#include "motherboard/C_GCM_5_1.hpp"
+#include "peripheral/C_uart.hpp"
+#include "processor/C_ALUminium_1_1.hpp"
+
+//Every engine must stop in the same state as the clock engine (the processor model) on random programs
+
+#define TEST_PROGRAM_COUNT 64
+#define TEST_MAX_PROGRAM_SIZE 2048
+#define TEST_MAX_INSTRUCTIONS 100000
+#define TEST_MAX_RUN_SIZE 5000
+
+namespace
+{
+
+std::size_t errorCount = 0;
+
+void Fail(std::size_t program, const std::string& engine, const std::string& message)
+{
+    ++errorCount;
+    std::cout << "program " << program << " (" << engine << ") : " << message << std::endl;
+}
+
+std::unique_ptr<codeg::GCM_5_1_SPS1> NewBoard(codeg::Console& console, std::vector<uint8_t>& program)
+{
+    auto board = std::make_unique<codeg::GCM_5_1_SPS1>();
+    board->setConsole(&console);
+    board->_processor._alu = std::make_shared<codeg::Aluminium_1_1>();
+    board->_processor.memoryPlug(0, std::make_shared<codeg::MM1_16k>());
+
+    auto memory = std::make_shared<codeg::MM1_64k>();
+    memory->set(0, program.data(), program.size());
+    board->memoryPlug(0, memory);
+    board->memoryPlug(1, std::make_shared<codeg::MM1_16k>());
+    board->peripheralPlug(0, std::make_shared<codeg::UART_peripheral_card_A_1_1>());
+    board->updateDataSource();
+    return board;
+}
+
+std::vector<uint8_t> SaveState(const codeg::Motherboard& board)
+{
+    codeg::SnapshotWriter writer;
+    board.saveState(writer);
+    return writer.takeData();
+}
+
+}//end
+
+int main()
+{
+    codeg::Console console;
+    codeg::Console boardConsole(console, "board: ");
+
+    //The opcodes are often kept in the valid range and there is a lot of jumps to get hot blocks
+    std::mt19937 random(25);
+    const char* engines[] = {"cached", "threaded", "static", "block", "native"};
+
+    for (std::size_t i=0; i<TEST_PROGRAM_COUNT; ++i)
+    {
+        std::vector<uint8_t> program(256 + random()%TEST_MAX_PROGRAM_SIZE);
+        for (auto& data : program)
+        {
+            data = static_cast<uint8_t>(random());
+            if (random()%3 != 0)
+            {
+                data &= 0x1F;
+            }
+            if (random()%7 == 0)
+            {
+                data = static_cast<uint8_t>(codeg::CodegBinaryRev1::OPCODE_JMPSRC_CLK) |
+                       static_cast<uint8_t>(codeg::CodegBinaryRev1Busses::READABLE_BREAD1);
+            }
+        }
+        const std::size_t maxInstructions = 1 + random()%TEST_MAX_INSTRUCTIONS;
+        const std::size_t runSize = 1 + random()%TEST_MAX_RUN_SIZE;
+
+        auto reference = NewBoard(boardConsole, program);
+        auto referenceEngine = codeg::CreateExecutionEngine("clock", *reference);
+
+        std::vector<std::unique_ptr<codeg::GCM_5_1_SPS1> > boards;
+        std::vector<std::unique_ptr<codeg::ExecutionEngine> > boardEngines;
+        for (const char* engineType : engines)
+        {
+            boards.push_back(NewBoard(boardConsole, program));
+            boardEngines.push_back(codeg::CreateExecutionEngine(engineType, *boards.back()));
+        }
+
+        //Many runs, so the engines also stop in the middle of the blocks
+        for (std::size_t count=0; count<maxInstructions; count+=runSize)
+        {
+            const std::size_t budget = std::min(runSize, maxInstructions-count);
+            const std::size_t referenceCount = referenceEngine->run(budget);
+            const std::vector<uint8_t> referenceState = SaveState(*reference);
+
+            bool failed = false;
+            for (std::size_t e=0; e<boards.size(); ++e)
+            {
+                if (boardEngines[e]->run(budget) != referenceCount)
+                {
+                    Fail(i, engines[e], "bad instruction count after "+std::to_string(count)+" instructions");
+                    failed = true;
+                }
+                else if (SaveState(*boards[e]) != referenceState)
+                {
+                    Fail(i, engines[e], "the state doesn't match after "+std::to_string(count+budget)+" instructions");
+                    failed = true;
+                }
+            }
+            if (failed)
+            {
+                break;
+            }
+        }
+    }
+
+    if (errorCount != 0)
+    {
+        std::cout << errorCount << " errors" << std::endl;
+        return 1;
+    }
+    std::cout << "no error" << std::endl;
+    return 0;
+}
@@ -0,0 +1,170 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "C_console.hpp"
+#include "C_snapshot.hpp"
+#include "engine/C_boardExecutor.hpp"
+#include "engine/C_breakpoints.hpp"
+#include "memoryModule/C_MM1.hpp"
+#include "motherboard/C_GCM_5_1.hpp"
+#include "peripheral/C_uart.hpp"
+#include "processor/C_ALUminium_1_1.hpp"
+
+//Forked boards executed in parallel by the BoardExecutor must end like the same forks executed one after the other
+
+#define TEST_BOARD_COUNT 24
+#define TEST_PROGRAM_SIZE 512
+#define TEST_MAX_INSTRUCTIONS 200000
+
+namespace
+{
+
+std::size_t errorCount = 0;
+
+void Fail(std::size_t board, const std::string& message)
+{
+    ++errorCount;
+    std::cout << "board " << board << " : " << message << std::endl;
+}
+
+//Empty board with the same hardware as the simulator, ready to be forked into
+std::unique_ptr<codeg::GCM_5_1_SPS1> NewBoard(codeg::Console& console)
+{
+    auto board = std::make_unique<codeg::GCM_5_1_SPS1>();
+    board->setConsole(&console);
+    board->_processor._alu = std::make_shared<codeg::Aluminium_1_1>();
+    board->peripheralPlug(0, std::make_shared<codeg::UART_peripheral_card_A_1_1>());
+    return board;
+}
+
+std::vector<uint8_t> SaveState(const codeg::Motherboard& board)
+{
+    codeg::SnapshotWriter writer;
+    board.saveState(writer);
+    return writer.takeData();
+}
+
+}//end
+
+int main()
+{
+    codeg::Console console;
+    codeg::Console boardConsole(console, "board: ");
+
+    //Random programs, the opcodes are often kept in the valid range
+    std::mt19937 random(14);
+    const char* engines[] = {"threaded", "block", "static", "cached", "clock", "native"};
+
+    std::vector<std::unique_ptr<codeg::GCM_5_1_SPS1> > parallelBoards;
+    std::vector<std::unique_ptr<codeg::GCM_5_1_SPS1> > serialBoards;
+    std::vector<std::unique_ptr<codeg::ExecutionEngine> > parallelEngines;
+    std::vector<codeg::BreakpointSet> parallelBreakpoints(TEST_BOARD_COUNT);
+
+    codeg::BoardExecutor executor(4, 1000);
+    std::vector<codeg::RunResult> serialResults;
+
+    for (std::size_t i=0; i<TEST_BOARD_COUNT; ++i)
+    {
+        std::vector<uint8_t> program(TEST_PROGRAM_SIZE);
+        for (auto& data : program)
+        {
+            data = static_cast<uint8_t>(random());
+            if (random()%4 == 0)
+            {
+                data &= 0x1F;
+            }
+        }
+
+        auto parent = NewBoard(boardConsole);
+        auto memory = std::make_shared<codeg::MM1_64k>();
+        memory->set(0, program.data(), program.size());
+        parent->memoryPlug(0, memory);
+        parent->_processor.memoryPlug(0, std::make_shared<codeg::MM1_16k>());
+        parent->updateDataSource();
+
+        parallelBoards.push_back(NewBoard(boardConsole));
+        parallelBoards.back()->fork(*parent);
+        serialBoards.push_back(NewBoard(boardConsole));
+        serialBoards.back()->fork(*parent);
+
+        const char* engineType = engines[i%6];
+
+        codeg::StopConditions conditions;
+        codeg::BreakpointSet serialBreakpoints;
+        if (i%3 == 0)
+        {//A breakpoint on an address reached by the program
+            auto scratchBoard = NewBoard(boardConsole);
+            scratchBoard->fork(*parent);
+            codeg::CreateExecutionEngine(engineType, *scratchBoard)->run(1 + random()%(TEST_MAX_INSTRUCTIONS/2));
+
+            parallelBreakpoints[i].addBreakpoint(scratchBoard->getProgramCounter());
+            serialBreakpoints = parallelBreakpoints[i];
+        }
+
+        parallelEngines.push_back(codeg::CreateExecutionEngine(engineType, *parallelBoards.back()));
+        conditions._breakpoints = (i%3 == 0) ? &parallelBreakpoints[i] : nullptr;
+        executor.addJob(*parallelEngines.back(), TEST_MAX_INSTRUCTIONS, conditions);
+
+        auto serialEngine = codeg::CreateExecutionEngine(engineType, *serialBoards.back());
+        conditions._breakpoints = (i%3 == 0) ? &serialBreakpoints : nullptr;
+        serialResults.push_back(serialEngine->run(TEST_MAX_INSTRUCTIONS, conditions));
+    }
+
+    executor.run();
+
+    for (std::size_t i=0; i<TEST_BOARD_COUNT; ++i)
+    {
+        const codeg::RunResult& result = executor.getJob(i)._result;
+        if ( (result._instructionCount != serialResults[i]._instructionCount) || (result._reason != serialResults[i]._reason) )
+        {
+            Fail(i, "the run result doesn't match ("+std::to_string(result._instructionCount)+" instructions, "+
+                    std::to_string(serialResults[i]._instructionCount)+" expected)");
+        }
+        if ( SaveState(*parallelBoards[i]) != SaveState(*serialBoards[i]) )
+        {
+            Fail(i, "the state doesn't match");
+        }
+    }
+
+    uint64_t instructionCount = 0;
+    for (const auto& statistics : executor.getStatistics())
+    {
+        instructionCount += statistics._instructionCount;
+    }
+    uint64_t expectedInstructionCount = 0;
+    for (const auto& result : serialResults)
+    {
+        expectedInstructionCount += result._instructionCount;
+    }
+    if (instructionCount != expectedInstructionCount)
+    {
+        Fail(0, "the worker statistics don't match the executed instructions");
+    }
+
+    if (errorCount != 0)
+    {
+        std::cout << errorCount << " errors" << std::endl;
+        return 1;
+    }
+    std::cout << "no error" << std::endl;
+    return 0;
+}
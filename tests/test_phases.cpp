@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Copyright 2022 Guillaume Guillet                                            //
+//                                                                             //
+// Licensed under the Apache License, Version 2.0 (the "License");             //
+// you may not use this file except in compliance with the License.            //
+// You may obtain a copy of the License at                                     //
+//                                                                             //
+//     http://www.apache.org/licenses/LICENSE-2.0                              //
+//                                                                             //
+// Unless required by applicable law or agreed to in writing, software         //
+// distributed under the License is distributed on an "AS IS" BASIS,           //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    //
+// See the License for the specific language governing permissions and         //
+// limitations under the License.                                              //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "engine/C_engine.hpp"
+#include "memoryModule/C_MM1.hpp"
+#include "motherboard/C_GCM_5_1.hpp"
+#include "processor/C_ALUminium_1_1.hpp"
+
+//Every engine must charge the same clock phases as the real processor, a taken IF/IFNOT skip cost one more ADDSRC_CLK
+
+#define TEST_LOOP_COUNT 200
+
+namespace
+{
+
+std::size_t errorCount = 0;
+
+void Fail(const std::string& test, const std::string& engine, const std::string& message)
+{
+    ++errorCount;
+    std::cout << test << " (" << engine << ") : " << message << std::endl;
+}
+
+/*
+ * A loop starting by a conditional skip :
+ *  0x0000 IF/IFNOT argument  (2 bytes, 4 phases + 1 when the skip is taken)
+ *  0x0002 BWRITE1_CLK BREAD1 (1 byte, 3 phases, skipped when the skip is taken)
+ *  0x0003 BJMPSRC1_CLK 0     (2 bytes, 4 phases)
+ *  0x0005 BJMPSRC2_CLK 0     (2 bytes, 4 phases)
+ *  0x0007 BJMPSRC3_CLK 0     (2 bytes, 4 phases)
+ *  0x0009 JMPSRC_CLK BREAD1  (1 byte, 3 phases)
+ */
+void CheckSkip(codeg::CodegBinaryRev1 opcode, uint8_t argument, bool taken)
+{
+    const std::string test = std::string{(opcode == codeg::CodegBinaryRev1::OPCODE_IF) ? "IF " : "IFNOT "} + std::to_string(argument);
+    std::vector<uint8_t> program{
+        static_cast<uint8_t>(opcode), argument,
+        static_cast<uint8_t>(codeg::CodegBinaryRev1::OPCODE_BWRITE1_CLK) | static_cast<uint8_t>(codeg::CodegBinaryRev1Busses::READABLE_BREAD1),
+        static_cast<uint8_t>(codeg::CodegBinaryRev1::OPCODE_BJMPSRC1_CLK), 0,
+        static_cast<uint8_t>(codeg::CodegBinaryRev1::OPCODE_BJMPSRC2_CLK), 0,
+        static_cast<uint8_t>(codeg::CodegBinaryRev1::OPCODE_BJMPSRC3_CLK), 0,
+        static_cast<uint8_t>(codeg::CodegBinaryRev1::OPCODE_JMPSRC_CLK) | static_cast<uint8_t>(codeg::CodegBinaryRev1Busses::READABLE_BREAD1)
+    };
+
+    const uint64_t skipPhases = 4 + (taken ? 1 : 0);
+    const std::size_t loopInstructions = taken ? 5 : 6;
+    const uint64_t loopPhases = skipPhases + (taken ? 0 : 3) + 3*4 + 3;
+
+    const char* engines[] = {"clock", "cached", "threaded", "static", "block", "native"};
+
+    for (const char* engineType : engines)
+    {
+        auto memory = std::make_shared<codeg::MM1_64k>();
+        memory->set(0, program.data(), program.size());
+
+        codeg::GCM_5_1_SPS1 board;
+        board._processor._alu = std::make_shared<codeg::Aluminium_1_1>();
+        board._processor.memoryPlug(0, std::make_shared<codeg::MM1_16k>());
+        board.memoryPlug(0, memory);
+        board.updateDataSource();
+
+        auto engine = codeg::CreateExecutionEngine(engineType, board);
+
+        //The skip alone
+        uint64_t startPhases = board._processor.getPhaseCount();
+        engine->run(1);
+        if (board._processor.getPhaseCount()-startPhases != skipPhases)
+        {
+            Fail(test, engineType, "the skip took "+std::to_string(board._processor.getPhaseCount()-startPhases)+
+                                   " phases, "+std::to_string(skipPhases)+" expected");
+        }
+        if (board.getProgramCounter() != (taken ? 3 : 2))
+        {
+            Fail(test, engineType, "bad program counter after the skip");
+        }
+
+        //The whole loop, long enough to be translated or fast-forwarded by the engines that can
+        engine->run(loopInstructions-1);
+        startPhases = board._processor.getPhaseCount();
+        const codeg::RunResult result = engine->run(loopInstructions*TEST_LOOP_COUNT, codeg::StopConditions{});
+        if ( (result._instructionCount != loopInstructions*TEST_LOOP_COUNT) ||
+             (board._processor.getPhaseCount()-startPhases != loopPhases*TEST_LOOP_COUNT) )
+        {
+            Fail(test, engineType, "the loop took "+std::to_string(board._processor.getPhaseCount()-startPhases)+
+                                   " phases, "+std::to_string(loopPhases*TEST_LOOP_COUNT)+" expected");
+        }
+    }
+}
+
+}//end
+
+int main()
+{
+    CheckSkip(codeg::CodegBinaryRev1::OPCODE_IF, 1, true);
+    CheckSkip(codeg::CodegBinaryRev1::OPCODE_IF, 0, false);
+    CheckSkip(codeg::CodegBinaryRev1::OPCODE_IFNOT, 0, true);
+    CheckSkip(codeg::CodegBinaryRev1::OPCODE_IFNOT, 1, false);
+
+    if (errorCount != 0)
+    {
+        std::cout << errorCount << " errors" << std::endl;
+        return 1;
+    }
+    std::cout << "no error" << std::endl;
+    return 0;
+}